@@ -2,40 +2,47 @@
 # -*- coding: utf-8 -*-
 """
 YAMLWeave - C代码自动插桩工具
+
+主要类在首次访问时才导入（PEP 562），``import code.core`` 或命令行模式
+不会连带加载tkinter等界面模块。
 """
 
 __version__ = "1.0.0"
 __author__ = "YAMLWeave Team"
 
-# 导出主要模块 - 使用相对导入
-try:
-    # 从当前包内导入核心模块
-    from .core.stub_processor import StubProcessor
-    from .ui.app_ui import YAMLWeaveUI
-    from .ui.app_controller import AppController
-    
-    # 调试日志
-    import logging
-    logging = logging.getLogger("yamlweave")
-    logging.info("成功从code包导入核心模块")
-except ImportError as e:
-    # 记录导入错误
-    import logging
-    logging = logging.getLogger("yamlweave")
-    logging.error(f"无法从code包导入核心模块: {str(e)}")
-    
-    # 尝试备用导入方式
+import importlib
+import logging
+
+# 导出名称 -> 所在子模块
+_LAZY_EXPORTS = {
+    "StubProcessor": "core.stub_processor",
+    "YAMLWeaveUI": "ui.app_ui",
+    "AppController": "ui.app_controller",
+}
+
+__all__ = list(_LAZY_EXPORTS)
+
+
+def __getattr__(name):
+    """按需导入主要模块"""
+    module_name = _LAZY_EXPORTS.get(name)
+    if module_name is None:
+        raise AttributeError(f"module {__name__!r} has no attribute {name!r}")
     try:
+        # 从当前包内导入
+        module = importlib.import_module(f".{module_name}", __name__)
+    except ImportError as e:
+        logger = logging.getLogger("yamlweave")
+        logger.error(f"无法从code包导入{name}: {str(e)}")
         # 尝试直接导入
-        from core.stub_processor import StubProcessor
-        from ui.app_ui import YAMLWeaveUI
-        from ui.app_controller import AppController
-        
-        logging.info("成功通过直接导入方式加载核心模块")
-    except ImportError as e2:
-        logging.error(f"备用导入方式也失败: {str(e2)}")
-        # 引发异常以便上层处理
-        raise
+        module = importlib.import_module(module_name)
+    value = getattr(module, name)
+    globals()[name] = value
+    return value
+
+
+def __dir__():
+    return sorted(list(globals()) + __all__)
 
 """
 YAMLWeave 包
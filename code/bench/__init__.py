@@ -0,0 +1,5 @@
+"""
+YAMLWeave 性能基准模块
+生成可复现的大规模合成C项目，测量插桩吞吐量、内存峰值、各阶段耗时和核心函数耗时；
+由执行日志历史生成实际运行的性能趋势
+"""
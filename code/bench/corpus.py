@@ -0,0 +1,225 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave 基准模块 - corpus
+按参数生成可复现的合成C项目及对应的YAML桩代码配置
+
+``main.py`` 中的示例文件只有少量演示用的小文件，不足以测量大项目上的性能。
+本模块按随机种子确定性地生成任意规模的项目：相同参数总是生成逐字节相同的文件。
+
+用法::
+
+    python -m code.bench.corpus --out DIR [--files 1000] [--lines 200] [--anchor-density 2]
+        [--gbk-ratio 0.1] [--depth 3] [--segments 500] [--missing-ratio 0.01] [--seed 1]
+"""
+
+import argparse
+import json
+import math
+import os
+import random
+import sys
+from dataclasses import asdict, dataclass
+from typing import Any, Dict, List
+
+# 生成的C文件中使用的中文注释，使GBK文件确实需要编码检测
+_COMMENTS = ("数据校验", "边界检查", "状态更新", "资源释放", "错误处理", "初始化", "日志输出", "参数转换")
+_TYPES = ("int", "long", "unsigned int", "short")
+
+
+@dataclass(frozen=True)
+class CorpusSpec:
+    """
+    合成项目参数
+
+    Attributes:
+        files: .c文件数量
+        lines: 每个文件的平均行数，实际行数按对数正态分布抽取
+        size_sigma: 文件行数对数正态分布的σ，0表示所有文件行数相同
+        anchor_density: 每100行的锚点数
+        gbk_ratio: 以GBK编码保存的文件比例，其余为UTF-8
+        depth: 目录深度，0表示所有文件在根目录下
+        fanout: 每个目录的子目录数
+        segments: YAML中的代码段数量（决定YAML文件大小）
+        segment_lines: 每个代码段的行数
+        missing_ratio: 引用YAML中不存在的代码段的锚点比例
+        seed: 随机种子
+    """
+    files: int = 1000
+    lines: int = 200
+    size_sigma: float = 0.6
+    anchor_density: float = 2.0
+    gbk_ratio: float = 0.1
+    depth: int = 3
+    fanout: int = 8
+    segments: int = 500
+    segment_lines: int = 4
+    missing_ratio: float = 0.01
+    seed: int = 1
+
+
+def _segment_key(index: int):
+    """第 ``index`` 个代码段的 (TC, STEP, segment)"""
+    return f"TC{index // 50 + 1:03d}", f"STEP{index % 50 // 10 + 1}", f"seg{index % 10 + 1}"
+
+
+def _relative_dir(index: int, spec: CorpusSpec) -> str:
+    """按文件序号确定其所在目录，文件均匀分布在最深一层目录中"""
+    parts = []
+    bucket = index
+    for level in range(spec.depth):
+        bucket, digit = divmod(bucket, spec.fanout)
+        parts.append(f"mod{level}_{digit}")
+    return os.path.join(*parts) if parts else ''
+
+
+def _file_lines(rng: random.Random, spec: CorpusSpec) -> int:
+    if spec.size_sigma <= 0:
+        return max(10, spec.lines)
+    mu = math.log(max(10, spec.lines)) - spec.size_sigma ** 2 / 2
+    return max(10, int(rng.lognormvariate(mu, spec.size_sigma)))
+
+
+def _render_file(rng: random.Random, spec: CorpusSpec, file_index: int, total_lines: int):
+    """
+    生成单个C文件的内容
+
+    Returns:
+        Tuple[str, int]: (文件内容, 锚点数)
+    """
+    lines = [
+        "/**",
+        f" * 合成测试文件 {file_index}",
+        " * 由 code.bench.corpus 生成，用于性能测试",
+        " */",
+        "",
+        "#include <stdio.h>",
+        "#include <string.h>",
+        "",
+    ]
+    anchor_probability = spec.anchor_density / 100.0
+    anchors = 0
+    func = 0
+    while len(lines) < total_lines:
+        func += 1
+        body = rng.randint(8, 30)
+        lines.append(f"/* {rng.choice(_COMMENTS)}函数 {func} */")
+        lines.append(f"{rng.choice(_TYPES)} f{file_index}_{func}(int value) {{")
+        lines.append("    int result = value;")
+        for i in range(body):
+            if rng.random() < anchor_probability:
+                if rng.random() < spec.missing_ratio:
+                    tc, step, seg = "TC999", "STEP9", f"missing{rng.randint(1, 9)}"
+                else:
+                    tc, step, seg = _segment_key(rng.randrange(spec.segments))
+                lines.append(f"    // {tc} {step} {seg}")
+                anchors += 1
+            elif i % 4 == 0:
+                lines.append(f"    // {rng.choice(_COMMENTS)}")
+            else:
+                lines.append(f"    result = result * {rng.randint(2, 9)} + {rng.randint(0, 99)};")
+        lines.append("    return result;")
+        lines.append("}")
+        lines.append("")
+    return "\n".join(lines) + "\n", anchors
+
+
+def _render_yaml(spec: CorpusSpec) -> str:
+    """生成包含 ``spec.segments`` 个代码段的YAML配置"""
+    rng = random.Random(spec.seed + 1)
+    tree: Dict[str, Dict[str, List[str]]] = {}
+    for index in range(spec.segments):
+        tc, step, seg = _segment_key(index)
+        tree.setdefault(tc, {}).setdefault(step, []).append(seg)
+    out = ["# 由 code.bench.corpus 生成的合成桩代码配置"]
+    for tc, steps in tree.items():
+        out.append(f"{tc}:")
+        for step, segments in steps.items():
+            out.append(f"  {step}:")
+            for seg in segments:
+                out.append(f"    {seg}: |")
+                for i in range(max(1, spec.segment_lines)):
+                    out.append(f"      printf(\"{tc} {step} {seg} {i}: %d\\n\", {rng.randint(0, 999)});")
+    return "\n".join(out) + "\n"
+
+
+def generate_corpus(root_dir: str, spec: CorpusSpec) -> Dict[str, Any]:
+    """
+    在 ``root_dir/src`` 下生成合成项目，YAML配置写入 ``root_dir/stubs.yaml``
+
+    YAML配置放在项目目录之外，不会被当作项目文件复制到结果目录。
+
+    Returns:
+        Dict[str, Any]: 生成结果，包括项目目录、YAML文件、文件数、总字节数和锚点数
+    """
+    rng = random.Random(spec.seed)
+    src_dir = os.path.join(root_dir, "src")
+    total_bytes = 0
+    total_anchors = 0
+    gbk_files = 0
+    for index in range(spec.files):
+        content, anchors = _render_file(rng, spec, index, _file_lines(rng, spec))
+        encoding = 'gbk' if rng.random() < spec.gbk_ratio else 'utf-8'
+        data = content.encode(encoding)
+        directory = os.path.join(src_dir, _relative_dir(index, spec))
+        os.makedirs(directory, exist_ok=True)
+        with open(os.path.join(directory, f"file{index:06d}.c"), 'wb') as f:
+            f.write(data)
+        total_bytes += len(data)
+        total_anchors += anchors
+        gbk_files += encoding == 'gbk'
+
+    yaml_file = os.path.join(root_dir, "stubs.yaml")
+    with open(yaml_file, 'w', encoding='utf-8', newline='\n') as f:
+        f.write(_render_yaml(spec))
+    return {
+        "root_dir": src_dir,
+        "yaml_file": yaml_file,
+        "files": spec.files,
+        "bytes": total_bytes,
+        "anchors": total_anchors,
+        "gbk_files": gbk_files,
+        "yaml_bytes": os.path.getsize(yaml_file),
+    }
+
+
+def spec_from_args(args) -> CorpusSpec:
+    """由命令行参数构建 :class:`CorpusSpec`（未指定的参数使用默认值）"""
+    values = {name: getattr(args, name) for name in asdict(CorpusSpec())
+              if getattr(args, name, None) is not None}
+    return CorpusSpec(**values)
+
+
+def add_spec_arguments(parser: argparse.ArgumentParser) -> None:
+    """添加合成项目参数；供基准测试的各命令行入口共用"""
+    parser.add_argument("--lines", type=int, help="每个文件的平均行数，默认200")
+    parser.add_argument("--size-sigma", dest="size_sigma", type=float, help="文件行数对数正态分布的σ，默认0.6")
+    parser.add_argument("--gbk-ratio", dest="gbk_ratio", type=float, help="GBK编码文件比例，默认0.1")
+    parser.add_argument("--depth", type=int, help="目录深度，默认3")
+    parser.add_argument("--fanout", type=int, help="每个目录的子目录数，默认8")
+    parser.add_argument("--segments", type=int, help="YAML中的代码段数量，默认500")
+    parser.add_argument("--segment-lines", dest="segment_lines", type=int, help="每个代码段的行数，默认4")
+    parser.add_argument("--missing-ratio", dest="missing_ratio", type=float,
+                        help="引用不存在代码段的锚点比例，默认0.01")
+    parser.add_argument("--seed", type=int, help="随机种子，默认1")
+
+
+def main(argv=None) -> int:
+    parser = argparse.ArgumentParser(description="生成合成C项目与YAML配置")
+    parser.add_argument("--out", required=True, help="输出目录（项目在 <out>/src，配置在 <out>/stubs.yaml）")
+    parser.add_argument("--files", type=int, help="文件数量，默认1000")
+    parser.add_argument("--anchor-density", dest="anchor_density", type=float, help="每100行的锚点数，默认2")
+    add_spec_arguments(parser)
+    args = parser.parse_args(argv)
+    if os.path.exists(args.out) and os.listdir(args.out):
+        print(f"错误: 输出目录非空: {args.out}", file=sys.stderr)
+        return 2
+    spec = spec_from_args(args)
+    summary = generate_corpus(args.out, spec)
+    summary["spec"] = asdict(spec)
+    print(json.dumps(summary, ensure_ascii=False, indent=2))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,318 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave 基准模块 - micro
+核心热点函数的微基准测试
+
+测试对象：``StubParser.parse_new_format``、``parse_traditional_format``、
+``YamlStubHandler.get_stub_code``、``detect_encoding``、``read_file``、
+插桩拼接（``process_file`` 中的 ``weave_content``，不写文件）和 ``extract_stubs_from_file``。
+
+输入取自示例目录（图形界面生成的 ``samples``，含 ``all_tests.yaml``）；
+示例目录不存在时使用 :mod:`code.bench.corpus` 生成的合成文件。
+在此基础上按 ``--scales`` 将文件内容放大若干倍，另外生成传统格式和GBK编码的变体。
+
+每个用例先预热，再自动确定每轮调用次数（每轮至少 ``--min-time`` 秒），
+重复 ``--repeat`` 轮后报告单次调用耗时的中位数、p95、最小值和平均值（微秒）。
+
+用法::
+
+    python -m code.bench.micro [--samples DIR] [--scales 1,10,100] [--repeat 20] [--filter read_file]
+        [--report micro.json]
+"""
+
+import argparse
+import json
+import os
+import platform
+import re
+import shutil
+import statistics
+import sys
+import tempfile
+import time
+from typing import Any, Callable, Dict, List, Optional, Tuple
+
+# 报告格式版本
+REPORT_VERSION = 1
+
+
+def _import_modules():
+    """导入被测模块（在配置好日志之后调用）"""
+    try:
+        from ..core.stub_parser import StubParser
+        from ..core.utils import detect_encoding, read_file
+        from ..handlers.yaml_handler import YamlStubHandler
+        from ..utils.logger import get_app_root
+        from .corpus import CorpusSpec, generate_corpus
+    except ImportError:
+        sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__)))))
+        from code.core.stub_parser import StubParser
+        from code.core.utils import detect_encoding, read_file
+        from code.handlers.yaml_handler import YamlStubHandler
+        from code.utils.logger import get_app_root
+        from code.bench.corpus import CorpusSpec, generate_corpus
+    return StubParser, detect_encoding, read_file, YamlStubHandler, get_app_root, CorpusSpec, generate_corpus
+
+
+def percentile(values: List[float], fraction: float) -> float:
+    """按线性插值计算分位数"""
+    ordered = sorted(values)
+    if len(ordered) == 1:
+        return ordered[0]
+    position = (len(ordered) - 1) * fraction
+    low = int(position)
+    high = min(low + 1, len(ordered) - 1)
+    return ordered[low] + (ordered[high] - ordered[low]) * (position - low)
+
+
+def time_function(func: Callable[[], Any], warmup: int = 3, repeat: int = 20,
+                  min_time: float = 0.005) -> Dict[str, Any]:
+    """
+    测量函数单次调用的耗时
+
+    Args:
+        func: 无参数的被测函数
+        warmup: 预热调用次数
+        repeat: 测量轮数
+        min_time: 每轮的最短耗时（秒），据此确定每轮调用次数
+
+    Returns:
+        Dict[str, Any]: 单次调用耗时统计（微秒）及轮数、每轮调用次数
+    """
+    for _ in range(warmup):
+        func()
+    number = 1
+    while True:
+        start = time.perf_counter()
+        for _ in range(number):
+            func()
+        elapsed = time.perf_counter() - start
+        if elapsed >= min_time or number >= 1 << 20:
+            break
+        number *= 2 if elapsed <= 0 else max(2, min(10, int(min_time / elapsed) + 1))
+    samples = []
+    for _ in range(repeat):
+        start = time.perf_counter()
+        for _ in range(number):
+            func()
+        samples.append((time.perf_counter() - start) / number * 1e6)
+    return {
+        "median_us": round(statistics.median(samples), 3),
+        "p95_us": round(percentile(samples, 0.95), 3),
+        "min_us": round(min(samples), 3),
+        "mean_us": round(statistics.fmean(samples), 3),
+        "repeat": repeat,
+        "number": number,
+    }
+
+
+_ANCHOR = re.compile(r'^(\s*)//\s*(TC\d+)\s+(STEP\d+)\s+(\w+)')
+
+
+def _to_traditional(lines: List[str]) -> List[str]:
+    """将新格式锚点改写为带内嵌代码的传统格式注释"""
+    out = []
+    for line in lines:
+        match = _ANCHOR.match(line)
+        if match:
+            indent, tc, step, seg = match.groups()
+            out.append(f"{indent}// {tc} {step}: {seg}")
+            out.append(f'{indent}// code: printf("{tc} {step} {seg}\\n");')
+        else:
+            out.append(line)
+    return out
+
+
+class Inputs:
+    """
+    微基准测试的输入文件
+
+    基础内容为示例目录中全部.c文件的拼接；每个放大倍数生成UTF-8、GBK、传统格式
+    和已插桩四个文件，保存在临时目录中。
+    """
+
+    def __init__(self, work_dir: str, samples_dir: Optional[str], scales: List[int], modules):
+        StubParser, _detect, read_file, YamlStubHandler, get_app_root, CorpusSpec, generate_corpus = modules
+        if samples_dir is None:
+            candidate = os.path.join(get_app_root(), "samples")
+            samples_dir = candidate if os.path.isdir(candidate) else None
+        if samples_dir is None:
+            corpus = generate_corpus(os.path.join(work_dir, "corpus"),
+                                     CorpusSpec(files=4, lines=150, gbk_ratio=0, depth=0, segments=200))
+            samples_dir, yaml_file = corpus["root_dir"], corpus["yaml_file"]
+            self.source = "synthetic"
+        else:
+            yaml_file = self._find_yaml(samples_dir)
+            self.source = samples_dir
+
+        base: List[str] = []
+        for dir_path, _dirs, files in sorted(os.walk(samples_dir)):
+            for name in sorted(files):
+                if name.lower().endswith('.c'):
+                    content, _encoding = read_file(os.path.join(dir_path, name))
+                    base.extend((content or '').splitlines())
+        if not base:
+            raise ValueError(f"示例目录中没有.c文件: {samples_dir}")
+
+        self.handler = YamlStubHandler()
+        if not yaml_file or not self.handler.load_yaml(yaml_file):
+            raise ValueError(f"无法加载示例目录中的YAML配置: {samples_dir}")
+        self.yaml_file = yaml_file
+        self.parser = StubParser(self.handler)
+        self.base_lines = len(base)
+        self.files: Dict[int, Dict[str, str]] = {}
+        for scale in scales:
+            lines = base * scale
+            paths = {
+                "utf8": self._write(work_dir, f"x{scale}_utf8.c", lines, 'utf-8'),
+                "gbk": self._write(work_dir, f"x{scale}_gbk.c", lines, 'gbk'),
+                "traditional": self._write(work_dir, f"x{scale}_trad.c", _to_traditional(lines), 'utf-8'),
+            }
+            woven, _count = self.parser.weave_content(paths["utf8"], "\n".join(lines))
+            paths["woven"] = self._write(work_dir, f"x{scale}_woven.c", (woven or "").splitlines(), 'utf-8')
+            self.files[scale] = paths
+
+    @staticmethod
+    def _find_yaml(samples_dir: str) -> Optional[str]:
+        preferred = os.path.join(samples_dir, "all_tests.yaml")
+        if os.path.isfile(preferred):
+            return preferred
+        for dir_path, _dirs, files in sorted(os.walk(samples_dir)):
+            for name in sorted(files):
+                if name.lower().endswith(('.yaml', '.yml')):
+                    return os.path.join(dir_path, name)
+        return None
+
+    @staticmethod
+    def _write(work_dir: str, name: str, lines: List[str], encoding: str) -> str:
+        path = os.path.join(work_dir, name)
+        with open(path, 'w', encoding=encoding, errors='replace', newline='\n') as f:
+            f.write("\n".join(lines) + "\n")
+        return path
+
+
+def build_cases(inputs: Inputs, modules) -> List[Tuple[str, Callable[[], Any], Dict[str, Any]]]:
+    """
+    生成全部测试用例
+
+    Returns:
+        List[Tuple[str, Callable, Dict]]: (用例名, 被测函数, 输入说明)
+    """
+    _parser_cls, detect_encoding, read_file = modules[0], modules[1], modules[2]
+    parser = inputs.parser
+    handler = inputs.handler
+    cases = []
+    for scale, paths in inputs.files.items():
+        with open(paths["utf8"], encoding='utf-8') as f:
+            content = f.read()
+        lines = content.splitlines()
+        with open(paths["traditional"], encoding='utf-8') as f:
+            traditional_lines = f.read().splitlines()
+        info = {"scale": scale, "lines": len(lines), "bytes": os.path.getsize(paths["utf8"])}
+        utf8, gbk, woven = paths["utf8"], paths["gbk"], paths["woven"]
+
+        cases.append((f"parse_new_format[x{scale}]", lambda p=utf8, l=lines: parser.parse_new_format(p, l), info))
+        cases.append((f"parse_traditional_format[x{scale}]",
+                      lambda p=paths["traditional"], l=traditional_lines: parser.parse_traditional_format(p, l),
+                      dict(info, lines=len(traditional_lines),
+                           bytes=os.path.getsize(paths["traditional"]))))
+        cases.append((f"detect_encoding[utf8,x{scale}]", lambda p=utf8: detect_encoding(p), info))
+        cases.append((f"detect_encoding[gbk,x{scale}]", lambda p=gbk: detect_encoding(p),
+                      dict(info, bytes=os.path.getsize(gbk))))
+        cases.append((f"read_file[utf8,x{scale}]", lambda p=utf8: read_file(p), info))
+        cases.append((f"read_file[gbk,x{scale}]", lambda p=gbk: read_file(p),
+                      dict(info, bytes=os.path.getsize(gbk))))
+        cases.append((f"splice[x{scale}]", lambda p=utf8, c=content: parser.weave_content(p, c), info))
+        cases.append((f"extract_stubs_from_file[x{scale}]", lambda p=woven: parser.extract_stubs_from_file(p),
+                      dict(info, bytes=os.path.getsize(woven))))
+
+    # get_stub_code：依次查找YAML中的全部代码段，报告单次查找的耗时
+    keys = [(tc, step, seg) for tc, steps in handler.stub_data.items() if isinstance(steps, dict)
+            for step, segments in steps.items() if isinstance(segments, dict) for seg in segments]
+    if keys:
+        def lookup_all(keys=keys):
+            for tc, step, seg in keys:
+                handler.get_stub_code(tc, step, seg)
+        cases.append(("get_stub_code", lookup_all, {"lookups": len(keys)}))
+    return cases
+
+
+def run(samples_dir: Optional[str] = None, scales: Optional[List[int]] = None, repeat: int = 20,
+        warmup: int = 3, min_time: float = 0.005, pattern: Optional[str] = None,
+        progress=None) -> Dict[str, Any]:
+    """
+    运行微基准测试
+
+    Args:
+        samples_dir: 示例目录，默认使用程序目录下的 ``samples``，不存在时使用合成文件
+        scales: 输入放大倍数列表，默认 ``[1, 10, 100]``
+        repeat / warmup / min_time: 见 :func:`time_function`
+        pattern: 只运行名称中包含该字符串的用例
+        progress: 可选回调，参数为一行进度文本
+
+    Returns:
+        Dict[str, Any]: 基准报告
+    """
+    modules = _import_modules()
+    work_dir = tempfile.mkdtemp(prefix="yamlweave-micro-")
+    try:
+        inputs = Inputs(work_dir, samples_dir, scales or [1, 10, 100], modules)
+        results = {}
+        for name, func, info in build_cases(inputs, modules):
+            if pattern and pattern not in name:
+                continue
+            stats = time_function(func, warmup, repeat, min_time)
+            if "lookups" in info:
+                stats["per_lookup_us"] = round(stats["median_us"] / info["lookups"], 4)
+            stats["input"] = info
+            results[name] = stats
+            if progress:
+                progress(f"{name:<40} 中位数 {stats['median_us']:>12.1f} us  p95 {stats['p95_us']:>12.1f} us")
+    finally:
+        shutil.rmtree(work_dir, ignore_errors=True)
+    return {
+        "version": REPORT_VERSION,
+        "created": time.strftime("%Y-%m-%dT%H:%M:%S"),
+        "python": platform.python_version(),
+        "platform": platform.platform(),
+        "inputs": {"source": inputs.source, "yaml": inputs.yaml_file, "base_lines": inputs.base_lines},
+        "results": results,
+    }
+
+
+def main(argv=None) -> int:
+    parser = argparse.ArgumentParser(description="YAMLWeave 核心函数微基准测试")
+    parser.add_argument("--samples", help="示例目录（含.c文件与YAML配置），默认使用程序目录下的samples")
+    parser.add_argument("--scales", default="1,10,100", help="输入放大倍数列表，默认 1,10,100")
+    parser.add_argument("--repeat", type=int, default=20, help="测量轮数，默认20")
+    parser.add_argument("--warmup", type=int, default=3, help="预热调用次数，默认3")
+    parser.add_argument("--min-time", dest="min_time", type=float, default=0.005,
+                        help="每轮最短耗时（秒），默认0.005")
+    parser.add_argument("--filter", help="只运行名称中包含该字符串的用例")
+    parser.add_argument("--report", help="JSON报告输出文件，默认输出到标准输出")
+    args = parser.parse_args(argv)
+
+    # 被测函数的日志会严重影响计时，只保留错误
+    import logging
+    logging.disable(logging.WARNING)
+    scales = [int(item) for item in args.scales.split(',') if item.strip()]
+    try:
+        report = run(args.samples, scales, args.repeat, args.warmup, args.min_time, args.filter,
+                     progress=lambda line: print(line, file=sys.stderr, flush=True))
+    except ValueError as e:
+        print(f"错误: {e}", file=sys.stderr)
+        return 2
+
+    text = json.dumps(report, ensure_ascii=False, indent=2)
+    if args.report:
+        with open(args.report, 'w', encoding='utf-8') as f:
+            f.write(text + "\n")
+        print(f"基准报告已写入: {args.report}", file=sys.stderr)
+    else:
+        print(text)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,267 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave 基准模块 - perf_check
+将新的规模基准结果与提交在仓库中的基线报告比较，任一指标超出容差时失败
+
+基线是 :mod:`code.bench.scaling` 输出的JSON报告，默认使用随本模块提交的 ``code/bench/baseline.json``
+（1000个文件、1和4个线程，适合在CI中运行；其中的 ``tolerances`` 放宽了容差以容纳不同机器间的波动）。
+更新基线时用 ``--save`` 保存重新运行的报告并替换该文件（保留原基线的 ``tolerances``）::
+
+    python -m code.cli perf-check --save code/bench/baseline.json
+
+或用规模基准重新生成（需手工补回 ``tolerances`` 字段）::
+
+    python -m code.bench.scaling --files 1000 --jobs 1,4 --repeat 3 --report code/bench/baseline.json
+
+未指定 ``--current`` 时按基线中的
+每个组合（合成项目参数 + 线程数）重新运行一次规模基准，再逐项比较：
+
+- ``throughput``：吞吐量（文件/s），越大越好
+- ``p95_latency``：单文件处理耗时的p95（ms），越小越好
+- ``peak_memory``：内存峰值，越小越好
+
+容差为相对基线的百分比，默认值见 :data:`DEFAULT_TOLERANCES`；基线报告中的
+``tolerances`` 字段和命令行 ``--tolerance`` 依次覆盖默认值。
+
+用法::
+
+    python -m code.cli perf-check [--baseline code/bench/baseline.json] [--current report.json]
+        [--tolerance throughput=15] [--repeat 3] [--save current.json] [--json]
+
+退出码：0 全部通过；1 有指标回退或组合缺失；2 参数或基线错误。
+"""
+
+import argparse
+import json
+import os
+import shutil
+import sys
+import tempfile
+from typing import Any, Dict, List, Optional, Tuple
+
+# 指标名 → (报告字段, 是否越大越好)
+METRICS = {
+    "throughput": ("files_per_second", True),
+    "p95_latency": ("p95_file_ms", False),
+    "peak_memory": ("peak_rss_bytes", False),
+}
+
+# 默认容差（相对基线的百分比）；单文件耗时p95由直方图估算，波动较大
+DEFAULT_TOLERANCES = {"throughput": 10.0, "p95_latency": 25.0, "peak_memory": 10.0}
+
+# 随仓库提交的基线报告
+DEFAULT_BASELINE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "baseline.json")
+
+# 用例名称中列出的合成项目参数（即规模基准的列表参数）
+_LABEL_FIELDS = ("files", "anchor_density", "gbk_ratio", "depth", "segments")
+
+
+def _case_key(entry: Dict[str, Any]) -> str:
+    return json.dumps({"spec": entry.get("spec"), "jobs": entry.get("jobs")}, sort_keys=True)
+
+
+def _case_label(entry: Dict[str, Any]) -> str:
+    spec = entry.get("spec") or {}
+    parts = [f"{name}={spec[name]}" for name in _LABEL_FIELDS if name in spec]
+    return " ".join(parts + [f"jobs={entry.get('jobs')}"])
+
+
+def _format_value(metric: str, value: Optional[float]) -> str:
+    if value is None:
+        return "-"
+    if metric == "peak_memory":
+        return f"{value / 1048576:.1f} MB"
+    if metric == "p95_latency":
+        return f"{value:.3f} ms"
+    return f"{value:.1f}/s"
+
+
+def resolve_tolerances(baseline: Dict[str, Any], overrides: Optional[List[str]]) -> Tuple[Dict[str, float], Optional[str]]:
+    """
+    合并默认容差、基线中的 ``tolerances`` 和命令行中的 ``指标=百分比``
+
+    Returns:
+        Tuple[Dict[str, float], Optional[str]]: (容差, 错误信息)；参数有误时容差为空
+    """
+    tolerances = dict(DEFAULT_TOLERANCES)
+    items = [(name, value) for name, value in (baseline.get("tolerances") or {}).items()]
+    for text in overrides or []:
+        name, sep, value = text.partition("=")
+        if not sep:
+            return {}, f"容差格式应为 指标=百分比: {text}"
+        items.append((name.strip(), value.strip().rstrip("%")))
+    for name, value in items:
+        if name not in METRICS:
+            return {}, f"未知指标: {name}（可用: {', '.join(METRICS)}）"
+        try:
+            tolerances[name] = float(value)
+        except (TypeError, ValueError):
+            return {}, f"容差不是数字: {name}={value}"
+    return tolerances, None
+
+
+def compare(baseline: Dict[str, Any], current: Dict[str, Any], tolerances: Dict[str, float]) -> Dict[str, Any]:
+    """
+    逐个组合、逐项指标比较两份规模基准报告
+
+    任一方缺少某项指标（例如平台不支持测量内存峰值）时该项记为 ``skipped``；
+    当前报告缺少基线中的组合或该组合运行失败时记为 ``missing`` / ``failed``，均视为不通过。
+
+    Returns:
+        Dict[str, Any]: ``ok`` 为是否全部通过，``comparisons`` 为每项比较结果
+    """
+    current_entries = {_case_key(entry): entry for entry in current.get("results", [])}
+    comparisons = []
+    for base_entry in baseline.get("results", []):
+        label = _case_label(base_entry)
+        entry = current_entries.get(_case_key(base_entry))
+        if entry is None or entry.get("exit_code") not in (0, 1):
+            comparisons.append({"case": label, "metric": None,
+                                "status": "missing" if entry is None else "failed"})
+            continue
+        for metric, (field, higher_is_better) in METRICS.items():
+            base_value, value = base_entry.get(field), entry.get(field)
+            item = {"case": label, "metric": metric, "baseline": base_value, "current": value,
+                    "tolerance_pct": tolerances[metric]}
+            if not base_value or value is None:
+                item["status"] = "skipped"
+                comparisons.append(item)
+                continue
+            change = (value - base_value) / base_value * 100.0
+            worse = -change if higher_is_better else change
+            item["change_pct"] = round(change, 2)
+            if worse > tolerances[metric]:
+                item["status"] = "regressed"
+            else:
+                # 改善幅度同样超出容差时标为提升，提示更新基线
+                item["status"] = "improved" if -worse > tolerances[metric] else "ok"
+            comparisons.append(item)
+    failed = [item for item in comparisons if item["status"] in ("regressed", "missing", "failed")]
+    return {"ok": not failed, "failures": len(failed), "comparisons": comparisons}
+
+
+_STATUS_TEXT = {"ok": "通过", "improved": "提升", "regressed": "回退", "skipped": "跳过",
+                "missing": "缺失", "failed": "运行失败"}
+
+
+def format_comparison(result: Dict[str, Any]) -> List[str]:
+    """将 :func:`compare` 的结果格式化为文本行，回退项以 ``!`` 标出"""
+    lines = []
+    width = max([len(item["case"]) for item in result["comparisons"]] + [4])
+    for item in result["comparisons"]:
+        status = _STATUS_TEXT.get(item["status"], item["status"])
+        mark = "!" if item["status"] in ("regressed", "missing", "failed") else " "
+        if item["metric"] is None:
+            lines.append(f"{mark} {item['case']:<{width}}  {status}")
+            continue
+        metric = item["metric"]
+        change = f"{item['change_pct']:+.1f}%" if "change_pct" in item else "-"
+        lines.append(f"{mark} {item['case']:<{width}}  {metric:<12} {_format_value(metric, item['baseline']):>14}"
+                     f" -> {_format_value(metric, item['current']):>14}  {change:>8}"
+                     f" (容差 {item['tolerance_pct']:g}%)  {status}")
+    if result["ok"]:
+        lines.append("性能检查通过")
+    else:
+        lines.append(f"性能检查失败: {result['failures']} 项回退或缺失")
+    return lines
+
+
+def run_current(baseline: Dict[str, Any], repeat: int, work_dir: Optional[str], progress=None) -> Dict[str, Any]:
+    """按基线中的组合重新运行规模基准，合成项目参数相同的组合共用一次生成"""
+    # 命令行入口构建参数解析器时会导入本模块，基准模块在需要时才导入
+    try:
+        from .corpus import CorpusSpec
+        from .scaling import run_sweep
+    except ImportError:
+        sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__)))))
+        from code.bench.corpus import CorpusSpec
+        from code.bench.scaling import run_sweep
+    groups: Dict[str, Tuple[Any, List[int]]] = {}
+    for entry in baseline.get("results", []):
+        key = json.dumps(entry.get("spec"), sort_keys=True)
+        if key not in groups:
+            groups[key] = (CorpusSpec(**entry.get("spec", {})), [])
+        groups[key][1].append(entry.get("jobs", 1))
+
+    directory = work_dir or tempfile.mkdtemp(prefix="yamlweave-perfcheck-")
+    os.makedirs(directory, exist_ok=True)
+    report: Dict[str, Any] = {"results": []}
+    try:
+        for spec, jobs_list in groups.values():
+            partial = run_sweep([spec], jobs_list, repeat, directory, progress)
+            results = report["results"] + partial["results"]
+            report = dict(partial, results=results)
+    finally:
+        if not work_dir:
+            shutil.rmtree(directory, ignore_errors=True)
+    return report
+
+
+def _load_json(path: str) -> Tuple[Optional[Dict[str, Any]], Optional[str]]:
+    try:
+        with open(path, 'r', encoding='utf-8') as f:
+            return json.load(f), None
+    except (OSError, ValueError) as e:
+        return None, f"无法读取基准报告 {path}: {e}"
+
+
+def add_arguments(parser: argparse.ArgumentParser) -> None:
+    """添加性能检查参数；供 ``python -m code.cli perf-check`` 与本模块共用"""
+    parser.add_argument("--baseline", default=DEFAULT_BASELINE,
+                        help="基线报告（code.bench.scaling 输出的JSON），默认为随仓库提交的 code/bench/baseline.json")
+    parser.add_argument("--current", help="与基线比较的报告；不指定时按基线中的组合重新运行")
+    parser.add_argument("--tolerance", action="append", metavar="METRIC=PCT",
+                        help="指标容差（百分比），可重复；指标为 " + ", ".join(METRICS))
+    parser.add_argument("--repeat", type=int, default=3, help="重新运行时每个组合的重复次数，取最快的一次，默认3")
+    parser.add_argument("--work-dir", help="重新运行时的工作目录，默认使用临时目录（结束后删除）")
+    parser.add_argument("--save", help="将重新运行的报告写入该文件（可作为新的基线）")
+    parser.add_argument("--json", action="store_true", help="以JSON格式输出比较结果")
+
+
+def run(args) -> int:
+    """按解析后的参数执行性能检查，返回退出码"""
+    baseline, error = _load_json(args.baseline)
+    if error:
+        print(f"错误: {error}", file=sys.stderr)
+        return 2
+    if not baseline.get("results"):
+        print(f"错误: 基线报告中没有基准结果: {args.baseline}", file=sys.stderr)
+        return 2
+    tolerances, error = resolve_tolerances(baseline, args.tolerance)
+    if error:
+        print(f"错误: {error}", file=sys.stderr)
+        return 2
+
+    if args.current:
+        current, error = _load_json(args.current)
+        if error:
+            print(f"错误: {error}", file=sys.stderr)
+            return 2
+    else:
+        current = run_current(baseline, args.repeat, args.work_dir,
+                              progress=lambda line: print(line, file=sys.stderr, flush=True))
+        if args.save:
+            # 保留基线中的容差，保存的报告可直接替换基线
+            saved = dict(current, tolerances=baseline["tolerances"]) if "tolerances" in baseline else current
+            with open(args.save, 'w', encoding='utf-8') as f:
+                f.write(json.dumps(saved, ensure_ascii=False, indent=2) + "\n")
+            print(f"基准报告已写入: {args.save}", file=sys.stderr)
+
+    result = compare(baseline, current, tolerances)
+    if args.json:
+        print(json.dumps(dict(result, tolerances=tolerances), ensure_ascii=False, indent=2))
+    else:
+        for line in format_comparison(result):
+            print(line)
+    return 0 if result["ok"] else 1
+
+
+def main(argv=None) -> int:
+    parser = argparse.ArgumentParser(description="YAMLWeave 性能回退检查")
+    add_arguments(parser)
+    return run(parser.parse_args(argv))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
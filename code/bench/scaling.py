@@ -0,0 +1,222 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave 基准模块 - scaling
+在不同规模的合成项目上运行命令行插桩，记录吞吐量、内存峰值和各阶段耗时
+
+每个参数组合先用 :mod:`code.bench.corpus` 生成项目（相同项目参数只生成一次），
+再在子进程中运行 ``python -m code.cli weave --timings --json``，
+从而单独测得每次运行的内存峰值，且不受之前运行的缓存影响。
+单文件处理耗时的p95由单文件耗时直方图估算。
+
+用法::
+
+    python -m code.bench.scaling --files 1000,10000,100000 [--jobs 1,4]
+        [--anchor-density 1,5] [--gbk-ratios 0,0.5] [--repeat 3] [--report report.json]
+
+列表参数之间取笛卡尔积；报告为JSON，未指定 ``--report`` 时输出到标准输出。
+"""
+
+import argparse
+import itertools
+import json
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+from dataclasses import asdict, replace
+from typing import Any, Dict, List, Optional, Tuple
+
+try:
+    from .corpus import CorpusSpec, add_spec_arguments, generate_corpus, spec_from_args
+    from ..core.timing import histogram_quantile
+except ImportError:
+    sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__)))))
+    from code.bench.corpus import CorpusSpec, add_spec_arguments, generate_corpus, spec_from_args
+    from code.core.timing import histogram_quantile
+
+# 报告格式版本
+REPORT_VERSION = 1
+
+# 源码根目录（code 包的上级目录）；子进程在此目录下运行，避免与标准库的 code 模块冲突
+SOURCE_ROOT = os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+
+def _parse_list(text: Optional[str], cast) -> Optional[List[Any]]:
+    if text is None:
+        return None
+    return [cast(item) for item in text.split(',') if item.strip()]
+
+
+def _run_with_rusage(command: List[str], stdout, env) -> Tuple[int, Optional[int]]:
+    """
+    运行子进程并等待其结束
+
+    Returns:
+        Tuple[int, Optional[int]]: (退出码, 内存峰值字节数)；平台不支持时内存峰值为None
+    """
+    process = subprocess.Popen(command, stdout=stdout, stderr=subprocess.DEVNULL, cwd=SOURCE_ROOT, env=env)
+    if not hasattr(os, "wait4"):
+        return process.wait(), None
+    _pid, status, rusage = os.wait4(process.pid, 0)
+    process.returncode = os.waitstatus_to_exitcode(status)
+    # Linux上 ru_maxrss 以KB为单位，macOS上以字节为单位
+    peak = rusage.ru_maxrss if sys.platform == "darwin" else rusage.ru_maxrss * 1024
+    return process.returncode, peak
+
+
+def run_weave(corpus: Dict[str, Any], jobs: int, work_dir: str) -> Dict[str, Any]:
+    """
+    在子进程中对合成项目运行一次完整插桩
+
+    Returns:
+        Dict[str, Any]: 本次运行的退出码、耗时、内存峰值与命令行输出的结果
+    """
+    output_dir = os.path.join(work_dir, "out")
+    shutil.rmtree(output_dir, ignore_errors=True)
+    command = [sys.executable, "-m", "code.cli", "weave", "--root", corpus["root_dir"],
+               "--yaml", corpus["yaml_file"], "--output", output_dir, "--jobs", str(jobs),
+               "--timings", "--json"]
+    env = dict(os.environ)
+    env["PYTHONPATH"] = SOURCE_ROOT + (os.pathsep + env["PYTHONPATH"] if env.get("PYTHONPATH") else "")
+    with tempfile.TemporaryFile(mode='w+', encoding='utf-8') as stdout:
+        start = time.perf_counter()
+        exit_code, peak_rss = _run_with_rusage(command, stdout, env)
+        wall = time.perf_counter() - start
+        stdout.seek(0)
+        try:
+            result = json.load(stdout)
+        except ValueError:
+            result = {}
+    shutil.rmtree(output_dir, ignore_errors=True)
+    return {"exit_code": exit_code, "wall_seconds": wall, "peak_rss_bytes": peak_rss, "result": result}
+
+
+def measure(corpus: Dict[str, Any], jobs: int, repeat: int, work_dir: str) -> Dict[str, Any]:
+    """重复运行 ``repeat`` 次，以耗时最短的一次计算吞吐量"""
+    runs = [run_weave(corpus, jobs, work_dir) for _ in range(max(1, repeat))]
+    best = min(runs, key=lambda run: run["wall_seconds"])
+    result = best["result"]
+    wall = best["wall_seconds"]
+    peaks = [run["peak_rss_bytes"] for run in runs if run["peak_rss_bytes"] is not None]
+    file_histogram = (result.get("timings") or {}).get("file_histogram_ms")
+    p95 = histogram_quantile(file_histogram, 0.95) if file_histogram else None
+    return {
+        "jobs": jobs,
+        "exit_code": best["exit_code"],
+        "wall_seconds": round(wall, 4),
+        "wall_seconds_all": [round(run["wall_seconds"], 4) for run in runs],
+        "elapsed_ms": result.get("elapsed_ms"),
+        "startup_ms": result.get("startup_ms"),
+        "files_per_second": round(corpus["files"] / wall, 1) if wall else None,
+        "mb_per_second": round(corpus["bytes"] / wall / 1e6, 3) if wall else None,
+        "p95_file_ms": round(p95, 3) if p95 is not None else None,
+        "peak_rss_bytes": max(peaks) if peaks else None,
+        "inserted_stubs": result.get("successful_stubs"),
+        "missing_stubs": result.get("missing_stubs"),
+        "errors": len(result.get("errors", [])),
+        "timings": result.get("timings"),
+    }
+
+
+def run_sweep(specs: List[CorpusSpec], jobs_list: List[int], repeat: int, work_dir: str,
+              progress=None) -> Dict[str, Any]:
+    """
+    依次生成各个合成项目并测量
+
+    Args:
+        specs: 合成项目参数列表
+        jobs_list: 每个项目上依次使用的线程数
+        repeat: 每个组合的重复次数
+        work_dir: 存放合成项目与结果目录的工作目录
+        progress: 可选回调，参数为一行进度文本
+
+    Returns:
+        Dict[str, Any]: 基准报告
+    """
+    results = []
+    for n, spec in enumerate(specs):
+        corpus_dir = os.path.join(work_dir, f"corpus{n}")
+        start = time.perf_counter()
+        corpus = generate_corpus(corpus_dir, spec)
+        generate_seconds = time.perf_counter() - start
+        corpus_info = {key: corpus[key] for key in ("files", "bytes", "anchors", "gbk_files", "yaml_bytes")}
+        for jobs in jobs_list:
+            entry = measure(corpus, jobs, repeat, work_dir)
+            entry["spec"] = asdict(spec)
+            entry["corpus"] = dict(corpus_info, generate_seconds=round(generate_seconds, 3))
+            results.append(entry)
+            if progress:
+                rss = entry["peak_rss_bytes"]
+                rss_text = f"{rss / 1048576:.1f} MB" if rss else "未知"
+                progress(f"files={spec.files} jobs={jobs}: {entry['files_per_second']} 文件/s, "
+                         f"{entry['mb_per_second']} MB/s, 峰值内存 {rss_text}")
+        shutil.rmtree(corpus_dir, ignore_errors=True)
+    return {
+        "version": REPORT_VERSION,
+        "created": time.strftime("%Y-%m-%dT%H:%M:%S"),
+        "python": platform.python_version(),
+        "platform": platform.platform(),
+        "cpu_count": os.cpu_count(),
+        "results": results,
+    }
+
+
+def build_specs(args) -> List[CorpusSpec]:
+    """按命令行中的列表参数生成各个合成项目参数（笛卡尔积）"""
+    # 文件数与锚点密度在此处是列表参数，不作为基础参数
+    base = spec_from_args(argparse.Namespace(**{name: value for name, value in vars(args).items()
+                                                if name not in ("files", "anchor_density")}))
+    dimensions = {
+        "files": _parse_list(args.files, int),
+        "anchor_density": _parse_list(args.anchor_density, float),
+        "gbk_ratio": _parse_list(args.gbk_ratios, float),
+        "depth": _parse_list(args.depths, int),
+        "segments": _parse_list(args.segment_counts, int),
+    }
+    dimensions = {name: values for name, values in dimensions.items() if values}
+    names = list(dimensions)
+    return [replace(base, **dict(zip(names, combo)))
+            for combo in itertools.product(*(dimensions[name] for name in names))]
+
+
+def main(argv=None) -> int:
+    parser = argparse.ArgumentParser(description="YAMLWeave 规模基准测试")
+    parser.add_argument("--files", default="1000,10000,100000", help="文件数量列表，默认 1000,10000,100000")
+    parser.add_argument("--anchor-density", dest="anchor_density", help="每100行锚点数列表")
+    parser.add_argument("--gbk-ratios", dest="gbk_ratios", help="GBK文件比例列表")
+    parser.add_argument("--depths", help="目录深度列表")
+    parser.add_argument("--segment-counts", dest="segment_counts", help="YAML代码段数量列表")
+    parser.add_argument("--jobs", default="1", help="线程数列表，默认1")
+    parser.add_argument("--repeat", type=int, default=1, help="每个组合的重复次数，取最快的一次，默认1")
+    parser.add_argument("--work-dir", help="工作目录，默认使用临时目录（结束后删除）")
+    parser.add_argument("--report", help="JSON报告输出文件，默认输出到标准输出")
+    add_spec_arguments(parser)
+    args = parser.parse_args(argv)
+
+    specs = build_specs(args)
+    jobs_list = _parse_list(args.jobs, int) or [1]
+    work_dir = args.work_dir or tempfile.mkdtemp(prefix="yamlweave-bench-")
+    os.makedirs(work_dir, exist_ok=True)
+    try:
+        report = run_sweep(specs, jobs_list, args.repeat, work_dir,
+                           progress=lambda line: print(line, file=sys.stderr, flush=True))
+    finally:
+        if not args.work_dir:
+            shutil.rmtree(work_dir, ignore_errors=True)
+
+    text = json.dumps(report, ensure_ascii=False, indent=2)
+    if args.report:
+        with open(args.report, 'w', encoding='utf-8') as f:
+            f.write(text + "\n")
+        print(f"基准报告已写入: {args.report}", file=sys.stderr)
+    else:
+        print(text)
+    return 1 if any(entry["exit_code"] not in (0, 1) for entry in report["results"]) else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,267 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave 基准模块 - trend
+由执行日志历史生成各项目逐次运行的性能趋势报告
+
+数据来自 ``save_execution_log`` 记入执行日志目录的统计信息（图形界面每次运行、
+命令行指定 ``--profile`` 时写出），按项目目录分组，列出最近 ``--last`` 次运行的：
+
+- 吞吐量：文件/s、桩点/s（需要执行日志中有阶段耗时 ``timings``）
+- 运行耗时
+- 失败率：处理失败的文件占扫描文件的比例；另统计有失败的运行占比
+
+每次运行的文件/s与同一项目之前 ``--window`` 次运行的中位数比较，
+下降超过 ``--threshold`` 百分比时标为回退。与 :mod:`code.bench.perf_check` 的合成基准互为补充，
+反映实际使用中的性能变化。
+
+用法::
+
+    python -m code.cli trend [--project DIR] [--last 20] [--threshold 20] [--window 5]
+        [--html report.html] [--json] [--fail-on-regression]
+
+退出码：0 正常；1 指定 ``--fail-on-regression`` 且某个项目最近一次运行回退。
+"""
+
+import argparse
+import contextlib
+import html
+import json
+import os
+import statistics
+import sys
+import time
+import unicodedata
+from typing import Any, Dict, List, Optional
+
+DEFAULT_LAST = 20
+DEFAULT_THRESHOLD = 20.0
+DEFAULT_WINDOW = 5
+
+
+def _number(value) -> Optional[float]:
+    try:
+        return float(value) if value is not None else None
+    except (TypeError, ValueError):
+        return None
+
+
+def run_metrics(record: Dict[str, Any]) -> Dict[str, Any]:
+    """由一条执行日志记录计算单次运行的指标；没有耗时的运行吞吐量为None"""
+    info = record.get("execution_info") or {}
+    stats = info.get("stats") or {}
+    scanned = _number(stats.get("scanned_files")) or 0.0
+    inserted = _number(stats.get("inserted_stubs")) or 0.0
+    failed = _number(stats.get("failed_files")) or 0.0
+    seconds = _number((info.get("timings") or {}).get("wall_seconds"))
+    return {
+        "time": record.get("modified_time_str"),
+        "log": record.get("file_path"),
+        "scanned_files": int(scanned),
+        "inserted_stubs": int(inserted),
+        "failed_files": int(failed),
+        "wall_seconds": seconds,
+        "files_per_second": round(scanned / seconds, 2) if seconds else None,
+        "stubs_per_second": round(inserted / seconds, 2) if seconds else None,
+        "failure_rate": round(failed / scanned, 4) if scanned else 0.0,
+    }
+
+
+def analyze(records: List[Dict[str, Any]], threshold_pct: float, window: int) -> Dict[str, Any]:
+    """
+    分析同一项目的运行记录（按时间倒序传入），按时间正序返回每次运行的指标与回退标记
+
+    Returns:
+        Dict[str, Any]: ``runs`` 为每次运行的指标，``summary`` 为汇总
+    """
+    runs = [run_metrics(record) for record in reversed(records)]
+    history: List[float] = []
+    for run in runs:
+        value = run["files_per_second"]
+        baseline = statistics.median(history[-window:]) if history else None
+        run["baseline_files_per_second"] = round(baseline, 2) if baseline else None
+        run["regressed"] = False
+        if value is not None and baseline:
+            run["change_pct"] = round((value - baseline) / baseline * 100.0, 2)
+            run["regressed"] = run["change_pct"] < -threshold_pct
+        if value is not None:
+            history.append(value)
+
+    timed = [run for run in runs if run["files_per_second"] is not None]
+    summary = {
+        "runs": len(runs),
+        "timed_runs": len(timed),
+        "failed_runs": sum(1 for run in runs if run["failed_files"]),
+        "regressed_runs": sum(1 for run in runs if run["regressed"]),
+        "latest_regressed": bool(runs) and runs[-1]["regressed"],
+    }
+    summary["failed_run_rate"] = round(summary["failed_runs"] / len(runs), 4) if runs else 0.0
+    if timed:
+        summary["median_files_per_second"] = round(statistics.median(run["files_per_second"] for run in timed), 2)
+        summary["median_stubs_per_second"] = round(statistics.median(run["stubs_per_second"] for run in timed), 2)
+        summary["median_wall_seconds"] = round(statistics.median(run["wall_seconds"] for run in timed), 6)
+    return {"runs": runs, "summary": summary}
+
+
+def build_report(last: int = DEFAULT_LAST, threshold_pct: float = DEFAULT_THRESHOLD,
+                 window: int = DEFAULT_WINDOW, project: Optional[str] = None) -> Dict[str, Any]:
+    """从执行日志目录读取各项目最近 ``last`` 次运行并分析"""
+    try:
+        from ..utils.logger import get_execution_log_projects, get_execution_logs
+    except ImportError:
+        sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__)))))
+        from code.utils.logger import get_execution_log_projects, get_execution_logs
+    projects = get_execution_log_projects()
+    if project:
+        # 执行日志中记录的是运行时传入的目录，按规范化后的路径匹配
+        key = os.path.normcase(os.path.abspath(project))
+        projects = [name for name in projects if os.path.normcase(os.path.abspath(name)) == key] or [project]
+    report: Dict[str, Any] = {"generated_at": time.strftime("%Y-%m-%d %H:%M:%S"), "last": last,
+                              "threshold_pct": threshold_pct, "window": window, "projects": {}}
+    for name in projects:
+        records = get_execution_logs(limit=last, project_dir=name)
+        if records:
+            report["projects"][name] = analyze(records, threshold_pct, window)
+    return report
+
+
+def _fmt(value: Optional[float], spec: str, suffix: str = "") -> str:
+    return "-" if value is None else f"{value:{spec}}{suffix}"
+
+
+def _row(run: Dict[str, Any]) -> List[str]:
+    change = run.get("change_pct")
+    return [run["time"] or "-", str(run["scanned_files"]), _fmt(run["files_per_second"], ".1f"),
+            _fmt(run["stubs_per_second"], ".1f"), _fmt(run["wall_seconds"], ".3f", " s"),
+            f"{run['failure_rate'] * 100:.1f}%", "-" if change is None else f"{change:+.1f}%"]
+
+
+_HEADERS = ["时间", "文件数", "文件/s", "桩点/s", "耗时", "失败率", "较基线"]
+
+
+def _pad(text: str, width: int, left: bool) -> str:
+    """按终端显示宽度（中文占两列）补齐"""
+    fill = " " * (width - _width(text))
+    return text + fill if left else fill + text
+
+
+def _width(text: str) -> int:
+    return sum(2 if unicodedata.east_asian_width(ch) in "WF" else 1 for ch in text)
+
+
+def format_text(report: Dict[str, Any]) -> List[str]:
+    """将 :func:`build_report` 的结果格式化为文本行，回退的运行以 ``!`` 标出"""
+    if not report["projects"]:
+        return ["执行日志中没有运行记录"]
+    lines = []
+    for project, analysis in report["projects"].items():
+        summary = analysis["summary"]
+        lines.append(f"项目: {project}（{summary['runs']} 次运行，有失败 {summary['failed_runs']} 次"
+                     f"（{summary['failed_run_rate'] * 100:.1f}%），回退 {summary['regressed_runs']} 次）")
+        rows = [_HEADERS] + [_row(run) for run in analysis["runs"]]
+        widths = [max(_width(row[i]) for row in rows) for i in range(len(_HEADERS))]
+        for index, row in enumerate(rows):
+            mark = "!" if index and analysis["runs"][index - 1]["regressed"] else " "
+            lines.append(f"{mark} " + "  ".join(_pad(cell, width, left=not i)
+                                               for i, (cell, width) in enumerate(zip(row, widths))))
+        if "median_files_per_second" in summary:
+            lines.append(f"  中位数: {summary['median_files_per_second']:.1f} 文件/s，"
+                         f"{summary['median_stubs_per_second']:.1f} 桩点/s，{summary['median_wall_seconds']:.3f} s")
+        else:
+            lines.append("  执行日志中没有阶段耗时，无法计算吞吐量")
+        lines.append("")
+    lines.append(f"回退判定: 文件/s 较之前 {report['window']} 次运行的中位数下降超过 {report['threshold_pct']:g}%")
+    return lines
+
+
+def _sparkline(values: List[Optional[float]], flags: List[bool], width: int = 240, height: int = 40) -> str:
+    """文件/s 的折线图（SVG），回退的运行标为红点"""
+    points = [(i, value) for i, value in enumerate(values) if value is not None]
+    if len(points) < 2:
+        return ""
+    top = max(value for _, value in points) or 1.0
+    step = width / max(1, len(values) - 1)
+
+    def xy(i, value):
+        return round(i * step, 1), round(height - 4 - (height - 8) * value / top, 1)
+
+    path = " ".join(f"{x},{y}" for x, y in (xy(i, value) for i, value in points))
+    dots = "".join(f'<circle cx="{x}" cy="{y}" r="3" fill="#d33"/>'
+                   for (i, value) in points if flags[i] for x, y in [xy(i, value)])
+    return (f'<svg width="{width}" height="{height}" viewBox="0 0 {width} {height}">'
+            f'<polyline fill="none" stroke="#36c" stroke-width="1.5" points="{path}"/>{dots}</svg>')
+
+
+def format_html(report: Dict[str, Any]) -> str:
+    """生成独立的HTML报告：每个项目一张表格和一条文件/s折线，回退的运行标红"""
+    parts = ["<!DOCTYPE html>", '<html lang="zh-CN"><head><meta charset="utf-8"><title>YAMLWeave 性能趋势</title>',
+             "<style>body{font-family:sans-serif;margin:2em}table{border-collapse:collapse;margin:.5em 0 2em}"
+             "th,td{border:1px solid #ccc;padding:2px 8px;text-align:right}td:first-child{text-align:left}"
+             "tr.regressed{background:#fdd}</style></head><body>",
+             f"<h1>YAMLWeave 性能趋势</h1><p>生成时间 {html.escape(report['generated_at'])}；每个项目最近 "
+             f"{report['last']} 次运行；文件/s 较之前 {report['window']} 次运行的中位数下降超过 "
+             f"{report['threshold_pct']:g}% 时标为回退。</p>"]
+    if not report["projects"]:
+        parts.append("<p>执行日志中没有运行记录</p>")
+    for project, analysis in report["projects"].items():
+        summary = analysis["summary"]
+        runs = analysis["runs"]
+        parts.append(f"<h2>{html.escape(project)}</h2><p>{summary['runs']} 次运行，有失败 {summary['failed_runs']} 次"
+                     f"（{summary['failed_run_rate'] * 100:.1f}%），回退 {summary['regressed_runs']} 次</p>")
+        parts.append(_sparkline([run["files_per_second"] for run in runs], [run["regressed"] for run in runs]))
+        parts.append("<table><tr>" + "".join(f"<th>{name}</th>" for name in _HEADERS) + "</tr>")
+        for run in runs:
+            css = ' class="regressed"' if run["regressed"] else ""
+            parts.append(f"<tr{css}>" + "".join(f"<td>{html.escape(cell)}</td>" for cell in _row(run)) + "</tr>")
+        parts.append("</table>")
+    parts.append("</body></html>")
+    return "\n".join(parts) + "\n"
+
+
+def add_arguments(parser: argparse.ArgumentParser) -> None:
+    """添加趋势报告参数；供 ``python -m code.cli trend`` 与本模块共用"""
+    parser.add_argument("--project", help="只报告该项目目录，默认报告执行日志中的所有项目")
+    parser.add_argument("--last", type=int, default=DEFAULT_LAST, help=f"每个项目最近的运行次数，默认{DEFAULT_LAST}")
+    parser.add_argument("--threshold", type=float, default=DEFAULT_THRESHOLD,
+                        help=f"文件/s 较基线下降超过该百分比时标为回退，默认{DEFAULT_THRESHOLD:g}")
+    parser.add_argument("--window", type=int, default=DEFAULT_WINDOW,
+                        help=f"基线取之前多少次运行的中位数，默认{DEFAULT_WINDOW}")
+    parser.add_argument("--html", metavar="FILE", help="另外写出HTML报告")
+    parser.add_argument("--json", action="store_true", help="以JSON格式输出报告")
+    parser.add_argument("--fail-on-regression", dest="fail_on_regression", action="store_true",
+                        help="某个项目最近一次运行回退时以退出码1结束")
+
+
+def run(args) -> int:
+    """按解析后的参数生成趋势报告，返回退出码"""
+    if args.last < 1 or args.window < 1:
+        print("错误: --last 与 --window 须为正整数", file=sys.stderr)
+        return 2
+    # 扫描日志目录时的进度信息输出到stderr，不混入 --json 的输出
+    with contextlib.redirect_stdout(sys.stderr):
+        report = build_report(args.last, args.threshold, args.window, args.project)
+    if args.html:
+        try:
+            with open(args.html, 'w', encoding='utf-8') as f:
+                f.write(format_html(report))
+            print(f"HTML报告已写入: {args.html}", file=sys.stderr)
+        except OSError as e:
+            print(f"错误: 无法写入HTML报告 {args.html}: {e}", file=sys.stderr)
+            return 2
+    if args.json:
+        print(json.dumps(report, ensure_ascii=False, indent=2))
+    else:
+        for line in format_text(report):
+            print(line)
+    latest_regressed = any(analysis["summary"]["latest_regressed"] for analysis in report["projects"].values())
+    return 1 if args.fail_on_regression and latest_regressed else 0
+
+
+def main(argv=None) -> int:
+    parser = argparse.ArgumentParser(description="YAMLWeave 执行历史性能趋势报告")
+    add_arguments(parser)
+    return run(parser.parse_args(argv))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,244 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave 编译器包装
+在编译时于内存中对单个翻译单元插桩，无需生成完整的插桩结果目录
+
+用法::
+
+    python -m code.cc_wrapper [--yaml FILE] [-v] <编译器> <编译参数...>
+    make -j8 CC="python -m code.cc_wrapper --yaml all_tests.yaml gcc"
+
+也可通过环境变量 ``YAMLWEAVE_YAML`` 指定YAML配置文件。
+
+- 命令行中的每个.c源文件在内存中插桩；没有插入桩代码的文件原样交给编译器
+- 插桩结果写入私有临时目录中的同名文件，并加入 ``#line`` 指令，
+  编译诊断、``__FILE__`` 和调试信息仍指向原文件及其行号
+- 源文件所在目录加入引号包含路径（gcc/clang 为 ``-iquote``，MSVC 为 ``/I``），
+  ``#include "..."`` 的查找结果不变；``-MD``/``-MMD`` 生成的依赖文件中的临时路径替换回原路径
+- YAML解析结果缓存在当前用户的运行目录中，``make -j`` 启动的各个进程共享；
+  运行目录或缓存文件不是当前用户私有时不使用缓存
+- 缺失桩代码的锚点按编译器警告的格式输出；插桩失败时不调用编译器，返回非零退出码
+
+退出码与编译器相同；包装本身出错时为1，参数错误时为2。
+"""
+
+import logging
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+from typing import Dict, List, Optional, Tuple
+
+# 带有单独参数值的编译选项，其后的参数不是源文件
+_VALUE_OPTIONS = {
+    '-o', '-MF', '-MT', '-MQ', '-I', '-iquote', '-isystem', '-idirafter', '-include',
+    '-imacros', '-x', '-D', '-U', '-L', '-l', '-Xlinker', '-Xpreprocessor', '-Xassembler',
+    '-aux-info', '--param', '-T', '-z', '-arch', '-target', '--sysroot', '-isysroot',
+}
+_DEPFILE_OPTIONS = ('-MD', '-MMD')
+
+EXIT_FAILURE = 1
+EXIT_USAGE = 2
+
+logger = logging.getLogger("yamlweave.cc")
+
+
+def _import_modules():
+    """导入插桩所需的模块（在配置好日志之后调用）"""
+    try:
+        from .core.stub_parser import StubParser
+        from .core.weave_context import FileResult
+        from .core.stub_cache import load_yaml_handler
+        from .core.utils import read_file, write_output_file
+        from .core import weave_engine
+        from .daemon import runtime_dir
+    except ImportError:
+        sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+        from code.core.stub_parser import StubParser
+        from code.core.weave_context import FileResult
+        from code.core.stub_cache import load_yaml_handler
+        from code.core.utils import read_file, write_output_file
+        from code.core import weave_engine
+        from code.daemon import runtime_dir
+    return StubParser, FileResult, load_yaml_handler, read_file, write_output_file, weave_engine, runtime_dir
+
+
+def parse_wrapper_args(argv: List[str]) -> Tuple[Optional[str], int, List[str]]:
+    """
+    拆分包装自身的选项与编译命令
+
+    Returns:
+        Tuple[Optional[str], int, List[str]]: (YAML文件, 日志详细程度, 编译命令)
+    """
+    yaml_file = os.environ.get("YAMLWEAVE_YAML") or None
+    verbosity = 0
+    i = 0
+    while i < len(argv):
+        arg = argv[i]
+        if arg == '--yaml' and i + 1 < len(argv):
+            yaml_file = argv[i + 1]
+            i += 2
+        elif arg.startswith('--yaml='):
+            yaml_file = arg.split('=', 1)[1]
+            i += 1
+        elif arg in ('-v', '--verbose'):
+            verbosity += 1
+            i += 1
+        elif arg == '--':
+            i += 1
+            break
+        else:
+            break
+    return yaml_file, verbosity, argv[i:]
+
+
+def find_sources(command: List[str]) -> List[int]:
+    """返回编译命令中C源文件参数的下标"""
+    indexes = []
+    for i in range(1, len(command)):
+        arg = command[i]
+        if arg.startswith('-') or command[i - 1] in _VALUE_OPTIONS:
+            continue
+        if arg.lower().endswith('.c') and os.path.isfile(arg):
+            indexes.append(i)
+    return indexes
+
+
+def _is_msvc(compiler: str) -> bool:
+    return os.path.splitext(os.path.basename(compiler))[0].lower() in ('cl', 'clang-cl')
+
+
+def _option_value(command: List[str], option: str) -> Optional[str]:
+    """读取 ``-o x`` 或 ``-ox`` 形式的选项值，多次出现时以最后一次为准"""
+    value = None
+    for i, arg in enumerate(command):
+        if arg == option:
+            if i + 1 < len(command):
+                value = command[i + 1]
+        elif arg.startswith(option):
+            value = arg[len(option):]
+    return value
+
+
+def _depfile_paths(command: List[str], sources: List[str]) -> List[str]:
+    """推断 ``-MD``/``-MMD`` 生成的依赖文件路径"""
+    if not any(arg in _DEPFILE_OPTIONS for arg in command):
+        return []
+    depfile = _option_value(command, '-MF')
+    if depfile:
+        return [depfile]
+    output = _option_value(command, '-o')
+    if output:
+        return [os.path.splitext(output)[0] + '.d']
+    return [os.path.splitext(os.path.basename(source))[0] + '.d' for source in sources]
+
+
+def _fix_depfiles(depfiles: List[str], replacements: Dict[str, str]) -> None:
+    """将依赖文件中的临时源文件路径替换回原路径"""
+    for depfile in depfiles:
+        try:
+            with open(depfile, 'r', encoding='utf-8', errors='surrogateescape') as f:
+                content = f.read()
+        except OSError:
+            continue
+        fixed = content
+        for tmp_path, source in replacements.items():
+            fixed = fixed.replace(tmp_path, source.replace(' ', '\\ '))
+        if fixed != content:
+            with open(depfile, 'w', encoding='utf-8', errors='surrogateescape') as f:
+                f.write(fixed)
+
+
+def weave_command(command: List[str], yaml_file: Optional[str], tmp_dir: str):
+    """
+    对编译命令中的源文件插桩，返回替换后的命令
+
+    Returns:
+        Tuple[Optional[List[str]], Dict[str, str]]: (新命令, {临时文件: 原文件})；插桩失败时新命令为None
+    """
+    (StubParser, FileResult, load_yaml_handler, read_file, write_output_file,
+     weave_engine, runtime_dir) = _import_modules()
+
+    handler = None
+    if yaml_file:
+        handler = load_yaml_handler(yaml_file, runtime_dir())
+        if handler is None:
+            print(f"yamlweave-cc: 错误: 加载YAML配置失败: {yaml_file}", file=sys.stderr)
+            return None, {}
+    parser = StubParser(handler)
+
+    new_command = list(command)
+    replacements: Dict[str, str] = {}
+    include_dirs: List[str] = []
+    for n, index in enumerate(find_sources(command)):
+        source = command[index]
+        content, encoding = read_file(source)
+        if content is None:
+            print(f"yamlweave-cc: 错误: 无法读取文件: {source}", file=sys.stderr)
+            return None, {}
+        lines = content.splitlines()
+        file_result = FileResult(source)
+        insertions = parser.collect_insertions(source, lines, file_result)
+        for entry in file_result.missing_anchors:
+            print(f"{source}:{entry['line']}: warning: 未找到锚点 {entry['anchor']} 对应的桩代码",
+                  file=sys.stderr)
+        if not insertions:
+            continue
+
+        # 每个源文件使用单独的子目录，保持文件名不变（未指定 -o 时目标文件名由其决定）
+        tmp_path = os.path.join(tmp_dir, str(n), os.path.basename(source))
+        woven = weave_engine.splice(lines, insertions, line_file=source)
+        if not write_output_file(tmp_path, "\n".join(woven) + "\n", encoding):
+            print(f"yamlweave-cc: 错误: 写入临时文件失败: {tmp_path}", file=sys.stderr)
+            return None, {}
+        new_command[index] = tmp_path
+        replacements[tmp_path] = source
+        source_dir = os.path.dirname(os.path.abspath(source))
+        if source_dir not in include_dirs:
+            include_dirs.append(source_dir)
+        logger.info("%s: 插入 %d 个桩点", source, len(insertions))
+
+    if include_dirs:
+        if _is_msvc(command[0]):
+            extra = [f"/I{d}" for d in include_dirs]
+        else:
+            extra = [arg for d in include_dirs for arg in ('-iquote', d)]
+        new_command[1:1] = extra
+    return new_command, replacements
+
+
+def main(argv=None) -> int:
+    """包装主函数"""
+    yaml_file, verbosity, command = parse_wrapper_args(list(sys.argv[1:] if argv is None else argv))
+    if not command:
+        print("用法: python -m code.cc_wrapper [--yaml FILE] [-v] <编译器> <编译参数...>", file=sys.stderr)
+        return EXIT_USAGE
+    logging.basicConfig(level=logging.INFO if verbosity else logging.WARNING,
+                        format='yamlweave-cc: %(levelname)s: %(message)s', stream=sys.stderr)
+
+    tmp_dir = tempfile.mkdtemp(prefix="yamlweave-cc-")
+    try:
+        try:
+            new_command, replacements = weave_command(command, yaml_file, tmp_dir)
+        except Exception as e:
+            print(f"yamlweave-cc: 错误: 插桩失败: {e}", file=sys.stderr)
+            return EXIT_FAILURE
+        if new_command is None:
+            return EXIT_FAILURE
+        logger.debug("执行: %s", " ".join(new_command))
+        try:
+            returncode = subprocess.call(new_command)
+        except OSError as e:
+            print(f"yamlweave-cc: 错误: 无法执行编译器 {command[0]}: {e}", file=sys.stderr)
+            return EXIT_FAILURE
+        if replacements:
+            _fix_depfiles(_depfile_paths(command, list(replacements.values())), replacements)
+        return returncode
+    finally:
+        shutil.rmtree(tmp_dir, ignore_errors=True)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
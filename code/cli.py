@@ -0,0 +1,602 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave 命令行入口
+用于CI等无界面环境的批量插桩
+
+用法::
+
+    python -m code.cli weave --root DIR [--yaml FILE] [--output DIR [--depfile]] [--jobs N] [--timings] [--trace FILE]
+        [--profile-memory] [--profile cprofile|sample] [--metrics FILE.prom [--metrics-label K=V]]
+        [--json] [--daemon] [-v]
+    python -m code.cli weave --root DIR [--yaml FILE] [--output DIR] [--depfile] --watch [--poll]
+    python -m code.cli lint --root DIR [--yaml FILE] [--jobs N] [--strict] [--json] [--daemon]
+    python -m code.cli extract --root DIR --output FILE [--daemon]
+    python -m code.cli daemon start|stop|status
+    python -m code.cli perf-check --baseline FILE [--current FILE] [--tolerance METRIC=PCT] [--json]
+    python -m code.cli trend [--project DIR] [--last N] [--threshold PCT] [--html FILE] [--json]
+
+指定 ``--daemon`` 时请求交给常驻守护进程处理（复用已解析的YAML与锚点索引），
+守护进程未运行时自动改为在本进程中处理。
+指定 ``--output`` 时写入固定的结果目录，只重写内容变化的文件，供下游增量构建使用；
+指定 ``--watch`` 时持续监视源文件与YAML配置，增量更新结果目录（默认 ``<root>_stubbed``）。
+
+与图形界面入口 ``main.py`` 不同，本模块：
+- 不导入tkinter，不生成任何示例文件
+- 只在需要时导入PyYAML（指定 ``--yaml`` 时）和chardet（遇到非UTF-8文件时）
+- 报告从启动到第一个文件处理完成的耗时，可配合 ``python -X importtime`` 分析导入开销；
+  指定 ``--timings`` 时另外报告各处理阶段的耗时，指定 ``--trace`` 时写出可在Perfetto中查看的跟踪文件，
+  指定 ``--profile-memory`` 时报告各阶段的内存峰值、留存与主要分配位置；
+  指定 ``--profile`` 时写出执行日志，并在其旁边写出 ``.pstats`` 与折叠调用栈文件；
+  指定 ``--metrics`` 时将运行统计累加写入Prometheus textfile收集器读取的 ``.prom`` 文件
+
+退出码：0 成功；1 处理中出现错误；2 参数或配置错误；130 被中断。
+"""
+
+import time
+
+_START = time.perf_counter()
+
+import argparse
+import contextlib
+import json
+import logging
+import os
+import signal
+import sys
+
+EXIT_OK = 0
+EXIT_ERRORS = 1
+EXIT_USAGE = 2
+EXIT_INTERRUPTED = 130
+
+
+def _import_core():
+    """导入核心处理模块（在配置好日志之后调用）"""
+    try:
+        from .core.stub_processor import StubProcessor
+        from .core.weave_context import CancelToken
+        from .core.utils import sync_output_tree
+    except ImportError:
+        # 以脚本方式运行时，将项目根目录加入搜索路径
+        sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+        from code.core.stub_processor import StubProcessor
+        from code.core.weave_context import CancelToken
+        from code.core.utils import sync_output_tree
+    return StubProcessor, CancelToken, sync_output_tree
+
+
+def _setup_logging(verbosity: int) -> None:
+    """命令行模式只输出到stderr，不创建日志目录"""
+    level = logging.WARNING
+    if verbosity == 1:
+        level = logging.INFO
+    elif verbosity >= 2:
+        level = logging.DEBUG
+    handler = logging.StreamHandler(sys.stderr)
+    handler.setFormatter(logging.Formatter('%(levelname)s: %(message)s'))
+    root = logging.getLogger()
+    for existing in root.handlers[:]:
+        root.removeHandler(existing)
+    root.addHandler(handler)
+    root.setLevel(level)
+
+
+def _import_daemon():
+    """导入守护进程模块（客户端部分只依赖标准库）"""
+    try:
+        from . import daemon
+    except ImportError:
+        sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+        from code import daemon
+    return daemon
+
+
+def _import_perf_check():
+    """导入性能检查模块（只依赖标准库和基准模块）"""
+    try:
+        from .bench import perf_check
+    except ImportError:
+        sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+        from code.bench import perf_check
+    return perf_check
+
+
+def _import_trend():
+    """导入趋势报告模块（执行日志模块在生成报告时才导入）"""
+    try:
+        from .bench import trend
+    except ImportError:
+        sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+        from code.bench import trend
+    return trend
+
+
+def _import_metrics():
+    """导入Prometheus指标模块（只依赖标准库）"""
+    try:
+        from .core import metrics
+    except ImportError:
+        sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+        from code.core import metrics
+    return metrics
+
+
+def _delegate(args, op: str, **params):
+    """
+    在指定 ``--daemon`` 时把请求交给守护进程
+
+    Returns:
+        Optional[Dict]: 守护进程的响应；未指定或守护进程未运行时返回None
+    """
+    if not getattr(args, "daemon", False):
+        return None
+    response = _import_daemon().send_request(op, args.address, **params)
+    if response is None:
+        print("警告: 守护进程未运行，改为在本进程中处理", file=sys.stderr)
+    return response
+
+
+def build_parser(argv=None) -> argparse.ArgumentParser:
+    """
+    构建命令行参数解析器
+
+    ``perf-check`` 与 ``trend`` 的参数由基准模块定义；只在命令行中出现对应子命令时才导入，
+    其他子命令的启动不付出导入开销。
+    """
+    requested = set(sys.argv[1:] if argv is None else argv)
+    parser = argparse.ArgumentParser(prog="yamlweave", description="YAMLWeave C代码插桩工具（命令行模式）")
+    subparsers = parser.add_subparsers(dest="command")
+
+    common = argparse.ArgumentParser(add_help=False)
+    common.add_argument("--daemon", action="store_true", help="交给常驻守护进程处理")
+    common.add_argument("--address", help="守护进程地址，默认使用当前用户的本机套接字")
+    common.add_argument("-v", "--verbose", action="count", default=0, help="输出更详细的日志，可重复")
+
+    weave = subparsers.add_parser("weave", parents=[common], help="扫描目录并插入桩代码")
+    weave.add_argument("--root", required=True, help="项目根目录")
+    weave.add_argument("--yaml", help="YAML桩代码配置文件；不指定时只处理传统格式注释")
+    weave.add_argument("--output", help="固定的结果目录，跨运行复用，只重写内容变化的文件；"
+                                        "默认每次写入新的 <root>_stubbed_<时间戳> 目录")
+    weave.add_argument("--depfile", action="store_true",
+                       help="在结果目录的 .yamlweave 中为每个结果文件写出Make/Ninja依赖文件和代码段指纹")
+    weave.add_argument("--jobs", type=int, default=1, help="并行处理文件的线程数，默认1")
+    weave.add_argument("--timings", action="store_true",
+                       help="统计各处理阶段（读取、编码检测、扫描、查找、生成、写入等）的耗时")
+    weave.add_argument("--trace", metavar="FILE",
+                       help="将每个文件及各处理阶段的起止时间按线程写入Chrome Trace JSON文件（可用Perfetto打开）")
+    weave.add_argument("--profile-memory", dest="profile_memory", action="store_true",
+                       help="用tracemalloc统计各阶段（加载配置、处理文件、复制等）的内存峰值、留存与主要分配位置；"
+                            "处理明显变慢")
+    weave.add_argument("--profile", choices=["cprofile", "sample"],
+                       help="CPU分析：cprofile 写出 .pstats 与折叠调用栈，sample 定时采样各线程调用栈、只写出折叠调用栈；"
+                            "结果与执行日志一起写入日志目录")
+    weave.add_argument("--profile-interval", dest="profile_interval", type=float, default=5.0,
+                       help="采样模式的采样间隔（毫秒），默认5")
+    weave.add_argument("--metrics", metavar="FILE",
+                       help="将运行统计（文件数、桩代码数、缺失锚点、错误、读写字节数、单文件耗时直方图等）"
+                            "累加写入Prometheus文本格式的 .prom 文件，供node_exporter的textfile收集器读取")
+    weave.add_argument("--metrics-label", dest="metrics_labels", action="append", metavar="K=V",
+                       help="指标的附加标签，可重复；默认只有 project=<项目目录名>")
+    weave.add_argument("--json", action="store_true", help="以JSON格式输出结果")
+    weave.add_argument("--watch", action="store_true",
+                       help="持续监视源文件与YAML配置，增量更新结果目录（默认 <root>_stubbed）")
+    weave.add_argument("--poll", action="store_true", help="监视模式下使用轮询代替inotify")
+
+    lint = subparsers.add_parser("lint", parents=[common],
+                                 help="只扫描源文件与YAML，检查缺失锚点、格式错误的锚点和未引用的代码段，不写出文件")
+    lint.add_argument("--root", required=True, help="项目根目录")
+    lint.add_argument("--yaml", help="YAML桩代码配置文件")
+    lint.add_argument("--jobs", type=int, default=1, help="并行读取文件的线程数，默认1")
+    lint.add_argument("--strict", action="store_true", help="有未引用的代码段时同样以退出码1结束")
+    lint.add_argument("--json", action="store_true", help="以JSON格式输出结果")
+
+    extract = subparsers.add_parser("extract", parents=[common], help="从已插桩的代码反向生成YAML")
+    extract.add_argument("--root", required=True, help="已插桩的项目目录")
+    extract.add_argument("--output", required=True, help="输出的YAML文件")
+
+    daemon = subparsers.add_parser("daemon", help="管理常驻守护进程")
+    daemon.add_argument("action", choices=["start", "stop", "status"],
+                        help="start: 在前台启动; stop: 停止; status: 查看状态")
+    daemon.add_argument("--address", help="守护进程地址")
+    daemon.add_argument("-v", "--verbose", action="count", default=0, help="输出更详细的日志，可重复")
+
+    perf_check = subparsers.add_parser("perf-check", help="与基线报告比较规模基准结果，性能回退时失败")
+    if "perf-check" in requested:
+        _import_perf_check().add_arguments(perf_check)
+    perf_check.add_argument("-v", "--verbose", action="count", default=0, help="输出更详细的日志，可重复")
+
+    trend = subparsers.add_parser("trend", help="由执行日志历史生成各项目逐次运行的性能趋势，标出吞吐量回退")
+    if "trend" in requested:
+        _import_trend().add_arguments(trend)
+    trend.add_argument("-v", "--verbose", action="count", default=0, help="输出更详细的日志，可重复")
+    return parser
+
+
+def cmd_weave(args) -> int:
+    """执行 ``weave`` 子命令"""
+    root_dir = os.path.abspath(args.root)
+    if not os.path.isdir(root_dir):
+        print(f"错误: 目录不存在: {root_dir}", file=sys.stderr)
+        return EXIT_USAGE
+    if args.yaml and not os.path.isfile(args.yaml):
+        print(f"错误: YAML配置文件不存在: {args.yaml}", file=sys.stderr)
+        return EXIT_USAGE
+    yaml_file = os.path.abspath(args.yaml) if args.yaml else None
+    output_dir = os.path.abspath(args.output) if args.output else None
+    if output_dir and not _separate_dirs(root_dir, output_dir):
+        print(f"错误: 结果目录不能与项目目录相同或互相包含: {output_dir}", file=sys.stderr)
+        return EXIT_USAGE
+    if args.watch:
+        # 监视模式按批次增量处理，没有单次运行的计时、跟踪与分析结果可输出
+        rejected = [flag for flag, value in (("--timings", args.timings), ("--trace", args.trace),
+                                             ("--metrics", args.metrics), ("--profile", args.profile),
+                                             ("--profile-memory", args.profile_memory)) if value]
+        if rejected:
+            print(f"错误: --watch 不能与 {', '.join(rejected)} 同时使用", file=sys.stderr)
+            return EXIT_USAGE
+        return cmd_watch(args, root_dir, yaml_file, output_dir or f"{root_dir}_stubbed")
+    metrics_labels = _metrics_labels(root_dir, args.metrics_labels) if args.metrics else None
+    if args.metrics and metrics_labels is None:
+        return EXIT_USAGE
+    if (args.profile_memory or args.profile) and args.daemon:
+        print("警告: 内存分析与CPU分析只能在本进程中进行，忽略 --daemon", file=sys.stderr)
+        args.daemon = False
+
+    response = _delegate(args, "weave", root=root_dir, yaml=yaml_file, jobs=args.jobs, output=output_dir,
+                         depfile=args.depfile, timings=args.timings or bool(args.metrics),
+                         trace=os.path.abspath(args.trace) if args.trace else None)
+    if response is not None:
+        if not response.get("ok"):
+            print(f"错误: {response.get('error')}", file=sys.stderr)
+            return EXIT_USAGE
+        result = response["result"]
+        if args.metrics:
+            _write_metrics(args.metrics, result, metrics_labels)
+            if not args.timings:
+                result.pop("timings", None)
+        result["elapsed_ms"] = round((time.perf_counter() - _START) * 1000, 1)
+        result["startup_ms"] = None
+        _output(args, result)
+        return EXIT_ERRORS if result.get("errors") else EXIT_OK
+
+    StubProcessor, CancelToken, sync_output_tree = _import_core()
+    try:
+        from .core import timing
+    except ImportError:
+        from code.core import timing
+    memory = None
+    if args.profile_memory:
+        # 内存分析模块会导入tracemalloc，只在指定时导入
+        try:
+            from .core.memprofile import MemoryProfiler
+        except ImportError:
+            from code.core.memprofile import MemoryProfiler
+        memory = MemoryProfiler()
+        memory.start()
+    profiler = None
+    if args.profile:
+        try:
+            from .core.profiler import CpuProfiler
+        except ImportError:
+            from code.core.profiler import CpuProfiler
+        profiler = CpuProfiler(args.profile, args.profile_interval / 1000.0)
+        profiler.start()
+    processor = StubProcessor(project_dir=root_dir)
+    with memory.phase('yaml') if memory is not None else contextlib.nullcontext():
+        loaded = not yaml_file or processor.set_yaml_file(yaml_file)
+    if not loaded:
+        if profiler is not None:
+            profiler.stop()
+        print(f"错误: 加载YAML配置失败: {args.yaml}", file=sys.stderr)
+        return EXIT_USAGE
+    tracer = None
+    if args.trace:
+        try:
+            from .core.trace import TraceRecorder
+        except ImportError:
+            from code.core.trace import TraceRecorder
+        tracer = TraceRecorder()
+    timer = timing.PhaseTimer(tracer, memory) if args.timings or args.metrics or tracer or memory else None
+
+    # Ctrl+C 请求取消，当前文件完成后停止；再次按下则立即退出
+    token = CancelToken()
+
+    def _on_interrupt(signum, frame):
+        signal.signal(signal.SIGINT, signal.default_int_handler)
+        print("正在取消，再次按 Ctrl+C 立即退出...", file=sys.stderr)
+        token.cancel()
+
+    previous_handler = signal.signal(signal.SIGINT, _on_interrupt)
+
+    first_file = []
+
+    def _on_file(file_path, updated):
+        if not first_file:
+            first_file.append(time.perf_counter())
+
+    try:
+        result = processor.process_directory(root_dir, callback=_on_file, stubbed_dir=output_dir,
+                                             max_workers=args.jobs, cancel_token=token,
+                                             create_sample=False, incremental=bool(output_dir),
+                                             depfiles=args.depfile, timer=timer)
+    finally:
+        signal.signal(signal.SIGINT, previous_handler)
+
+    # 先写入插桩结果，再补齐其余文件，使结果目录是完整的项目副本
+    stubbed_dir = result.get("stubbed_dir")
+    if stubbed_dir:
+        with timing.measure(timer, 'copy'):
+            sync_output_tree(root_dir, stubbed_dir, incremental=bool(output_dir))
+    if timer is not None:
+        timer.stop()
+        result["timings"] = timer.to_dict()
+    if args.metrics:
+        _write_metrics(args.metrics, result, metrics_labels)
+    if timer is not None and not args.timings:
+        result.pop("timings")
+    if memory is not None:
+        memory.stop()
+        result["memory"] = memory.to_dict()
+    if profiler is not None:
+        profiler.stop()
+        result["execution_log"] = _save_profile_log(root_dir, result, profiler)
+    if tracer is not None and not tracer.write(args.trace):
+        print(f"错误: 写出跟踪文件失败: {args.trace}", file=sys.stderr)
+
+    elapsed_ms = (time.perf_counter() - _START) * 1000
+    startup_ms = (first_file[0] - _START) * 1000 if first_file else None
+    result["elapsed_ms"] = round(elapsed_ms, 1)
+    result["startup_ms"] = round(startup_ms, 1) if startup_ms is not None else None
+    result.pop("backup_dir", None)
+
+    _output(args, result)
+
+    if result.get("cancelled"):
+        return EXIT_INTERRUPTED
+    return EXIT_ERRORS if result.get("errors") else EXIT_OK
+
+
+def _save_profile_log(root_dir: str, result, profiler):
+    """CPU分析时写出执行日志，分析结果写在执行日志旁边；返回执行日志路径"""
+    try:
+        from .utils.logger import execution_stats, save_execution_log
+    except ImportError:
+        from code.utils.logger import execution_stats, save_execution_log
+    # 执行日志的进度信息输出到stderr，不混入 --json 的输出
+    with contextlib.redirect_stdout(sys.stderr):
+        log_path = save_execution_log(execution_stats(result), root_dir, None, result.get("stubbed_dir"),
+                                      timings=result.get("timings"), memory=result.get("memory"),
+                                      profiler=profiler)
+    if log_path:
+        stem = os.path.splitext(log_path)[0]
+        print(f"性能分析结果: {stem}.pstats / {stem}.collapsed" if profiler.mode == "cprofile"
+              else f"性能分析结果: {stem}.collapsed", file=sys.stderr)
+    return log_path
+
+
+def _metrics_labels(root_dir: str, items):
+    """解析 ``--metrics-label K=V``，返回指标标签；参数有误时输出错误并返回None"""
+    valid_label_name = _import_metrics().valid_label_name
+    labels = {"project": os.path.basename(root_dir)}
+    for text in items or []:
+        name, sep, value = text.partition("=")
+        name = name.strip()
+        if not sep or not valid_label_name(name):
+            print(f"错误: 指标标签格式应为 名称=值，名称只能包含字母、数字和下划线: {text}", file=sys.stderr)
+            return None
+        labels[name] = value
+    return labels
+
+
+def _write_metrics(path: str, result, labels) -> None:
+    """写出Prometheus指标；写入失败只输出警告，不影响退出码"""
+    if not _import_metrics().write_metrics(os.path.abspath(path), result, labels):
+        print(f"警告: 写出运行指标失败: {path}", file=sys.stderr)
+
+
+def _separate_dirs(root_dir: str, output_dir: str) -> bool:
+    """结果目录与项目目录互不包含（固定结果目录会删除项目中不存在的文件）"""
+    root = os.path.normcase(os.path.realpath(root_dir))
+    output = os.path.normcase(os.path.realpath(output_dir))
+    return os.path.commonpath([root, output]) not in (root, output)
+
+
+def cmd_watch(args, root_dir: str, yaml_file, output_dir: str) -> int:
+    """``weave --watch``：持续增量更新固定的结果目录，Ctrl+C 停止"""
+    StubProcessor, CancelToken, _sync_output_tree = _import_core()
+    try:
+        from .core.watcher import WeaveWatcher, create_backend
+    except ImportError:
+        from code.core.watcher import WeaveWatcher, create_backend
+    processor = StubProcessor(project_dir=root_dir)
+    if yaml_file and not processor.set_yaml_file(yaml_file):
+        print(f"错误: 加载YAML配置失败: {args.yaml}", file=sys.stderr)
+        return EXIT_USAGE
+
+    def _on_batch(summary):
+        if args.json:
+            print(json.dumps(summary, ensure_ascii=False), flush=True)
+            return
+        latency = summary.get("latency_ms", summary["elapsed_ms"])
+        print(f"已更新 {len(summary['updated_files'])} 个文件，删除 {len(summary['removed_files'])} 个"
+              f"，插入桩点 {summary['successful_stubs']} 个 ({latency:.1f} ms)", flush=True)
+        for entry in summary["missing_anchor_details"]:
+            print(f"  缺失桩代码: {entry.get('file')} 第 {entry.get('line')} 行: {entry.get('anchor')}")
+        for error in summary["errors"]:
+            print(f"错误: {error.get('file')}: {error.get('error')}", file=sys.stderr)
+
+    backend = create_backend(use_inotify=False if args.poll else None)
+    watcher = WeaveWatcher(processor, root_dir, output_dir, yaml_file, max_workers=args.jobs,
+                           backend=backend, depfiles=args.depfile, callback=_on_batch)
+    token = CancelToken()
+    previous_handler = signal.signal(signal.SIGINT, lambda signum, frame: token.cancel())
+    print(f"正在监视 {root_dir} ({backend.name})，结果目录: {output_dir}，按 Ctrl+C 停止", file=sys.stderr)
+    try:
+        watcher.run(token)
+    finally:
+        signal.signal(signal.SIGINT, previous_handler)
+    return EXIT_OK
+
+
+def cmd_lint(args) -> int:
+    """执行 ``lint`` 子命令：有缺失锚点、格式错误的锚点或错误时返回非零退出码"""
+    root_dir = os.path.abspath(args.root)
+    yaml_file = os.path.abspath(args.yaml) if args.yaml else None
+    response = _delegate(args, "lint", root=root_dir, yaml=yaml_file, jobs=args.jobs)
+    if response is None:
+        StubProcessor = _import_core()[0]
+        processor = StubProcessor(project_dir=root_dir)
+        if yaml_file and not processor.set_yaml_file(yaml_file):
+            print(f"错误: 加载YAML配置失败: {args.yaml}", file=sys.stderr)
+            return EXIT_USAGE
+        response = {"ok": True, "result": processor.check_directory(root_dir, max_workers=args.jobs)}
+    if not response.get("ok"):
+        print(f"错误: {response.get('error')}", file=sys.stderr)
+        return EXIT_USAGE
+
+    result = response["result"]
+    result["elapsed_ms"] = round((time.perf_counter() - _START) * 1000, 1)
+    if args.json:
+        print(json.dumps(result, ensure_ascii=False, indent=2))
+    else:
+        _print_lint_summary(result)
+    failed = result.get("missing_stubs") or result.get("malformed_anchors") or result.get("errors")
+    if args.strict and result.get("unused_segments"):
+        failed = True
+    return EXIT_ERRORS if failed else EXIT_OK
+
+
+def _print_lint_summary(result) -> None:
+    """输出锚点检查结果"""
+    text = f"文件总数: {result['total_files']}，锚点: {result.get('anchors', 0)}"
+    if result.get("traditional_anchors"):
+        text += f"，传统格式锚点: {result['traditional_anchors']}"
+    print(text)
+    if result.get("missing_stubs"):
+        print(f"缺失桩代码锚点: {result['missing_stubs']}")
+        for entry in result.get("missing_anchor_details", []):
+            print(f"  {entry.get('file')} 第 {entry.get('line')} 行: {entry.get('anchor')}")
+    if result.get("malformed_anchors"):
+        print(f"格式错误的锚点（少于三部分）: {len(result['malformed_anchors'])}")
+        for entry in result["malformed_anchors"]:
+            print(f"  {entry.get('file')} 第 {entry.get('line')} 行: {entry.get('anchor')}")
+    if result.get("unused_segments"):
+        print(f"未被任何锚点引用的代码段: {len(result['unused_segments'])}")
+        for key in result["unused_segments"]:
+            print(f"  {key}")
+    if result.get("files_without_anchors"):
+        print(f"没有锚点的文件: {len(result['files_without_anchors'])}")
+    for error in result.get("errors", []):
+        print(f"错误: {error.get('file')}: {error.get('error')}")
+    print(f"总耗时: {result['elapsed_ms']:.1f} ms")
+
+
+def cmd_extract(args) -> int:
+    """执行 ``extract`` 子命令"""
+    root_dir = os.path.abspath(args.root)
+    output = os.path.abspath(args.output)
+    response = _delegate(args, "extract", root=root_dir, output=output)
+    if response is None:
+        StubProcessor = _import_core()[0]
+        success = StubProcessor(project_dir=root_dir).extract_to_yaml(root_dir, output)
+        response = {"ok": success, "error": f"导出YAML失败: {output}"}
+    if not response.get("ok"):
+        print(f"错误: {response.get('error')}", file=sys.stderr)
+        return EXIT_ERRORS
+    print(f"已导出YAML: {output}")
+    return EXIT_OK
+
+
+def cmd_daemon(args) -> int:
+    """执行 ``daemon`` 子命令"""
+    daemon = _import_daemon()
+    if args.action == "start":
+        return daemon.WeaveDaemon(args.address).serve()
+    if args.action == "stop":
+        response = daemon.send_request("shutdown", args.address)
+        print("守护进程已停止" if response is not None else "守护进程未运行")
+        return EXIT_OK
+    response = daemon.send_request("ping", args.address)
+    if response is None:
+        print("守护进程未运行")
+        return EXIT_ERRORS
+    print(json.dumps(response, ensure_ascii=False, indent=2))
+    return EXIT_OK
+
+
+def cmd_perf_check(args) -> int:
+    """执行 ``perf-check`` 子命令：任一指标超出容差时返回非零退出码"""
+    return _import_perf_check().run(args)
+
+
+def cmd_trend(args) -> int:
+    """执行 ``trend`` 子命令：指定 ``--fail-on-regression`` 且最近一次运行回退时返回非零退出码"""
+    return _import_trend().run(args)
+
+
+def _output(args, result) -> None:
+    """按 ``--json`` 选项输出结果"""
+    if getattr(args, "json", False):
+        print(json.dumps(result, ensure_ascii=False, indent=2))
+    else:
+        _print_summary(result)
+
+
+def _print_summary(result) -> None:
+    """输出文本格式的结果摘要"""
+    print(f"文件总数: {result['total_files']}")
+    print(f"处理成功文件: {result['processed_files']}")
+    print(f"成功插入桩点: {result['successful_stubs']}")
+    if result.get("missing_stubs"):
+        print(f"缺失桩代码锚点: {result['missing_stubs']}")
+        for entry in result.get("missing_anchor_details", []):
+            print(f"  {entry.get('file')} 第 {entry.get('line')} 行: {entry.get('anchor')}")
+    for error in result.get("errors", []):
+        print(f"错误: {error.get('file')}: {error.get('error')}")
+    if result.get("cancelled"):
+        print(f"已取消: 未处理 {len(result.get('unprocessed_files', []))} 个文件")
+    if result.get("stubbed_dir"):
+        print(f"处理结果目录: {result['stubbed_dir']}")
+    if result.get("startup_ms") is not None:
+        print(f"启动耗时(至首个文件): {result['startup_ms']:.1f} ms")
+    if result.get("timings"):
+        try:
+            from .core.timing import format_timings
+        except ImportError:
+            from code.core.timing import format_timings
+        print("阶段耗时:")
+        for line in format_timings(result["timings"])[1:]:
+            print(line)
+    if result.get("memory"):
+        try:
+            from .core.memprofile import format_memory
+        except ImportError:
+            from code.core.memprofile import format_memory
+        print("内存分析:")
+        for line in format_memory(result["memory"]):
+            print(f"  {line}")
+    print(f"总耗时: {result['elapsed_ms']:.1f} ms")
+
+
+def main(argv=None) -> int:
+    """命令行主函数"""
+    parser = build_parser(argv)
+    args = parser.parse_args(argv)
+    if args.command is None:
+        parser.print_help()
+        return EXIT_USAGE
+    _setup_logging(getattr(args, "verbose", 0))
+    commands = {
+        "weave": cmd_weave,
+        "lint": cmd_lint,
+        "extract": cmd_extract,
+        "daemon": cmd_daemon,
+        "perf-check": cmd_perf_check,
+        "trend": cmd_trend,
+    }
+    return commands[args.command](args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -2,5 +2,10 @@
 
 __version__ = "1.0.0"
 
-# 使得对导入的模块更易于访问
-from code.core.stub_processor import StubProcessor 
\ No newline at end of file
+
+def __getattr__(name):
+    """使得对导入的模块更易于访问，StubProcessor在首次访问时才导入"""
+    if name == "StubProcessor":
+        from code.core.stub_processor import StubProcessor
+        return StubProcessor
+    raise AttributeError(f"module {__name__!r} has no attribute {name!r}")
@@ -0,0 +1,134 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave Core 模块 - anchor_index
+源文件锚点索引
+
+按文件签名（修改时间与大小）记录每个文件上次的处理结果：
+
+- 没有任何插入也没有缺失锚点的文件，插桩结果必然与原文件相同，
+  与YAML配置是否变化无关，签名未变时无需读取和扫描
+- 其余文件的结果取决于YAML配置，条目同时记录当时的配置状态
+  （``stub_data`` 与 ``templates`` 对象），配置重新加载后失效；
+  这类文件只在结果目录固定（增量模式）且结果文件签名与上次写出时一致时复用，
+  既不读取源文件，也不重写结果文件
+
+索引只在长期运行的进程（如守护进程）中跨多次运行复用；
+字典的单次读写在CPython中是原子的，工作线程可并发访问。
+"""
+
+import os
+from typing import Any, Dict, FrozenSet, NamedTuple, Optional, Tuple
+
+# 文件签名：(修改时间ns, 字节数)
+Signature = Tuple[int, int]
+
+
+def yaml_state(yaml_handler: Any) -> Tuple[Any, Any]:
+    """
+    返回YAML处理器的配置状态
+
+    处理器重新加载时整体替换 ``stub_data`` 与 ``templates``，
+    因此按对象身份比较即可判断配置是否变化。
+    """
+    return (getattr(yaml_handler, 'stub_data', None), getattr(yaml_handler, 'templates', None))
+
+
+class IndexEntry(NamedTuple):
+    """
+    索引条目
+
+    ``state`` 为None表示结果与YAML配置无关；``output`` 为结果文件路径及其在上次写出
+    （或确认无需更新）后的签名，未记录时为None。
+    """
+    signature: Signature
+    has_anchors: bool
+    inserted: int = 0
+    missing_anchors: Tuple[Dict[str, Any], ...] = ()
+    anchor_keys: FrozenSet[Tuple[str, str, str]] = frozenset()
+    state: Optional[Tuple[Any, Any]] = None
+    output: Optional[Tuple[str, Signature]] = None
+
+
+class AnchorIndex:
+    """按文件签名缓存各文件的处理结果"""
+
+    def __init__(self):
+        self._entries: Dict[str, IndexEntry] = {}
+        self.hits = 0
+        self.misses = 0
+
+    def __len__(self) -> int:
+        return len(self._entries)
+
+    @staticmethod
+    def signature(file_path: str) -> Optional[Signature]:
+        """读取文件签名，文件不可访问时返回None"""
+        try:
+            st = os.stat(file_path)
+        except OSError:
+            return None
+        return st.st_mtime_ns, st.st_size
+
+    def get(self, file_path: str, signature: Optional[Signature],
+            state: Optional[Tuple[Any, Any]] = None,
+            output_path: Optional[str] = None) -> Optional[IndexEntry]:
+        """
+        返回可复用的索引条目，否则返回None并丢弃过期条目
+
+        Args:
+            file_path: 源文件路径
+            signature: 源文件当前签名
+            state: 本次运行的YAML配置状态（见 :func:`yaml_state`）
+            output_path: 固定结果目录中的结果文件路径；未指定时只复用与配置无关的条目
+        """
+        entry = self._entries.get(file_path)
+        if entry is not None and signature is not None and entry.signature == signature:
+            if entry.state is None:
+                self.hits += 1
+                return entry
+            if (state is not None and all(a is b for a, b in zip(entry.state, state))
+                    and self.output_current(entry, output_path)):
+                self.hits += 1
+                return entry
+        if entry is not None:
+            self._entries.pop(file_path, None)
+        self.misses += 1
+        return None
+
+    def put(self, file_path: str, signature: Optional[Signature], has_anchors: bool,
+            inserted: int = 0, missing_anchors=(), anchor_keys: FrozenSet = frozenset(),
+            state: Optional[Tuple[Any, Any]] = None) -> None:
+        """
+        记录一个文件的处理结果
+
+        有插入或缺失锚点的文件必须给出 ``state``，否则不记录。
+        """
+        if signature is None or ((inserted or missing_anchors) and state is None):
+            return
+        self._entries[file_path] = IndexEntry(signature, has_anchors, inserted, tuple(missing_anchors),
+                                              frozenset(anchor_keys),
+                                              state if inserted or missing_anchors else None)
+
+    @classmethod
+    def output_current(cls, entry: IndexEntry, output_path: Optional[str]) -> bool:
+        """结果文件是否仍是条目记录的、上次写出的文件"""
+        if output_path is None or entry.output is None or entry.output[0] != output_path:
+            return False
+        return cls.signature(output_path) == entry.output[1]
+
+    def set_output(self, file_path: str, output_path: str) -> None:
+        """结果文件写出（或确认无需更新）后记录其路径与签名"""
+        entry = self._entries.get(file_path)
+        signature = self.signature(output_path)
+        if entry is not None and signature is not None:
+            self._entries[file_path] = entry._replace(output=(output_path, signature))
+
+    def discard(self, file_path: str) -> None:
+        """移除文件的索引条目"""
+        self._entries.pop(file_path, None)
+
+    def clear(self) -> None:
+        """清空索引"""
+        self._entries.clear()
+        self.hits = self.misses = 0
@@ -0,0 +1,113 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave Core 模块 - depfile
+为每个插桩结果文件生成 Make/Ninja 依赖文件
+
+结果目录下的 ``.yamlweave`` 目录保存：
+
+- ``fp/<TC>/<STEP>/<segment>.fp``：每个代码段的指纹文件，内容为代码段文本的SHA-1；
+  只在代码段内容变化时重写，未变化时保留修改时间
+- ``deps/<相对路径>.d``：依赖文件，目标为结果文件，依赖为源文件以及
+  该文件用到的每个代码段的指纹文件
+
+修改共享YAML中的某个代码段时，只有用到该代码段的目标需要重新构建，
+而不是所有依赖于YAML文件的目标。YAML中不存在的代码段也会生成指纹文件，
+之后补上该代码段时同样会触发重新构建。
+"""
+
+import hashlib
+import os
+from typing import Dict, Iterable, Tuple
+
+try:
+    from .utils import OUTPUT_META_DIR, write_output_file, remove_output_path
+except ImportError:
+    from code.core.utils import OUTPUT_META_DIR, write_output_file, remove_output_path
+
+AnchorKey = Tuple[str, str, str]
+
+# YAML中不存在的代码段的指纹
+MISSING_FINGERPRINT = "missing"
+
+
+def segment_fingerprint(code) -> str:
+    """计算代码段的指纹；代码段不存在或不是文本时返回 :data:`MISSING_FINGERPRINT`"""
+    if not isinstance(code, str):
+        return MISSING_FINGERPRINT
+    return hashlib.sha1(code.encode('utf-8')).hexdigest()
+
+
+def _escape(path: str) -> str:
+    """按Makefile规则转义依赖文件中的路径"""
+    return path.replace('\\', '/').replace('$', '$$').replace('#', '\\#').replace(' ', '\\ ')
+
+
+class DepfileWriter:
+    """
+    写出代码段指纹文件与依赖文件
+
+    由合并文件结果的线程调用；同一次运行中每个代码段的指纹只计算和检查一次。
+    """
+
+    def __init__(self, output_dir: str):
+        self.output_dir = os.path.abspath(output_dir)
+        self.meta_dir = os.path.join(self.output_dir, OUTPUT_META_DIR)
+        # 已写出的指纹，按YAML处理器区分，配置重新加载后重新检查
+        self._fingerprints: Dict[AnchorKey, str] = {}
+        self._handler = None
+
+    def fingerprint_path(self, key: AnchorKey) -> str:
+        tc_id, step_id, segment_id = key
+        return os.path.join(self.meta_dir, 'fp', tc_id, step_id, f"{segment_id}.fp")
+
+    def depfile_path(self, source_path: str, root_dir: str) -> str:
+        return os.path.join(self.meta_dir, 'deps', os.path.relpath(source_path, root_dir) + '.d')
+
+    def _ensure_fingerprint(self, key: AnchorKey, yaml_handler) -> bool:
+        try:
+            code = yaml_handler.stub_data[key[0]][key[1]][key[2]]
+        except (AttributeError, KeyError, TypeError):
+            code = None
+        digest = segment_fingerprint(code)
+        if self._fingerprints.get(key) == digest:
+            return True
+        if not write_output_file(self.fingerprint_path(key), digest + '\n', only_if_changed=True):
+            return False
+        self._fingerprints[key] = digest
+        return True
+
+    def update(self, root_dir: str, source_path: str, keys: Iterable[AnchorKey], yaml_handler) -> bool:
+        """
+        写出单个结果文件的依赖文件及其用到的代码段指纹
+
+        Args:
+            root_dir: 项目根目录
+            source_path: 源文件路径
+            keys: 文件中出现的锚点 ``(TC, STEP, segment)``
+            yaml_handler: 当前使用的YAML处理器
+
+        Returns:
+            bool: 全部写入成功返回True
+        """
+        if yaml_handler is not self._handler:
+            self._fingerprints.clear()
+            self._handler = yaml_handler
+        keys = sorted(keys)
+        ok = all([self._ensure_fingerprint(key, yaml_handler) for key in keys])
+
+        target = os.path.join(self.output_dir, os.path.relpath(source_path, root_dir))
+        prerequisites = [os.path.abspath(source_path)] + [self.fingerprint_path(key) for key in keys]
+        lines = [f"{_escape(target)}: \\"]
+        lines.extend(f"  {_escape(path)} \\" for path in prerequisites[:-1])
+        lines.append(f"  {_escape(prerequisites[-1])}")
+        content = "\n".join(lines) + "\n"
+        return write_output_file(self.depfile_path(source_path, root_dir), content,
+                                 only_if_changed=True) and ok
+
+    def remove(self, root_dir: str, source_path: str) -> None:
+        """源文件删除后移除其依赖文件（目录删除时移除其下的全部依赖文件）"""
+        depfile = self.depfile_path(source_path, root_dir)
+        remove_output_path(depfile)
+        remove_output_path(depfile[:-len('.d')])
+
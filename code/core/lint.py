@@ -0,0 +1,241 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave Core 模块 - lint
+只扫描源文件与YAML配置、不插桩也不写出任何文件的锚点检查
+
+与插桩不同，检查不解码整个文件、不查找和渲染桩代码：
+
+- 以字节形式读取源文件，先用字节正则找出含 ``// ... TC<数字>`` 的候选行，
+  只解码这些行再按 :data:`weave_engine.ANCHOR_PATTERN` 解析锚点
+- YAML配置预先展开为代码段键 ``(TC, STEP, segment)`` 的集合，
+  缺失锚点与未被引用的代码段都由集合运算得出
+
+报告四类问题：
+
+- 缺失锚点：锚点在YAML中没有对应的代码段（与插桩时的 ``missing_anchors`` 相同）
+- 未引用的代码段：YAML中没有任何锚点引用的代码段
+- 格式错误的锚点：``// TC001`` 或 ``// TC001 STEP1`` 这样少于三部分的锚点（传统格式 ``// TC001 STEP1:`` 除外）
+- 没有锚点的文件（带内嵌代码的传统格式锚点 ``// TC001 STEP1:`` + ``// code: ...`` 不需要YAML代码段，
+  同样算作锚点，单独计数）
+
+模板代码段按存在即视为可用，不按锚点上下文渲染。长期运行的进程（如守护进程）可传入
+:class:`ScanCache`，签名（修改时间与大小）未变的文件直接复用上次的扫描结果。
+"""
+
+import os
+import re
+from concurrent.futures import ThreadPoolExecutor
+from typing import Any, Dict, FrozenSet, List, NamedTuple, Optional, Tuple
+
+try:
+    from .weave_engine import (ANCHOR_PATTERN, TRADITIONAL_PATTERN, SINGLE_LINE_CODE_PATTERN,
+                               MULTI_LINE_START)
+    from .anchor_index import AnchorIndex
+    from .stub_processor import find_c_files
+    from ..utils.logger import get_logger
+except ImportError:
+    from code.core.weave_engine import (ANCHOR_PATTERN, TRADITIONAL_PATTERN, SINGLE_LINE_CODE_PATTERN,
+                                        MULTI_LINE_START)
+    from code.core.anchor_index import AnchorIndex
+    from code.core.stub_processor import find_c_files
+    from code.utils.logger import get_logger
+
+logger = get_logger(__name__)
+
+# 可能含有锚点的行：注释中出现 TC<数字>（GBK双字节字符的尾字节不会是 '/'，按字节匹配不会误判注释起点）
+_CANDIDATE = re.compile(rb'//[^\n]*?[Tt][Cc][0-9]')
+# 少于三部分的锚点：注释只有 TC<数字>，或 TC<数字> 加一个部分
+_MALFORMED = re.compile(r'//\s*(TC\d+(?:\s+\S+)?)\s*$', re.IGNORECASE)
+
+AnchorKey = Tuple[str, str, str]
+
+
+class FileScan(NamedTuple):
+    """单个文件的扫描结果；行号从1开始，``traditional`` 为带内嵌代码的传统格式锚点所在行"""
+    anchors: Tuple[Tuple[int, AnchorKey], ...]
+    malformed: Tuple[Tuple[int, str], ...]
+    traditional: Tuple[int, ...] = ()
+
+
+def _decode_line(raw: bytes) -> str:
+    try:
+        return raw.decode('utf-8')
+    except UnicodeDecodeError:
+        return raw.decode('gb18030', errors='replace')
+
+
+def scan_bytes(data: bytes) -> FileScan:
+    """扫描源文件内容中的锚点与格式错误的锚点"""
+    if b'\r' in data:
+        data = data.replace(b'\r\n', b'\n').replace(b'\r', b'\n')
+    anchors = []
+    malformed = []
+    traditional = []
+    line_no = 1
+    position = 0
+    line_end = -1
+    for match in _CANDIDATE.finditer(data):
+        start = match.start()
+        if start < line_end:
+            continue
+        line_start = data.rfind(b'\n', 0, start) + 1
+        line_no += data.count(b'\n', position, line_start)
+        position = line_start
+        line_end = data.find(b'\n', start)
+        if line_end < 0:
+            line_end = len(data)
+        line = _decode_line(data[line_start:line_end])
+        anchor = ANCHOR_PATTERN.search(line)
+        if anchor:
+            anchors.append((line_no, anchor.groups()[:3]))
+            continue
+        if TRADITIONAL_PATTERN.search(line):
+            # 与 weave_engine.scan_traditional 相同：下一行有内嵌代码时才会插入
+            next_end = data.find(b'\n', line_end + 1)
+            next_line = _decode_line(data[line_end + 1:next_end if next_end >= 0 else len(data)])
+            if SINGLE_LINE_CODE_PATTERN.search(next_line) or MULTI_LINE_START in next_line:
+                traditional.append(line_no)
+            continue
+        bad = _MALFORMED.search(line)
+        if bad:
+            malformed.append((line_no, ' '.join(bad.group(1).split())))
+    return FileScan(tuple(anchors), tuple(malformed), tuple(traditional))
+
+
+class ScanCache:
+    """按文件签名缓存扫描结果，供守护进程等长期运行的进程跨多次检查复用"""
+
+    def __init__(self):
+        self._entries: Dict[str, Tuple[Tuple[int, int], FileScan]] = {}
+        self.hits = 0
+        self.misses = 0
+
+    def __len__(self) -> int:
+        return len(self._entries)
+
+    def get(self, file_path: str, signature) -> Optional[FileScan]:
+        entry = self._entries.get(file_path)
+        if entry is not None and signature is not None and entry[0] == signature:
+            self.hits += 1
+            return entry[1]
+        self.misses += 1
+        return None
+
+    def put(self, file_path: str, signature, scan: FileScan) -> None:
+        if signature is not None:
+            self._entries[file_path] = (signature, scan)
+
+    def clear(self) -> None:
+        self._entries.clear()
+        self.hits = self.misses = 0
+
+
+def scan_file(file_path: str, cache: Optional[ScanCache] = None) -> Tuple[Optional[FileScan], Optional[str]]:
+    """
+    扫描单个文件
+
+    Returns:
+        Tuple[Optional[FileScan], Optional[str]]: (扫描结果, 错误信息)
+    """
+    signature = None
+    if cache is not None:
+        signature = AnchorIndex.signature(file_path)
+        scan = cache.get(file_path, signature)
+        if scan is not None:
+            return scan, None
+    try:
+        with open(file_path, 'rb') as f:
+            data = f.read()
+    except OSError as e:
+        return None, f"无法读取文件: {file_path}: {e}"
+    scan = scan_bytes(data)
+    if cache is not None:
+        cache.put(file_path, signature, scan)
+    return scan, None
+
+
+def yaml_keys(yaml_handler) -> FrozenSet[AnchorKey]:
+    """YAML配置中全部可用代码段的键 ``(TC, STEP, segment)``（代码段须为非空字符串）"""
+    stub_data = getattr(yaml_handler, 'stub_data', None) or {}
+    keys = set()
+    if not isinstance(stub_data, dict):
+        return frozenset()
+    for tc_id, steps in stub_data.items():
+        if not isinstance(steps, dict):
+            continue
+        for step_id, segments in steps.items():
+            if not isinstance(segments, dict):
+                continue
+            keys.update((str(tc_id), str(step_id), str(segment_id))
+                        for segment_id, code in segments.items() if isinstance(code, str) and code)
+    return frozenset(keys)
+
+
+def lint_directory(root_dir: str, yaml_handler=None, cache: Optional[ScanCache] = None,
+                   max_workers: int = 1) -> Dict[str, Any]:
+    """
+    检查目录中的锚点，不写出任何文件
+
+    未指定YAML配置时只检查格式错误的锚点。
+
+    Returns:
+        Dict[str, Any]: 与 ``process_directory`` 结果兼容的统计信息（不含输出目录），另有
+        ``anchors``（新格式锚点总数）、``traditional_anchors``（带内嵌代码的传统格式锚点数）、
+        ``malformed_anchors``、``unused_segments`` 与 ``cache_hits``
+    """
+    result: Dict[str, Any] = {
+        "total_files": 0, "processed_files": 0, "anchors": 0, "traditional_anchors": 0, "successful_stubs": 0,
+        "missing_stubs": 0, "missing_anchor_details": [], "malformed_anchors": [],
+        "unused_segments": [], "files_without_anchors": [], "errors": [],
+        "cancelled": False, "unprocessed_files": [], "cache_hits": 0,
+    }
+    if not os.path.isdir(root_dir):
+        result["errors"].append({"file": "N/A", "error": f"目录不存在: {root_dir}"})
+        return result
+
+    c_files = find_c_files(root_dir, create_sample=False)
+    result["total_files"] = len(c_files)
+    hits_before = cache.hits if cache is not None else 0
+    if max_workers > 1 and len(c_files) > 1:
+        with ThreadPoolExecutor(max_workers=max_workers) as executor:
+            scans = list(executor.map(lambda path: scan_file(path, cache), c_files))
+    else:
+        scans = [scan_file(path, cache) for path in c_files]
+    if cache is not None:
+        result["cache_hits"] = cache.hits - hits_before
+
+    available = yaml_keys(yaml_handler) if yaml_handler is not None else None
+    referenced = set()
+    for file_path, (scan, error) in zip(c_files, scans):
+        if scan is None:
+            result["errors"].append({"file": file_path, "error": error})
+            continue
+        result["processed_files"] += 1
+        result["malformed_anchors"].extend({"file": file_path, "line": line, "anchor": text}
+                                           for line, text in scan.malformed)
+        if available is None:
+            continue
+        result["anchors"] += len(scan.anchors)
+        result["traditional_anchors"] += len(scan.traditional)
+        if not scan.anchors and not scan.traditional:
+            result["files_without_anchors"].append(os.path.relpath(file_path, root_dir))
+            continue
+        keys = {key for _, key in scan.anchors}
+        referenced |= keys
+        missing = keys - available
+        found = 0
+        for line, key in scan.anchors:
+            if key in missing:
+                result["missing_anchor_details"].append({"file": file_path, "line": line, "anchor": " ".join(key)})
+            else:
+                found += 1
+        # 与插桩相同：文件中没有可插入的新格式锚点时才插入传统格式的内嵌代码
+        result["successful_stubs"] += found or len(scan.traditional)
+    if available is not None:
+        result["missing_stubs"] = len(result["missing_anchor_details"])
+        result["unused_segments"] = [" ".join(key) for key in sorted(available - referenced)]
+    logger.info("锚点检查完成: %d 个文件, %d 个锚点, 缺失 %d 个, 格式错误 %d 个, 未引用代码段 %d 个",
+                result["total_files"], result["anchors"], result["missing_stubs"],
+                len(result["malformed_anchors"]), len(result["unused_segments"]))
+    return result
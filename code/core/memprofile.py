@@ -0,0 +1,207 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave Core 模块 - memprofile
+用 tracemalloc 按处理阶段分析内存占用
+
+在阶段边界拍摄快照，每个阶段记录：
+
+- 峰值：阶段内 tracemalloc 记录的最高占用（每个阶段开始时重置峰值）
+- 留存：阶段结束时比开始时多占用的内存，即该阶段创建且仍未释放的对象
+- 分配位置：阶段结束时与开始时相比净增最多的源码行
+- 峰值时刻的分配位置：阶段内调用 :meth:`MemoryProfiler.checkpoint` 时若内存创新高则拍摄快照，
+  给出此时比阶段开始时多占用最多的源码行
+
+各文件的内容、``lines`` 列表、桩点字典等在文件处理完成后释放，主要体现在处理文件阶段（``weave``）
+的峰值与峰值时刻的分配位置上（每个文件插桩完成后检查一次）；YAML配置的 ``stub_data`` 树在整个运行期间保留，体现在加载配置阶段（``yaml``）的留存
+和运行结束时仍占用内存的分配位置上。
+
+只统计开始分析之后的分配。tracemalloc 会使处理明显变慢，只用于分析，不用于计时。
+"""
+
+import os
+import threading
+import tracemalloc
+from contextlib import contextmanager, nullcontext
+from typing import Any, Dict, List, Optional
+
+try:
+    from .timing import PHASE_NAMES
+except ImportError:
+    from code.core.timing import PHASE_NAMES
+
+# 内存分析另有的阶段：加载YAML配置、处理全部文件
+MEMORY_PHASE_NAMES = dict(PHASE_NAMES, yaml='加载配置', weave='处理文件')
+
+# 快照中排除的分配：tracemalloc 自身、导入系统与本模块
+_EXCLUDE = (
+    tracemalloc.Filter(False, tracemalloc.__file__),
+    tracemalloc.Filter(False, "<frozen importlib._bootstrap>"),
+    tracemalloc.Filter(False, "<frozen importlib._bootstrap_external>"),
+    tracemalloc.Filter(False, "<unknown>"),
+    tracemalloc.Filter(False, __file__),
+)
+
+
+def _site(frame) -> str:
+    """分配位置，路径只保留最后两级（如 ``core/utils.py:88``）"""
+    parts = os.path.normpath(frame.filename).split(os.sep)
+    return f"{'/'.join(parts[-2:])}:{frame.lineno}"
+
+
+class MemoryProfiler:
+    """
+    单次运行的分阶段内存分析
+
+    :meth:`start` 开始跟踪，:meth:`phase` 标出阶段边界，:meth:`stop` 结束跟踪并记录
+    运行结束时仍占用内存最多的分配位置。tracemalloc 是进程级的，同一时刻只应有一个分析器；
+    开始时已在跟踪（如 ``python -X tracemalloc``）则沿用，结束时不停止。
+    """
+
+    def __init__(self, top: int = 10, frames: int = 1):
+        self.top = top
+        self.frames = frames
+        self.peak_bytes = 0
+        self.final_bytes: Optional[int] = None
+        self.phases: Dict[str, Dict[str, Any]] = {}
+        self.retained_sites: List[Dict[str, Any]] = []
+        self._sites: Dict[str, Dict[str, List[int]]] = {}
+        self._active = False
+        self._owns_tracing = False
+        self._lock = threading.Lock()
+        self._high = 0
+        self._high_snapshot = None
+
+    def start(self) -> None:
+        """开始跟踪内存分配"""
+        if not tracemalloc.is_tracing():
+            tracemalloc.start(self.frames)
+            self._owns_tracing = True
+        tracemalloc.reset_peak()
+        self._active = True
+
+    @staticmethod
+    def _take_snapshot():
+        return tracemalloc.take_snapshot().filter_traces(_EXCLUDE)
+
+    @contextmanager
+    def phase(self, name: str):
+        """统计 ``with`` 语句块内的内存峰值、留存和净增最多的分配位置"""
+        if not self._active or not tracemalloc.is_tracing():
+            yield
+            return
+        baseline = self._take_snapshot()
+        # 重置峰值前先计入阶段之外的峰值
+        start_bytes, peak = tracemalloc.get_traced_memory()
+        self.peak_bytes = max(self.peak_bytes, peak)
+        tracemalloc.reset_peak()
+        self._high = start_bytes
+        self._high_snapshot = None
+        try:
+            yield
+        finally:
+            current, peak = tracemalloc.get_traced_memory()
+            snapshot = self._take_snapshot()
+            with self._lock:
+                high_snapshot, self._high_snapshot = self._high_snapshot, None
+                self._high = 0
+            entry = self.phases.setdefault(name, {"peak_bytes": 0, "retained_bytes": 0, "calls": 0})
+            entry["peak_bytes"] = max(entry["peak_bytes"], peak)
+            entry["retained_bytes"] += current - start_bytes
+            entry["calls"] += 1
+            self.peak_bytes = max(self.peak_bytes, peak)
+            sites = self._sites.setdefault(name, {})
+            for diff in snapshot.compare_to(baseline, 'lineno'):
+                if diff.size_diff > 0:
+                    totals = sites.setdefault(_site(diff.traceback[0]), [0, 0])
+                    totals[0] += diff.size_diff
+                    totals[1] += diff.count_diff
+            if high_snapshot is not None:
+                entry["peak_top"] = self._top(high_snapshot.compare_to(baseline, 'lineno'))
+
+    def checkpoint(self) -> None:
+        """
+        在阶段内的内存高点拍摄快照（可在工作线程中调用）
+
+        当前占用比上次记录的高点多1%以上时才拍摄，一个阶段内通常只拍摄少数几次。
+        """
+        if not self._high:
+            return
+        current = tracemalloc.get_traced_memory()[0]
+        if current <= self._high * 1.01:
+            return
+        with self._lock:
+            if not self._high or current <= self._high * 1.01:
+                return
+            self._high = current
+            self._high_snapshot = self._take_snapshot()
+
+    def _top(self, diffs) -> List[Dict[str, Any]]:
+        """净增为正的前 ``top`` 个分配位置"""
+        return [{"site": _site(diff.traceback[0]), "size_bytes": diff.size_diff, "count": diff.count_diff}
+                for diff in diffs if diff.size_diff > 0][:self.top]
+
+    def stop(self) -> None:
+        """结束跟踪，记录结束时的占用与仍占用内存最多的分配位置（重复调用时无效）"""
+        if not self._active or not tracemalloc.is_tracing():
+            return
+        current, peak = tracemalloc.get_traced_memory()
+        self.final_bytes = current
+        self.peak_bytes = max(self.peak_bytes, peak)
+        snapshot = self._take_snapshot()
+        self.retained_sites = [{"site": _site(stat.traceback[0]), "size_bytes": stat.size, "count": stat.count}
+                               for stat in snapshot.statistics('lineno')[:self.top]]
+        self._active = False
+        if self._owns_tracing:
+            tracemalloc.stop()
+            self._owns_tracing = False
+
+    def to_dict(self) -> Dict[str, Any]:
+        """
+        生成可序列化为JSON的分析结果
+
+        ``phases`` 中每个阶段包含峰值 ``peak_bytes``、留存 ``retained_bytes``、经过次数 ``calls``
+        和净增最多的分配位置 ``top``，阶段内拍摄过高点快照时另有峰值时刻的分配位置 ``peak_top``；
+        ``retained_top`` 为运行结束时仍占用内存最多的分配位置。
+        """
+        phases = {}
+        for name, entry in self.phases.items():
+            sites = sorted(self._sites.get(name, {}).items(), key=lambda item: item[1][0], reverse=True)
+            phases[name] = dict(entry, top=[{"site": site, "size_bytes": size, "count": count}
+                                            for site, (size, count) in sites[:self.top]])
+        return {
+            "peak_bytes": self.peak_bytes,
+            "final_bytes": self.final_bytes,
+            "phases": phases,
+            "retained_top": self.retained_sites,
+        }
+
+
+def measure_memory(profiler: Optional[MemoryProfiler], phase: str):
+    """返回统计内存阶段的上下文管理器；``profiler`` 为None时不做任何事"""
+    return profiler.phase(phase) if profiler is not None else nullcontext()
+
+
+def _mb(size: int) -> str:
+    return f"{size / 1048576:.2f} MB"
+
+
+def format_memory(report: Dict[str, Any], sites: int = 3) -> List[str]:
+    """将 :meth:`MemoryProfiler.to_dict` 的结果格式化为文本行，每个阶段列出前 ``sites`` 个分配位置"""
+    lines = [f"峰值内存: {_mb(report.get('peak_bytes', 0))}"]
+    if report.get("final_bytes") is not None:
+        lines[0] += f"，结束时占用 {_mb(report['final_bytes'])}"
+    for name, entry in report.get("phases", {}).items():
+        lines.append(f"  {MEMORY_PHASE_NAMES.get(name, name)}({name}): 峰值 {_mb(entry['peak_bytes'])}，"
+                     f"留存 {entry['retained_bytes'] / 1048576:+.2f} MB")
+        for site in entry.get("top", [])[:sites]:
+            lines.append(f"    {site['site']}: +{_mb(site['size_bytes'])} ({site['count']:+d} 个对象)")
+        if entry.get("peak_top"):
+            lines.append("    峰值时刻:")
+            for site in entry["peak_top"][:sites]:
+                lines.append(f"      {site['site']}: +{_mb(site['size_bytes'])} ({site['count']:+d} 个对象)")
+    if report.get("retained_top"):
+        lines.append("  结束时占用最多的分配位置:")
+        for site in report["retained_top"][:sites * 2]:
+            lines.append(f"    {site['site']}: {_mb(site['size_bytes'])} ({site['count']} 个对象)")
+    return lines
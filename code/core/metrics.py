@@ -0,0 +1,206 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave Core 模块 - metrics
+将运行统计写成Prometheus文本格式的 ``.prom`` 文件，供 node_exporter 的 textfile 收集器读取
+
+指标由 ``StubProcessor.process_directory`` 的结果字典生成：
+
+- 计数器（``_total``）：运行次数、扫描文件数、插入了桩代码的文件数、插入的桩代码数、
+  缺失的桩代码（锚点无对应代码段）、错误数、读取与写入的字节数、按锚点索引跳过读取的文件数
+- 直方图 ``yamlweave_file_duration_seconds``：单文件各处理阶段耗时之和（需要启用计时）
+- 仪表：最近一次运行的耗时、结束时间与是否成功
+
+textfile 收集器每次抓取时重新读取整个文件，计数器须跨运行单调递增，因此写入时
+读取已有文件，对相同标签的计数器与直方图累加本次运行的值；其他标签的序列原样保留。
+文件先写入临时文件再原子替换，收集器不会读到写了一半的内容。
+"""
+
+import os
+import re
+import time
+from typing import Any, Dict, List, Optional, Tuple
+
+try:
+    from ..utils.logger import get_logger
+except ImportError:
+    from code.utils.logger import get_logger
+
+logger = get_logger(__name__)
+
+# 指标名 → 说明（写入 ``# HELP``）
+COUNTERS = {
+    "yamlweave_runs_total": "运行次数",
+    "yamlweave_files_scanned_total": "扫描的源文件数",
+    "yamlweave_files_updated_total": "插入了桩代码的文件数",
+    "yamlweave_stubs_inserted_total": "插入的桩代码数",
+    "yamlweave_missing_anchors_total": "没有对应桩代码的锚点数",
+    "yamlweave_errors_total": "处理出错的次数",
+    "yamlweave_bytes_read_total": "读取的源文件字节数",
+    "yamlweave_bytes_written_total": "处理的源文件写入结果目录的字节数",
+    "yamlweave_cache_hits_total": "按锚点索引跳过读取的文件数",
+}
+HISTOGRAM = ("yamlweave_file_duration_seconds", "单文件各处理阶段耗时之和（秒）")
+GAUGES = {
+    "yamlweave_last_run_duration_seconds": "最近一次运行的耗时（秒）",
+    "yamlweave_last_run_timestamp_seconds": "最近一次运行结束的时间（Unix时间戳）",
+    "yamlweave_last_run_success": "最近一次运行是否成功（无错误且未取消为1）",
+}
+
+_LABEL_NAME = re.compile(r'^[a-zA-Z_][a-zA-Z0-9_]*$')
+_SAMPLE = re.compile(r'^([a-zA-Z_:][a-zA-Z0-9_:]*(?:\{.*\})?)\s+(\S+)')
+
+
+def valid_label_name(name: str) -> bool:
+    """标签名是否符合Prometheus的命名规则（不允许 ``__`` 开头的保留名）"""
+    return bool(_LABEL_NAME.match(name)) and not name.startswith('__')
+
+
+def _escape(value: str) -> str:
+    return str(value).replace('\\', '\\\\').replace('"', '\\"').replace('\n', '\\n')
+
+
+def _series(name: str, labels: Dict[str, str], **extra: str) -> str:
+    """序列标识 ``名称{标签="值",...}``，标签按名称排序，``le`` 放在最后"""
+    items = sorted(labels.items()) + list(extra.items())
+    if not items:
+        return name
+    return name + "{" + ",".join(f'{key}="{_escape(value)}"' for key, value in items) + "}"
+
+
+def _format_number(value: float) -> str:
+    if value == int(value) and abs(value) < 1e15:
+        return str(int(value))
+    return repr(float(value))
+
+
+def collect(result: Dict[str, Any], labels: Dict[str, str],
+            now: Optional[float] = None) -> Tuple[List[Tuple[str, float]], List[Tuple[str, float]]]:
+    """
+    由运行结果生成本次运行的样本
+
+    Returns:
+        Tuple: (累加的样本, 替换的样本)，每项为 ``(序列标识, 值)``
+    """
+    values = {
+        "yamlweave_runs_total": 1,
+        "yamlweave_files_scanned_total": result.get("total_files", 0),
+        "yamlweave_files_updated_total": result.get("updated_files", 0),
+        "yamlweave_stubs_inserted_total": result.get("successful_stubs", 0),
+        "yamlweave_missing_anchors_total": result.get("missing_stubs", 0),
+        "yamlweave_errors_total": len(result.get("errors") or []),
+        "yamlweave_bytes_read_total": result.get("bytes_read", 0),
+        "yamlweave_bytes_written_total": result.get("bytes_written", 0),
+        "yamlweave_cache_hits_total": result.get("cache_hits", 0),
+    }
+    additive = [(_series(name, labels), float(value)) for name, value in values.items()]
+
+    timings = result.get("timings") or {}
+    histogram = timings.get("file_histogram_ms")
+    if histogram:
+        name = HISTOGRAM[0]
+        cumulative = 0
+        for label, count in histogram.items():
+            cumulative += count
+            le = label if label == '+Inf' else f"{float(label) / 1000:g}"
+            additive.append((_series(f"{name}_bucket", labels, le=le), float(cumulative)))
+        additive.append((_series(f"{name}_sum", labels), float(timings.get("file_seconds", 0.0))))
+        additive.append((_series(f"{name}_count", labels), float(cumulative)))
+
+    success = not result.get("errors") and not result.get("cancelled")
+    replaced = [(_series("yamlweave_last_run_timestamp_seconds", labels), float(round(now or time.time()))),
+                (_series("yamlweave_last_run_success", labels), 1.0 if success else 0.0)]
+    if "wall_seconds" in timings:
+        replaced.insert(0, (_series("yamlweave_last_run_duration_seconds", labels),
+                            float(timings["wall_seconds"])))
+    return additive, replaced
+
+
+def read_samples(path: str) -> Dict[str, float]:
+    """读取已有 ``.prom`` 文件中的样本（``序列标识 → 值``，保持文件中的顺序）；文件不存在或无法读取时返回空字典"""
+    samples: Dict[str, float] = {}
+    try:
+        with open(path, 'r', encoding='utf-8') as f:
+            for line in f:
+                if line.startswith('#'):
+                    continue
+                match = _SAMPLE.match(line.strip())
+                if match:
+                    try:
+                        samples[match.group(1)] = float(match.group(2))
+                    except ValueError:
+                        continue
+    except FileNotFoundError:
+        pass
+    except (OSError, UnicodeDecodeError) as e:
+        logger.warning("无法读取已有指标文件 %s，计数器将从零开始: %s", path, e)
+    return samples
+
+
+def _family(series: str) -> str:
+    name = series.split('{', 1)[0]
+    for suffix in ("_bucket", "_sum", "_count"):
+        if name == HISTOGRAM[0] + suffix:
+            return HISTOGRAM[0]
+    return name
+
+
+def format_prometheus(result: Dict[str, Any], labels: Dict[str, str],
+                      previous: Optional[Dict[str, float]] = None, now: Optional[float] = None) -> str:
+    """
+    生成Prometheus文本格式的指标
+
+    ``previous`` 为 :func:`read_samples` 读取的已有样本：相同标签的计数器与直方图在其基础上累加，
+    仪表被替换，其余序列原样保留。
+    """
+    samples = dict(previous or {})
+    additive, replaced = collect(result, labels, now)
+    for series, value in additive:
+        samples[series] = samples.get(series, 0.0) + value
+    for series, value in replaced:
+        samples[series] = value
+
+    families: Dict[str, List[str]] = {}
+    for series, value in samples.items():
+        families.setdefault(_family(series), []).append(f"{series} {_format_number(value)}")
+
+    metadata = [(name, "counter", text) for name, text in COUNTERS.items()]
+    metadata.append((HISTOGRAM[0], "histogram", HISTOGRAM[1]))
+    metadata.extend((name, "gauge", text) for name, text in GAUGES.items())
+    lines = []
+    for name, kind, text in metadata:
+        if name not in families:
+            continue
+        lines.append(f"# HELP {name} {text}")
+        lines.append(f"# TYPE {name} {kind}")
+        lines.extend(families.pop(name))
+    # 不认识的序列（例如手工添加的）原样保留，不加说明
+    for series_lines in families.values():
+        lines.extend(series_lines)
+    return "\n".join(lines) + "\n"
+
+
+def write_metrics(path: str, result: Dict[str, Any], labels: Optional[Dict[str, str]] = None) -> bool:
+    """
+    将运行统计累加写入 ``.prom`` 文件（先写临时文件再原子替换）
+
+    Returns:
+        bool: 是否写入成功
+    """
+    tmp_path = f"{path}.{os.getpid()}.tmp"
+    try:
+        directory = os.path.dirname(os.path.abspath(path))
+        os.makedirs(directory, exist_ok=True)
+        text = format_prometheus(result, labels or {}, read_samples(path))
+        with open(tmp_path, 'w', encoding='utf-8', newline='\n') as f:
+            f.write(text)
+        os.replace(tmp_path, path)
+        logger.info("已写出运行指标: %s", path)
+        return True
+    except Exception as e:
+        logger.error("写出运行指标 %s 失败: %s", path, e)
+        try:
+            os.remove(tmp_path)
+        except OSError:
+            pass
+        return False
@@ -0,0 +1,190 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave Core 模块 - profiler
+在cProfile或采样模式下运行插桩，写出 ``.pstats`` 与火焰图工具可直接读取的折叠调用栈
+
+两种模式：
+
+- ``cprofile``：确定性分析。开始分析后创建的工作线程各自启用一个 ``cProfile.Profile``，
+  结束时合并为一个 ``.pstats`` 文件（可用 ``python -m pstats``、snakeviz 等查看）；
+  折叠调用栈由调用关系按耗时比例展开，是近似结果
+- ``sample``：采样分析，开销低。后台线程每隔 ``interval`` 秒用 ``sys._current_frames()``
+  采集所有线程（包括各工作线程）的调用栈，只写出折叠调用栈，栈底为线程名
+
+折叠调用栈每行为 ``帧;帧;...;帧 数值``，可直接交给 flamegraph.pl、speedscope、inferno 等工具；
+cProfile模式下数值为微秒，采样模式下为样本数。
+"""
+
+import cProfile
+import os
+import pstats
+import sys
+import threading
+from collections import Counter
+from typing import Dict, List, Optional
+
+try:
+    from ..utils.logger import get_logger
+except ImportError:
+    from code.utils.logger import get_logger
+
+logger = get_logger(__name__)
+
+MODES = ('cprofile', 'sample')
+
+# 由cProfile调用关系展开调用栈时的最大深度，以及忽略的最小耗时（秒）
+_MAX_DEPTH = 64
+_MIN_SECONDS = 1e-6
+
+
+def _frame_label(filename: str, lineno: int, name: str) -> str:
+    if filename == '~':
+        return name
+    return f"{name} ({os.path.basename(filename)}:{lineno})"
+
+
+class CpuProfiler:
+    """
+    单次运行的CPU分析
+
+    :meth:`start` 与 :meth:`stop` 须在同一线程（发起运行的线程）中调用；
+    cProfile模式只分析该线程及开始之后创建的线程。
+    """
+
+    def __init__(self, mode: str = 'cprofile', interval: float = 0.005):
+        if mode not in MODES:
+            raise ValueError(f"未知的分析模式: {mode}")
+        self.mode = mode
+        self.interval = interval
+        self.samples: Counter = Counter()
+        self._profiles: List[cProfile.Profile] = []
+        self._lock = threading.Lock()
+        self._stop_event = threading.Event()
+        self._sampler: Optional[threading.Thread] = None
+
+    def start(self) -> None:
+        """开始分析"""
+        if self.mode == 'cprofile':
+            threading.setprofile(self._enable_in_thread)
+            profile = cProfile.Profile()
+            self._profiles.append(profile)
+            profile.enable()
+        else:
+            self._sampler = threading.Thread(target=self._sample_loop, name="yamlweave-sampler", daemon=True)
+            self._sampler.start()
+
+    def _enable_in_thread(self, frame, event, arg):
+        """新线程的第一个分析事件：为该线程创建并启用独立的 ``Profile``（替换本钩子）"""
+        profile = cProfile.Profile()
+        with self._lock:
+            self._profiles.append(profile)
+        profile.enable()
+
+    def stop(self) -> None:
+        """结束分析；应在工作线程结束之后调用（重复调用时无效）"""
+        if self.mode == 'cprofile':
+            threading.setprofile(None)
+            if self._profiles:
+                self._profiles[0].disable()
+        elif self._sampler is not None:
+            self._stop_event.set()
+            self._sampler.join()
+            self._sampler = None
+
+    def _sample_loop(self) -> None:
+        own = threading.get_ident()
+        names: Dict[int, str] = {}
+        while not self._stop_event.wait(self.interval):
+            for ident, frame in sys._current_frames().items():
+                if ident == own:
+                    continue
+                if ident not in names:
+                    names.update((thread.ident, thread.name) for thread in threading.enumerate())
+                stack = []
+                while frame is not None:
+                    code = frame.f_code
+                    stack.append(_frame_label(code.co_filename, code.co_firstlineno, code.co_name))
+                    frame = frame.f_back
+                stack.append(names.get(ident, f"thread-{ident}"))
+                self.samples[";".join(reversed(stack))] += 1
+
+    def stats(self) -> Optional[pstats.Stats]:
+        """合并各线程的cProfile结果；采样模式或没有数据时返回None"""
+        profiles = [profile for profile in self._profiles if profile.getstats()]
+        if not profiles:
+            return None
+        merged = pstats.Stats(profiles[0])
+        for profile in profiles[1:]:
+            merged.add(profile)
+        return merged
+
+    def collapsed(self, stats: Optional[pstats.Stats] = None) -> List[str]:
+        """生成折叠调用栈文本行；cProfile模式下可传入已合并的 ``stats``"""
+        if self.mode == 'sample':
+            return [f"{stack} {count}" for stack, count in sorted(self.samples.items())]
+        if stats is None:
+            stats = self.stats()
+        return collapse_stats(stats.stats) if stats is not None else []
+
+    def write(self, prefix: str) -> Dict[str, str]:
+        """
+        写出分析结果：cProfile模式写出 ``<prefix>.pstats``，两种模式都写出 ``<prefix>.collapsed``
+
+        Returns:
+            Dict[str, str]: 已写出的文件（``pstats`` / ``collapsed`` → 路径），写入失败的不包含在内
+        """
+        written = {}
+        try:
+            directory = os.path.dirname(os.path.abspath(prefix))
+            os.makedirs(directory, exist_ok=True)
+            stats = self.stats() if self.mode == 'cprofile' else None
+            if stats is not None:
+                stats.dump_stats(f"{prefix}.pstats")
+                written["pstats"] = f"{prefix}.pstats"
+            with open(f"{prefix}.collapsed", 'w', encoding='utf-8') as f:
+                for line in self.collapsed(stats):
+                    f.write(line + "\n")
+            written["collapsed"] = f"{prefix}.collapsed"
+            logger.info("已写出性能分析结果: %s", ", ".join(written.values()))
+        except Exception as e:
+            logger.error("写出性能分析结果 %s 失败: %s", prefix, e)
+        return written
+
+
+def collapse_stats(stats: Dict) -> List[str]:
+    """
+    由 ``pstats.Stats.stats`` 的调用关系展开折叠调用栈（数值为微秒）
+
+    cProfile只记录直接调用关系，不记录完整调用栈。从没有调用者的函数开始，
+    按每条调用边的累计耗时占被调函数总累计耗时的比例向下分摊，得到近似的调用栈耗时；
+    递归调用在栈中再次出现时不再展开。
+    """
+    callees: Dict[tuple, Dict[tuple, float]] = {}
+    for func, (_cc, _nc, _tt, _ct, callers) in stats.items():
+        for caller, edge in callers.items():
+            callees.setdefault(caller, {})[func] = edge[3]
+    totals: Counter = Counter()
+
+    def walk(func, stack, on_stack, scale):
+        _cc, _nc, tt, ct, _callers = stats[func]
+        stack.append(_frame_label(*func))
+        on_stack.add(func)
+        if tt * scale >= _MIN_SECONDS:
+            totals[";".join(stack)] += tt * scale
+        if len(stack) < _MAX_DEPTH:
+            for callee, edge_ct in callees.get(func, {}).items():
+                callee_ct = stats[callee][3]
+                if callee in on_stack or callee_ct <= 0:
+                    continue
+                child_scale = scale * min(1.0, edge_ct / callee_ct)
+                if callee_ct * child_scale >= _MIN_SECONDS:
+                    walk(callee, stack, on_stack, child_scale)
+        on_stack.discard(func)
+        stack.pop()
+
+    for func, (_cc, _nc, _tt, _ct, callers) in stats.items():
+        if not callers:
+            walk(func, [], set(), 1.0)
+    return [f"{stack} {round(seconds * 1e6)}" for stack, seconds in sorted(totals.items())
+            if round(seconds * 1e6) > 0]
@@ -0,0 +1,143 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave Core 模块 - progress
+插桩运行的进度汇总
+
+处理过程中只累加计数器（文件数、字节数、锚点数），不调用任何UI接口；
+界面按固定频率调用 :meth:`ProgressTracker.snapshot` 采样并计算速率与剩余时间，
+因此进度显示的开销与文件数量无关。
+"""
+
+import threading
+import time
+from dataclasses import dataclass
+from typing import Optional
+
+
+@dataclass(frozen=True)
+class ProgressSnapshot:
+    """某一时刻的进度快照"""
+    files_done: int
+    total_files: int
+    bytes_done: int
+    total_bytes: int
+    anchors: int
+    elapsed: float
+    finished: bool
+
+    @property
+    def percentage(self) -> int:
+        """完成百分比（按文件数）"""
+        if self.finished:
+            return 100
+        if self.total_files <= 0:
+            return 0
+        return min(100, int(self.files_done * 100 / self.total_files))
+
+    @property
+    def files_per_sec(self) -> float:
+        return self.files_done / self.elapsed if self.elapsed > 0 else 0.0
+
+    @property
+    def mb_per_sec(self) -> float:
+        return self.bytes_done / 1048576.0 / self.elapsed if self.elapsed > 0 else 0.0
+
+    @property
+    def eta(self) -> Optional[float]:
+        """预计剩余秒数，优先按字节数估算；尚无数据时返回None"""
+        if self.finished:
+            return 0.0
+        if self.total_bytes > 0 and self.bytes_done > 0:
+            rate = self.bytes_done / self.elapsed if self.elapsed > 0 else 0.0
+            remaining = self.total_bytes - self.bytes_done
+        elif self.files_done > 0:
+            rate = self.files_per_sec
+            remaining = self.total_files - self.files_done
+        else:
+            return None
+        return max(0.0, remaining / rate) if rate > 0 else None
+
+    def describe(self) -> str:
+        """生成状态栏显示的进度文本"""
+        text = (f"{self.files_done}/{self.total_files} 文件 ({self.percentage}%) · "
+                f"{self.files_per_sec:.1f} 文件/s · {self.mb_per_sec:.2f} MB/s")
+        eta = self.eta
+        if self.finished:
+            text += f" · 用时 {_format_seconds(self.elapsed)}"
+        elif eta is not None:
+            text += f" · 剩余 {_format_seconds(eta)}"
+        return text
+
+
+def _format_seconds(seconds: float) -> str:
+    """格式化为 ``MM:SS`` 或 ``H:MM:SS``"""
+    seconds = int(round(seconds))
+    hours, rest = divmod(seconds, 3600)
+    minutes, secs = divmod(rest, 60)
+    if hours:
+        return f"{hours}:{minutes:02d}:{secs:02d}"
+    return f"{minutes:02d}:{secs:02d}"
+
+
+class ProgressTracker:
+    """
+    线程安全的进度计数器
+
+    处理线程调用 :meth:`start`、:meth:`add` 与 :meth:`finish`，
+    其他线程随时调用 :meth:`snapshot` 读取一致的快照。
+    """
+
+    def __init__(self):
+        self._lock = threading.Lock()
+        self._total_files = 0
+        self._total_bytes = 0
+        self._files = 0
+        self._bytes = 0
+        self._anchors = 0
+        self._started = None
+        self._finished = None
+
+    def start(self, total_files: int, total_bytes: int = 0) -> None:
+        """开始计时并设置总量"""
+        with self._lock:
+            self._total_files = total_files
+            self._total_bytes = total_bytes
+            self._files = self._bytes = self._anchors = 0
+            self._started = time.perf_counter()
+            self._finished = None
+
+    def add(self, files: int = 0, bytes: int = 0, anchors: int = 0) -> None:
+        """累加已完成的文件数、字节数与插入的锚点数"""
+        with self._lock:
+            self._files += files
+            self._bytes += bytes
+            self._anchors += anchors
+
+    def finish(self) -> None:
+        """标记运行结束"""
+        with self._lock:
+            if self._started is None:
+                self._started = time.perf_counter()
+            self._finished = time.perf_counter()
+
+    @property
+    def finished(self) -> bool:
+        return self._finished is not None
+
+    def snapshot(self) -> ProgressSnapshot:
+        """读取当前进度快照"""
+        with self._lock:
+            if self._started is None:
+                elapsed = 0.0
+            else:
+                elapsed = (self._finished or time.perf_counter()) - self._started
+            return ProgressSnapshot(
+                files_done=self._files,
+                total_files=self._total_files,
+                bytes_done=self._bytes,
+                total_bytes=self._total_bytes,
+                anchors=self._anchors,
+                elapsed=elapsed,
+                finished=self._finished is not None,
+            )
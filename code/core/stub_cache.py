@@ -0,0 +1,110 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave Core 模块 - stub_cache
+跨进程复用的YAML桩代码缓存
+
+编译器包装等短生命周期进程每次启动都要加载同一个YAML配置。
+解析结果以pickle格式保存在调用方指定的私有目录中，按YAML文件路径区分，
+文件签名（修改时间与大小）未变时直接读取缓存，无需导入PyYAML和重新解析。
+缓存文件先写入临时文件再原子替换，``make -j`` 并行启动的多个进程可同时读写。
+
+pickle反序列化可执行任意代码，缓存目录须由调用方保证只有当前用户可写；
+POSIX上读取前还会检查缓存文件本身：不是当前用户所有、是符号链接或同组与其他用户可写时忽略。
+"""
+
+import hashlib
+import os
+import pickle
+import stat
+import sys
+import tempfile
+from typing import Optional
+
+try:
+    from ..utils.logger import get_logger
+    from ..handlers.yaml_handler import YamlStubHandler
+    from .anchor_index import AnchorIndex
+except ImportError:
+    from code.utils.logger import get_logger
+    from code.handlers.yaml_handler import YamlStubHandler
+    from code.core.anchor_index import AnchorIndex
+
+logger = get_logger(__name__)
+
+# 缓存格式版本，结构变化时递增
+CACHE_VERSION = 1
+
+
+def cache_path(cache_dir: str, yaml_file: str) -> str:
+    """返回YAML文件对应的缓存文件路径"""
+    digest = hashlib.sha1(os.path.abspath(yaml_file).encode('utf-8')).hexdigest()[:16]
+    return os.path.join(cache_dir, f"stubs-{digest}.pickle")
+
+
+def _trusted(fd: int) -> bool:
+    """缓存文件属于当前用户且同组与其他用户不可写"""
+    if sys.platform == "win32":
+        return True
+    st = os.fstat(fd)
+    return stat.S_ISREG(st.st_mode) and st.st_uid == os.getuid() and not st.st_mode & 0o022
+
+
+def _read_cache(path: str, signature) -> Optional[dict]:
+    try:
+        fd = os.open(path, os.O_RDONLY | getattr(os, 'O_NOFOLLOW', 0) | getattr(os, 'O_BINARY', 0))
+    except OSError:
+        return None
+    try:
+        with os.fdopen(fd, 'rb') as f:
+            if not _trusted(f.fileno()):
+                logger.warning("YAML缓存文件 %s 不属于当前用户或可被其他用户修改，忽略", path)
+                return None
+            cached = pickle.load(f)
+    except (OSError, EOFError, pickle.UnpicklingError, AttributeError, ImportError):
+        return None
+    if (not isinstance(cached, dict) or cached.get("version") != CACHE_VERSION
+            or cached.get("signature") != signature):
+        return None
+    return cached.get("stub_data")
+
+
+def _write_cache(path: str, signature, stub_data: dict) -> None:
+    tmp_path = None
+    try:
+        fd, tmp_path = tempfile.mkstemp(dir=os.path.dirname(path), suffix='.tmp')
+        with os.fdopen(fd, 'wb') as f:
+            pickle.dump({"version": CACHE_VERSION, "signature": signature, "stub_data": stub_data},
+                        f, protocol=pickle.HIGHEST_PROTOCOL)
+        os.replace(tmp_path, path)
+    except Exception as e:
+        logger.debug("写入YAML缓存失败: %s", e)
+        if tmp_path and os.path.exists(tmp_path):
+            os.remove(tmp_path)
+
+
+def load_yaml_handler(yaml_file: str, cache_dir: Optional[str]) -> Optional[YamlStubHandler]:
+    """
+    加载YAML配置，优先使用缓存
+
+    Args:
+        yaml_file: YAML配置文件
+        cache_dir: 缓存目录（须只有当前用户可写，如 :func:`daemon.runtime_dir` 检查过的目录）；None表示不使用缓存
+
+    Returns:
+        Optional[YamlStubHandler]: 加载好的处理器；文件不存在或加载失败时返回None
+    """
+    signature = AnchorIndex.signature(yaml_file)
+    if signature is None:
+        return None
+    handler = YamlStubHandler()
+    path = cache_path(cache_dir, yaml_file) if cache_dir else None
+    stub_data = _read_cache(path, signature) if path else None
+    if stub_data is not None:
+        handler.set_stub_data(stub_data, yaml_file)
+        return handler
+    if not handler.load_yaml(yaml_file):
+        return None
+    if path:
+        _write_cache(path, signature, handler.stub_data)
+    return handler
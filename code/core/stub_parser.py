@@ -8,8 +8,8 @@
 3. 解析传统格式的注释
 """
 
-import re
 import os
+import time
 import logging
 import importlib
 from typing import List, Dict, Any, Optional, Tuple
@@ -63,6 +63,18 @@ if not YamlStubHandler:
         logger.error(f"详细错误: {e}")
 
 
+# 导入按锚点上下文渲染模板的查找函数
+try:
+    from ..handlers.stub_template import make_anchor_lookup
+except Exception:
+    from code.handlers.stub_template import make_anchor_lookup
+
+# 导入统一插桩引擎
+try:
+    from . import weave_engine
+except Exception:
+    from code.core import weave_engine
+
 # 导入文件处理工具函数
 try:
     from ..core.utils import read_file, write_file
@@ -112,28 +124,26 @@ class StubParser:
     """
     
     def __init__(self, yaml_handler: Optional[YamlStubHandler] = None):
-        # 传统模式的正则表达式
-        # 测试用例ID匹配模式 - 匹配符合"// TC001 STEP1:"格式的注释行
-        self.test_case_pattern = re.compile(r'//\s*(TC\d+\s+STEP\d+):', re.IGNORECASE)
+        # 锚点匹配规则统一定义在 weave_engine 中，此处保留属性以兼容旧代码
+        # 传统模式 - 匹配符合"// TC001 STEP1:"格式的注释行
+        self.test_case_pattern = weave_engine.TRADITIONAL_PATTERN
         
         # 单行代码匹配模式 - 匹配"// code: [代码内容]"格式
-        self.single_line_code_pattern = re.compile(r'//\s*code:\s*(.*)')
+        self.single_line_code_pattern = weave_engine.SINGLE_LINE_CODE_PATTERN
         
         # 多行代码开始和结束标记
-        self.multi_line_start = '/* code:'
-        self.multi_line_end = '*/'
+        self.multi_line_start = weave_engine.MULTI_LINE_START
+        self.multi_line_end = weave_engine.MULTI_LINE_END
         
         # 新格式锚点匹配模式 - 匹配符合"// TC001 STEP1 segment1"格式的注释行
-        self.anchor_pattern = re.compile(r'//\s*(TC\d+\s+STEP\d+\s+\w+).*', re.IGNORECASE)
+        # 第四个分组为代码段ID之后的附加参数，供模板代码段使用
+        self.anchor_pattern = weave_engine.ANCHOR_PATTERN
         
         # YAML处理器
         self.yaml_handler = yaml_handler
 
-        # 用于统计缺失的桩代码锚点
-        self.missing_anchors: List[Dict[str, Any]] = []
-
-        # 用于记录未找到任何锚点的文件
-        self.files_without_anchors: List[str] = []
+        # 解析器不保存任何与单次运行相关的状态：缺失锚点和无锚点文件
+        # 记录在调用方传入的文件结果对象（FileResult）中
     
     def set_yaml_handler(self, yaml_handler: YamlStubHandler):
         """
@@ -144,7 +154,8 @@ class StubParser:
         """
         self.yaml_handler = yaml_handler
     
-    def parse_file(self, file_path: str, content: Optional[str] = None) -> List[Dict[str, Any]]:
+    def parse_file(self, file_path: str, content: Optional[str] = None,
+                   file_result=None) -> List[Dict[str, Any]]:
         """
         解析文件中的桩注释
         
@@ -155,6 +166,7 @@ class StubParser:
         Args:
             file_path: 文件路径
             content: 可选的文件内容，如果提供则不再读取文件
+            file_result: 可选的文件结果对象，用于记录缺失锚点等信息
             
         Returns:
             List[Dict[str, Any]]: 解析出的桩点列表
@@ -167,28 +179,47 @@ class StubParser:
                 return []
         
         lines = content.splitlines()
+        insertions = self.collect_insertions(file_path, lines, file_result)
+        return [self._to_stub_point(file_path, ins) for ins in insertions]
+    
+    def collect_insertions(self, file_path: str, lines: List[str],
+                           file_result=None) -> List[weave_engine.Insertion]:
+        """
+        扫描并解析文件中的全部插入项
         
-        # 优先使用新格式解析（锚点与桩代码分离机制）
-        stub_points = self.parse_new_format(file_path, lines)
+        优先使用新格式锚点（锚点与桩代码分离机制）；没有可插入的新格式
+        锚点或YAML处理器不可用时，回退到传统格式。
         
-        # 如果没有找到新格式的锚点，或YAML处理器不可用，则尝试传统格式
-        if not stub_points:
-            logger.info(f"未找到新格式锚点，尝试传统格式解析: {file_path}")
-            stub_points = self.parse_traditional_format(file_path, lines)
+        Args:
+            file_path: 文件路径
+            lines: 文件内容行列表
+            file_result: 可选的文件结果对象，缺失锚点与无锚点标记写入其中
+            
+        Returns:
+            List[Insertion]: 插入项列表
+        """
+        lookup = self._make_lookup(file_path, lines) if self.yaml_handler else None
+        if lookup is None:
+            logger.debug("YAML处理器未配置，仅解析传统格式: %s", file_path)
         
-        logger.info(f"在文件 {file_path} 中找到 {len(stub_points)} 个桩点")
-        return stub_points
+        timings = getattr(file_result, 'timings', None)
+        insertions, anchors, missing = weave_engine.weave_lines(lines, lookup, timings=timings)
+        self._record_scan(file_path, lookup is not None, anchors, missing, file_result)
+        logger.debug("在文件 %s 中找到 %d 个桩点", file_path, len(insertions))
+        return insertions
     
-    def parse_new_format(self, file_path: str, lines: List[str]) -> List[Dict[str, Any]]:
+    def parse_new_format(self, file_path: str, lines: List[str],
+                         file_result=None) -> List[Dict[str, Any]]:
         """
         解析新格式的锚点标识，在锚点位置插入桩代码
         
         仅在找到形如 ``// TC001 STEP1 segment1`` 的锚点时插入桩代码。
-        如果文件中未找到任何锚点，不再执行全局插入，而是记录文件名，供外部提示。
+        如果文件中未找到任何锚点，不再执行全局插入，而是在文件结果中标记，供外部提示。
         
         Args:
             file_path: 文件路径
             lines: 文件内容行列表
+            file_result: 可选的文件结果对象，缺失锚点与无锚点标记写入其中
             
         Returns:
             List[Dict[str, Any]]: 解析出的桩点列表
@@ -197,78 +228,10 @@ class StubParser:
             logger.warning("YAML处理器未配置，无法使用锚点与桩代码分离功能")
             return []
         
-        logger.info(f"开始处理文件 {file_path}")
-        
-        stub_points = []
-
-        # 首先在文件中查找锚点
-        # -------------------------------------------------------------
-        # 逐行扫描源文件，查找形如 ``// TC001 STEP1 segment1`` 的锚点。
-        # 每当找到一个锚点时，从 YAML 配置中获取对应的桩代码，然后记录
-        # 需要插入的行号和代码内容。
-        # -------------------------------------------------------------
-        found_anchors = False
-        for i, line in enumerate(lines):
-            match = self.anchor_pattern.search(line)
-            if match:
-                found_anchors = True
-                anchor_text = match.group(1).strip()
-                logger.info(f"在文件 {file_path} 的第 {i+1} 行找到锚点: {anchor_text}")
-
-                # 解析锚点标识
-                try:
-                    parts = anchor_text.split()
-                    # 仅获取前三个部分作为 TC_ID、STEP_ID 和 segment_ID
-                    tc_parts = []
-                    for part in parts:
-                        if part.strip():  # 过滤空字符串
-                            tc_parts.append(part.strip())
-
-                    logger.debug(
-                        f"锚点解析结果: 原始文本='{anchor_text}', 解析部分={tc_parts}"
-                    )
-
-                    # 确保至少有三个部分: TC_ID、STEP_ID、segment_ID
-                    if len(tc_parts) >= 3:
-                        tc_id = tc_parts[0]
-                        step_id = tc_parts[1]
-                        segment_id = tc_parts[2]
-
-                        # 从 YAML 配置中获取对应的桩代码
-                        code = self.yaml_handler.get_stub_code(
-                            tc_id, step_id, segment_id
-                        )
-
-                        if code:
-                            logger.info(f"为锚点 {anchor_text} 找到桩代码")
-                            # 添加到桩点列表，在锚点所在行的下一行插入
-                            stub_points.append(
-                                {
-                                    'test_case_id': anchor_text,
-                                    'code': code,
-                                    'line_number': i + 1,  # 在当前锚点行之后插入
-                                    'original_line': i,
-                                    'file': file_path,
-                                    'format': 'new',  # 标记为新格式
-                                }
-                            )
-                        else:
-                            logger.warning(f"未找到锚点 {anchor_text} 对应的桩代码")
-                            self.missing_anchors.append({'file': file_path, 'line': i + 1, 'anchor': anchor_text})
-                    else:
-                        logger.warning(
-                            f"锚点 '{anchor_text}' 格式不正确, 无法解析出三个部分 (TC_ID, STEP_ID, segment_ID)"
-                        )
-                except Exception as e:
-                    logger.error(f"解析锚点时发生错误: {anchor_text}, 错误: {e}")
-        
-        # 如果文件中没有找到锚点，记录文件信息，供外部提示
-        if not found_anchors:
-            logger.info(f"文件 {file_path} 中未找到锚点")
-            self.files_without_anchors.append(file_path)
-        
-        logger.info(f"文件 {file_path} 将插入 {len(stub_points)} 个桩点")
-        return stub_points
+        anchors = weave_engine.scan(lines)
+        insertions, missing = weave_engine.resolve(anchors, self._make_lookup(file_path, lines))
+        self._record_scan(file_path, True, anchors, missing, file_result)
+        return [self._to_stub_point(file_path, ins) for ins in insertions]
     
     def parse_traditional_format(self, file_path: str, lines: List[str]) -> List[Dict[str, Any]]:
         """
@@ -283,57 +246,80 @@ class StubParser:
         Returns:
             List[Dict[str, Any]]: 解析出的桩点列表
         """
-        stub_points = []
-        i = 0
-        while i < len(lines):
-            line = lines[i]
-            # 查找测试用例ID注释
-            match = self.test_case_pattern.search(line)
-            if match:
-                test_case_id = match.group(1)
-                code = None
-                insert_line = i
-                
-                # 检查下一行是否包含code字段
-                if i + 1 < len(lines):
-                    next_line = lines[i + 1]
-                    
-                    # 处理单行代码
-                    code_match = self.single_line_code_pattern.search(next_line)
-                    if code_match:
-                        code = code_match.group(1)
-                        insert_line = i + 1
-                    
-                    # 处理多行代码
-                    elif self.multi_line_start in next_line:
-                        code_lines = []
-                        j = i + 2
-                        while j < len(lines) and self.multi_line_end not in lines[j]:
-                            code_lines.append(lines[j])
-                            j += 1
-                        
-                        if code_lines:
-                            code = '\n'.join(code_lines)
-                            insert_line = j if j < len(lines) else i + 1
-                
-                if code:
-                    logger.info(f"找到传统格式桩点: {test_case_id} (行 {i+1})")
-                    stub_points.append({
-                        'test_case_id': test_case_id,
-                        'code': code,
-                        'line_number': insert_line + 1,
-                        'original_line': i,
-                        'file': file_path,
-                        'format': 'traditional'  # 标记为传统格式
-                    })
+        insertions, _ = weave_engine.resolve(weave_engine.scan_traditional(lines))
+        return [self._to_stub_point(file_path, ins) for ins in insertions]
+    
+    def _make_lookup(self, file_path: str, lines: List[str]):
+        """创建按锚点查找桩代码的函数，模板代码段按锚点上下文渲染"""
+        return make_anchor_lookup(self.yaml_handler.get_stub_code, file_path, lines)
+    
+    @staticmethod
+    def _record_scan(file_path: str, scanned: bool, anchors, missing, file_result) -> None:
+        """记录锚点扫描结果：缺失的桩代码与无锚点文件"""
+        for anchor in missing:
+            logger.debug("未找到锚点 %s 对应的桩代码 (%s:%d)", anchor.text, file_path, anchor.line_index + 1)
+        if file_result is None or not scanned:
+            return
+        file_result.anchor_keys = frozenset(
+            (anchor.test_case_id, anchor.step_id, anchor.segment_id) for anchor in anchors
+        )
+        file_result.missing_anchors.extend(
+            {'file': file_path, 'line': anchor.line_index + 1, 'anchor': anchor.text}
+            for anchor in missing
+        )
+        if not anchors:
+            logger.debug("文件 %s 中未找到锚点", file_path)
+            file_result.has_anchors = False
+    
+    @staticmethod
+    def _to_stub_point(file_path: str, insertion: weave_engine.Insertion) -> Dict[str, Any]:
+        """将插入项转换为旧接口使用的桩点字典"""
+        anchor = insertion.anchor
+        return {
+            'test_case_id': anchor.text,
+            'code': insertion.code,
+            'line_number': insertion.insert_after + 1,  # 在该行之后插入
+            'original_line': anchor.line_index,
+            'file': file_path,
+            'format': anchor.format,
+        }
+    
+    def weave_content(self, file_path: str, content: str, file_result=None,
+                      callback=None) -> Tuple[Optional[str], int]:
+        """
+        在内存中完成单个文件的插桩，不写入任何文件
+        
+        Args:
+            file_path: 文件路径（用于日志和模板上下文）
+            content: 文件内容
+            file_result: 可选的文件结果对象，用于记录缺失锚点等信息
+            callback: 可选回调函数，插桩完成后报告一次进度
             
-            i += 1
+        Returns:
+            Tuple[Optional[str], int]: (插桩后的内容, 插入桩点数量)，无桩点时内容为None
+        """
+        lines = content.splitlines()
+        insertions = self.collect_insertions(file_path, lines, file_result)
         
-        return stub_points
-    
+        if not insertions:
+            logger.debug("文件中未找到需要插入的桩点: %s", file_path)
+            return None, 0
+        
+        timings = getattr(file_result, 'timings', None)
+        if timings is not None:
+            start = time.perf_counter()
+            new_lines = weave_engine.splice(lines, insertions)
+            new_content = "\n".join(new_lines)
+            timings['splice'] = timings.get('splice', 0.0) + (time.perf_counter() - start)
+        else:
+            new_content = "\n".join(weave_engine.splice(lines, insertions))
+        if callback:
+            callback(100, f"处理文件 {os.path.basename(file_path)}: 插入桩点 {len(insertions)} 个")
+        return new_content, len(insertions)
+
     def process_file(self, file_path: str, callback=None) -> Tuple[bool, str, int]:
         """
-        处理单个文件，插入桩代码
+        处理单个文件，插入桩代码并写入 ``<file>.stub``
         
         Args:
             file_path: 文件路径
@@ -348,54 +334,15 @@ class StubParser:
             if content is None:
                 return False, f"无法读取文件: {file_path}", 0
             
-            # 解析文件中的桩点
-            stub_points = self.parse_file(file_path, content)
-            
-            if not stub_points:
-                logger.info(f"文件中未找到需要插入的桩点: {file_path}")
+            new_content, count = self.weave_content(file_path, content, callback=callback)
+            if not count:
                 return True, "无需更新", 0
-                
-            # 按行号逆序排序，从后往前插入，避免行号变化
-            stub_points.sort(key=lambda x: x['line_number'], reverse=True)
-            
-            # 分割内容为行
-            lines = content.splitlines()
-            total_lines = len(lines)
-            
-            # 插入桩代码
-            for i, stub_point in enumerate(stub_points):
-                # 调用进度回调
-                if callback:
-                    progress = int((i / len(stub_points)) * 100)
-                    callback(progress, f"处理文件 {os.path.basename(file_path)}: 插入桩点 {i+1}/{len(stub_points)}")
-                
-                line_num = stub_point['line_number']
-                line_num = min(line_num, total_lines)  # 确保不超出范围
-                
-                # 获取缩进级别
-                indent = ''
-                if line_num > 0 and line_num <= total_lines:
-                    # 计算前导空格
-                    current_line = lines[line_num - 1]
-                    indent_match = re.match(r'^(\s*)', current_line)
-                    if indent_match:
-                        indent = indent_match.group(1)
-                
-                # 处理多行代码，为每行添加相同缩进和注释标记
-                code_lines = stub_point['code'].splitlines()
-                formatted_code = []
-                for code_line in code_lines:
-                    formatted_code.append(f"{indent}{code_line}  // 通过桩插入")
-                
-                # 在指定位置插入代码
-                lines.insert(line_num, "\n".join(formatted_code))
             
             # 将处理后的内容写回文件
-            new_content = "\n".join(lines)
             success = write_file(file_path, new_content, encoding)
             
             if success:
-                return True, f"成功处理文件，插入了 {len(stub_points)} 个桩点", len(stub_points)
+                return True, f"成功处理文件，插入了 {count} 个桩点", count
             else:
                 return False, "写入文件失败", 0
                 
@@ -420,24 +367,19 @@ class StubParser:
                 line = lines[i]
                 match = self.anchor_pattern.search(line)
                 if match:
-                    anchor_text = match.group(1).strip()
-                    parts = anchor_text.split()
-                    if len(parts) >= 3:
-                        tc_id, step_id, seg_id = parts[0], parts[1], parts[2]
-                        i += 1
-                        code_lines = []
-                        while i < len(lines) and '通过桩插入' in lines[i]:
-                            cleaned = lines[i].split('//')[0].rstrip()
-                            code_lines.append(cleaned)
-                            i += 1
-                        stubs.append({
-                            'test_case_id': tc_id,
-                            'step_id': step_id,
-                            'segment_id': seg_id,
-                            'code': '\n'.join(code_lines)
-                        })
-                    else:
+                    tc_id, step_id, seg_id = match.group(1), match.group(2), match.group(3)
+                    i += 1
+                    code_lines = []
+                    while i < len(lines) and '通过桩插入' in lines[i]:
+                        cleaned = lines[i].split('//')[0].rstrip()
+                        code_lines.append(cleaned)
                         i += 1
+                    stubs.append({
+                        'test_case_id': tc_id,
+                        'step_id': step_id,
+                        'segment_id': seg_id,
+                        'code': '\n'.join(code_lines)
+                    })
                 else:
                     i += 1
             return stubs
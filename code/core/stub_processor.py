@@ -9,10 +9,12 @@ import os
 import sys
 import re
 import logging
-from pathlib import Path
 from typing import Dict, List, Tuple, Set, Optional, Any, Union
 import datetime
 import shutil
+import time
+from concurrent.futures import ThreadPoolExecutor
+from dataclasses import replace
 
 # 导入日志工具
 try:
@@ -48,7 +50,7 @@ except ImportError:
         except ImportError:
             logger.error("无法导入文件处理工具函数，功能可能受限")
             # 提供简单实现以防止崩溃
-            def read_file(file_path):
+            def read_file(file_path, timings=None):
                 """简单的文件读取函数"""
                 try:
                     with open(file_path, 'r', encoding='utf-8', errors='replace') as f:
@@ -67,6 +69,23 @@ except ImportError:
                     logger.error(f"写入文件失败: {str(e)}")
                     return False
 
+try:
+    from .utils import write_output_file, copy_output_file
+except ImportError:
+    from code.core.utils import write_output_file, copy_output_file
+
+# 导入运行配置与上下文
+try:
+    from .weave_context import WeaveConfig, RunContext, FileResult, CancelToken
+    from .progress import ProgressTracker
+    from .anchor_index import AnchorIndex, yaml_state
+    from .timing import PhaseTimer, add_elapsed, measure, memory_phase
+except ImportError:
+    from code.core.weave_context import WeaveConfig, RunContext, FileResult, CancelToken
+    from code.core.progress import ProgressTracker
+    from code.core.anchor_index import AnchorIndex, yaml_state
+    from code.core.timing import PhaseTimer, add_elapsed, measure, memory_phase
+
 # 定义模拟类，当实际类无法加载时使用
 class MockYamlStubHandler:
     def __init__(self, yaml_file_path=None):
@@ -80,7 +99,7 @@ class MockYamlStubHandler:
         self.logger.info(f"模拟加载YAML文件: {yaml_file_path}")
         return True
     
-    def get_stub_code(self, test_case_id, step_id, segment_id):
+    def get_stub_code(self, test_case_id, step_id, segment_id, context=None):
         self.logger.warning(f"模拟获取桩代码: {test_case_id}.{step_id}.{segment_id}")
         return None
     
@@ -327,207 +346,347 @@ class StubProcessor:
             self.logger.error(error_msg)
             return False, error_msg, 0
     
-    def process_directory(self, root_dir: str, callback=None) -> Dict[str, Any]:
+    @staticmethod
+    def prepare_config(config: WeaveConfig) -> WeaveConfig:
+        """为运行配置创建各文件共用的解析器（使用配置中的YAML处理器快照）"""
+        return replace(config, parser=StubParser(config.yaml_handler))
+    
+    def weave_file(self, config: WeaveConfig, file_path: str,
+                   cancel_token: Optional[CancelToken] = None) -> FileResult:
+        """
+        在内存中处理单个文件，返回独立的文件结果
+        
+        本方法不修改处理器或解析器的任何状态，可在多个线程中同时调用。
+        
+        Args:
+            config: 本次运行的配置
+            file_path: 文件路径
+            cancel_token: 取消标志，暂停时在开始处理前等待
+            
+        Returns:
+            FileResult: 文件处理结果，插桩后的内容保存在 ``new_content`` 中
+        """
+        tracer = config.tracer
+        if tracer is not None:
+            with tracer.span(os.path.basename(file_path), 'file', {"file": file_path}):
+                return self._weave_file(config, file_path, cancel_token)
+        return self._weave_file(config, file_path, cancel_token)
+    
+    def _weave_file(self, config: WeaveConfig, file_path: str,
+                    cancel_token: Optional[CancelToken]) -> FileResult:
+        """:meth:`weave_file` 的实现"""
+        file_result = FileResult(file_path)
+        if config.tracer is not None:
+            file_result.timings = config.tracer.file_timings(file_path)
+        elif config.timings:
+            file_result.timings = {}
+        if cancel_token is not None and not cancel_token.checkpoint():
+            file_result.success = False
+            file_result.message = "已取消"
+            return file_result
+        if self.using_mocks:
+            self.logger.warning("使用模拟处理: %s", file_path)
+            file_result.message = "成功 (模拟)"
+            return file_result
+        
+        # 索引中签名未变的文件直接复用上次的结果，无需读取；
+        # 有插入的文件只在固定结果目录中的结果文件未被改动时复用，此时也无需重写
+        index = config.anchor_index
+        signature = None
+        state = None
+        if index is not None:
+            signature = AnchorIndex.signature(file_path)
+            state = yaml_state(config.yaml_handler)
+            output_path = config.output_path(file_path) if config.incremental else None
+            entry = index.get(file_path, signature, state, output_path)
+            if entry is not None:
+                file_result.size = signature[1]
+                file_result.cache_hit = True
+                file_result.has_anchors = entry.has_anchors
+                file_result.inserted = entry.inserted
+                file_result.missing_anchors = [dict(m) for m in entry.missing_anchors]
+                file_result.anchor_keys = entry.anchor_keys
+                file_result.output_current = AnchorIndex.output_current(entry, output_path)
+                file_result.message = f"插入了 {entry.inserted} 个桩点" if entry.inserted else "无需更新"
+                return file_result
+        
+        try:
+            file_result.size = signature[1] if signature else _file_size(file_path)
+            content, encoding = read_file(file_path, file_result.timings)
+            if content is None:
+                file_result.success = False
+                file_result.message = f"无法读取文件: {file_path}"
+                return file_result
+            file_result.bytes_read = file_result.size
+            
+            parser = config.parser
+            if parser is None:
+                parser = self.parser
+                if parser.yaml_handler is not config.yaml_handler:
+                    parser = StubParser(config.yaml_handler)
+            new_content, count = parser.weave_content(file_path, content, file_result)
+            if config.memory is not None:
+                config.memory.checkpoint()
+            file_result.encoding = encoding
+            file_result.new_content = new_content
+            file_result.inserted = count
+            file_result.message = f"插入了 {count} 个桩点" if count else "无需更新"
+            if index is not None:
+                index.put(file_path, signature, file_result.has_anchors, count,
+                          file_result.missing_anchors, file_result.anchor_keys, state)
+        except Exception as e:
+            file_result.success = False
+            file_result.message = f"处理文件内容失败: {file_path}, 错误: {str(e)}"
+            self.logger.error(file_result.message)
+        return file_result
+    
+    def process_directory(self, root_dir: str, callback=None,
+                          backup_dir: Optional[str] = None,
+                          stubbed_dir: Optional[str] = None,
+                          max_workers: int = 1,
+                          progress: Optional[ProgressTracker] = None,
+                          cancel_token: Optional[CancelToken] = None,
+                          create_sample: bool = True,
+                          anchor_index: Optional[AnchorIndex] = None,
+                          incremental: bool = False,
+                          depfiles: bool = False,
+                          timer: Optional[PhaseTimer] = None) -> Dict[str, Any]:
         """
         处理目录中的所有文件
         
+        每次调用都会创建独立的 :class:`WeaveConfig` 与 :class:`RunContext`，
+        处理器实例上不保存任何运行期状态，因此同一处理器可被并发调用。
+        
         Args:
             root_dir: 根目录路径
             callback: 可选回调函数，用于报告处理进度
+            backup_dir: 备份目录，未指定时按时间戳生成
+            stubbed_dir: 插桩结果目录，未指定时按时间戳生成
+            max_workers: 并行处理文件的线程数，默认顺序处理
+            progress: 进度计数器，未指定时新建；UI支持时交给UI定时采样
+            cancel_token: 取消与暂停标志；取消时已合并的文件保留在结果目录中，
+                其余文件记录在结果的 ``unprocessed_files`` 中
+            create_sample: 目录中没有.c文件时是否创建示例文件
+            anchor_index: 跨运行复用的锚点索引，用于跳过未变化的文件；
+                有插入的文件只在 ``incremental`` 为True时复用
+            incremental: ``stubbed_dir`` 为跨运行复用的固定目录时为True，
+                所有.c文件都写入结果目录，内容未变化的文件不重写
+            depfiles: 是否在结果目录的 ``.yamlweave`` 中为每个结果文件写出依赖文件
+                与代码段指纹文件
+            timer: 可选的 :class:`PhaseTimer`；指定时统计各处理阶段的耗时，
+                结果中的 ``timings`` 包含各阶段总耗时与单文件耗时直方图。
+                调用方可用同一计时器统计备份等运行前后的阶段；
+                计时器带有 ``tracer`` 时同时记录每个文件与各阶段的跟踪区间，
+                带有 ``memory`` 时按阶段（含处理全部文件的 ``weave``）统计内存
             
         Returns:
             Dict[str, Any]: 处理结果统计信息
         """
-        result = {
-            "total_files": 0,
-            "processed_files": 0,
-            "successful_stubs": 0,
-            "errors": [],
-            "backup_dir": None,
-            "stubbed_dir": None,
-            "missing_stubs": 0
-        }
+        config = self.prepare_config(WeaveConfig.create(root_dir, self.yaml_handler, backup_dir, stubbed_dir,
+                                                        max_workers, anchor_index, incremental))
+        if depfiles:
+            # 依赖文件模块（及hashlib）只在需要写出依赖文件时导入
+            try:
+                from .depfile import DepfileWriter
+            except ImportError:
+                from code.core.depfile import DepfileWriter
+            config = replace(config, depfiles=DepfileWriter(config.stubbed_dir))
+        if timer is not None:
+            config = replace(config, timings=True, tracer=timer.tracer, memory=timer.memory)
+        context = RunContext(config, progress, cancel_token, timer)
+        token = context.cancel_token
+        if self.ui and hasattr(self.ui, "track_progress"):
+            self.ui.track_progress(context.progress)
 
         # 实际处理目录
         try:
             # 检查目录是否存在
             if not os.path.isdir(root_dir):
-                result["errors"].append({"file": "N/A", "error": f"目录不存在: {root_dir}"})
-                return result
-            
-            # 创建备份和结果目录（如果不存在）
-            timestamp = datetime.datetime.now().strftime("%Y%m%d_%H%M%S")
-            backup_dir = getattr(self, 'backup_dir', f"{root_dir}_backup_{timestamp}")
-            stubbed_dir = getattr(self, 'stubbed_dir', f"{root_dir}_stubbed_{timestamp}")
-            
-            # 保存目录信息
-            self.backup_dir = backup_dir
-            self.stubbed_dir = stubbed_dir
-            
-            # 将目录信息添加到结果中
-            result["backup_dir"] = backup_dir
-            result["stubbed_dir"] = stubbed_dir
-
-            # 重置缺失桩代码统计
-            if hasattr(self, 'parser') and hasattr(self.parser, 'missing_anchors'):
-                self.parser.missing_anchors = []
-            # 重置无锚点文件列表
-            if hasattr(self, 'parser') and hasattr(self.parser, 'files_without_anchors'):
-                self.parser.files_without_anchors = []
+                context.add_error("N/A", f"目录不存在: {root_dir}")
+                return context.to_result()
 
             # 查找所有C文件
-            c_files = find_c_files(root_dir)
-            result["total_files"] = len(c_files)
+            with measure(timer, 'discovery'):
+                c_files = find_c_files(root_dir, create_sample)
+            context.total_files = len(c_files)
+            context.progress.start(len(c_files), sum(_file_size(fp) for fp in c_files))
             
-            # 处理每个文件
-            for i, file_path in enumerate(c_files):
-                try:
-                    # 更新进度显示
-                    if hasattr(self, 'ui') and self.ui and hasattr(self.ui, "update_progress"):
-                        percentage = int((i / result["total_files"]) * 100) if result["total_files"] > 0 else 0
-                        current_file = os.path.basename(file_path)
-                        print(f"[DEBUG][{datetime.datetime.now()}] before after: percent={percentage}, file={current_file}")
-                        self.ui.root.after(0, self.ui.update_progress, percentage, f"处理: {current_file}", i, result["total_files"])
-                        print(f"[DEBUG][{datetime.datetime.now()}] after after: percent={percentage}, file={current_file}")
-                        if hasattr(self.ui.root, "update_idletasks"):
-                            self.ui.root.update_idletasks()
-                    
-                    # 读取文件内容
-                    try:
-                        with open(file_path, 'r', encoding='utf-8') as f:
-                            content = f.read()
-                    except UnicodeDecodeError:
-                        # 尝试其他编码
-                        try:
-                            with open(file_path, 'r', encoding='gbk') as f:
-                                content = f.read()
-                            self.logger.info(f"使用GBK编码成功读取文件: {file_path}")
-                        except Exception as enc_error:
-                            error_msg = f"无法读取文件: {file_path}, 错误: {str(enc_error)}"
-                            self.logger.error(error_msg)
-                            result["errors"].append({"file": file_path, "error": error_msg})
-                            continue
-                    except Exception as f_error:
-                        error_msg = f"读取文件失败: {file_path}, 错误: {str(f_error)}"
-                        self.logger.error(error_msg)
-                        result["errors"].append({"file": file_path, "error": error_msg})
-                        continue
-                    
-                    # 处理文件
-                    success, message, count = self.process_file(file_path, callback)
-                    updated = (count > 0)
-                    
-                    if success:
-                        result["processed_files"] += 1
-                        result["successful_stubs"] += count
-                        
-                        # 处理.stub文件并复制到结果目录
-                        try:
-                            # 获取相对路径
-                            rel_path = os.path.relpath(file_path, root_dir)
-                            stub_file_path = os.path.join(stubbed_dir, rel_path)
-                            
-                            # 确保目标目录存在
-                            stub_dir = os.path.dirname(stub_file_path)
-                            os.makedirs(stub_dir, exist_ok=True)
-                            
-                            # 复制.stub文件到结果目录，并重命名为原文件名
-                            source_stub = file_path + ".stub"
-                            if os.path.exists(source_stub):
-                                with open(source_stub, 'r', encoding='utf-8', errors='replace') as f:
-                                    stub_content = f.read()
-                                with open(stub_file_path, 'w', encoding='utf-8', errors='replace') as f:
-                                    f.write(stub_content)
-                                self.logger.info(f"复制处理后文件到结果目录: {stub_file_path}")
-                                
-                                # 删除原始.stub文件(清理)
-                                try:
-                                    os.remove(source_stub)
-                                except:
-                                    pass
-                            else:
-                                self.logger.warning(f"找不到处理后的.stub文件: {source_stub}")
-                        except Exception as copy_error:
-                            self.logger.error(f"复制文件到结果目录失败: {str(copy_error)}")
+            # 文件结果按原顺序逐个合并；多线程时工作线程只生成各自的FileResult
+            merged = 0
+            if token.checkpoint():
+                with memory_phase(timer, 'weave'):
+                    if config.max_workers > 1 and len(c_files) > 1:
+                        executor = ThreadPoolExecutor(max_workers=config.max_workers, thread_name_prefix="weave")
+                        file_results = executor.map(lambda fp: self.weave_file(config, fp, token), c_files)
                     else:
-                        result["errors"].append({"file": file_path, "error": message})
-                    
-                    # 进度回调
-                    if callback:
-                        callback(file_path, updated)
-                    
-                except Exception as p_error:
-                    error_msg = f"处理文件内容失败: {file_path}, 错误: {str(p_error)}"
-                    self.logger.error(error_msg)
-                    result["errors"].append({"file": file_path, "error": error_msg})
-                    # 更新错误状态的进度
-                    if hasattr(self, 'ui') and self.ui and hasattr(self.ui, "update_progress"):
-                        percentage = int(((i + 1) / result["total_files"]) * 100) if result["total_files"] > 0 else 0
-                        print(f"[DEBUG][{datetime.datetime.now()}] before after: percent={percentage}, file=处理出错: {os.path.basename(file_path)}")
-                        self.ui.root.after(0, self.ui.update_progress, percentage, f"处理出错: {os.path.basename(file_path)}", i+1, result["total_files"])
-                        print(f"[DEBUG][{datetime.datetime.now()}] after after: percent={percentage}, file=处理出错: {os.path.basename(file_path)}")
-                        if hasattr(self.ui.root, "update_idletasks"):
-                            self.ui.root.update_idletasks()
-                    continue
+                        executor = None
+                        file_results = (self.weave_file(config, fp, token) for fp in c_files)
+                
+                    try:
+                        for i, file_result in enumerate(file_results):
+                            # 取消后不再合并任何结果，结果目录中只保留已完整写入的文件
+                            if not token.checkpoint():
+                                break
+                            self._merge_file_result(config, context, file_result, i, callback)
+                            merged += 1
+                    finally:
+                        if executor:
+                            executor.shutdown(wait=True, cancel_futures=True)
+            if merged < len(c_files):
+                context.mark_cancelled(c_files[merged:])
             
             # 最终完成进度更新
-            if hasattr(self, 'ui') and self.ui and hasattr(self.ui, "update_progress"):
-                percentage = int(100)
-                print(f"[DEBUG][{datetime.datetime.now()}] before after: percent=100, file=处理完成")
-                self.ui.root.after(0, self.ui.update_progress, 100, "处理完成", result["total_files"], result["total_files"])
-                print(f"[DEBUG][{datetime.datetime.now()}] after after: percent=100, file=处理完成")
-                if hasattr(self.ui.root, "update_idletasks"):
-                    self.ui.root.update_idletasks()
+            context.progress.finish()
+            if context.cancelled:
+                self._report_progress(int(merged * 100 / len(c_files)), "已取消", merged, len(c_files))
+            else:
+                self._report_progress(100, "处理完成", context.total_files, context.total_files)
             
             self.logger.info(f"目录处理完成: {root_dir}")
-            self.logger.info(f"总文件数: {result['total_files']}")
-            self.logger.info(f"处理文件数: {result['processed_files']}")
-            self.logger.info(f"插入桩点数: {result['successful_stubs']}")
-            if result["errors"]:
-                self.logger.warning(f"处理错误数: {len(result['errors'])}")
-
-            # 统计缺失的桩代码锚点，并记录详细信息
-            missing_list = getattr(self.parser, 'missing_anchors', [])
-            missing_count = len(missing_list)
-            result["missing_stubs"] = missing_count
-            result["missing_anchor_details"] = missing_list
-            if missing_count > 0:
-                self.logger.warning(f"缺失桩代码锚点数: {missing_count}")
-                if hasattr(self, 'ui') and self.ui:
-                    self.ui.log(f"[警告] 缺失桩代码锚点共 {missing_count} 个", tag="warning")
-                    for entry in missing_list:
-                        rel_file = os.path.relpath(entry.get('file', ''), root_dir)
-                        line = entry.get('line', '')
-                        anchor = entry.get('anchor', '')
-                        msg = f"{rel_file} 第 {line} 行: {anchor} 未在YAML中找到"
-                        self.ui.log(f"[缺失] {msg}", tag="missing")
-                    if hasattr(self.ui, 'update_status'):
-                        self.ui.update_status(f"缺失桩代码 {missing_count} 个")
-
-            # 统计未发现锚点的文件列表
-            no_anchor_files = getattr(self.parser, 'files_without_anchors', [])
-            result["files_without_anchors"] = [os.path.relpath(p, root_dir) for p in no_anchor_files]
-            if no_anchor_files:
-                self.logger.info(f"未发现锚点的文件数: {len(no_anchor_files)}")
-                if hasattr(self, 'ui') and self.ui:
-                    self.ui.log("[信息] 以下文件未找到锚点:", tag="warning")
-                    for fp in result["files_without_anchors"][:10]:
-                        self.ui.log(f"└─ {fp}", tag="warning")
-                    if len(no_anchor_files) > 10:
-                        self.ui.log(f"...还有{len(no_anchor_files)-10}个未显示...", tag="info")
+            self.logger.info(f"总文件数: {context.total_files}")
+            self.logger.info(f"处理文件数: {context.processed_files}")
+            self.logger.info(f"插入桩点数: {context.successful_stubs}")
+            if context.errors:
+                self.logger.warning(f"处理错误数: {len(context.errors)}")
         except Exception as e:
             error_msg = f"处理目录时出错: {str(e)}"
             self.logger.error(error_msg)
-            result["errors"].append({"file": "N/A", "error": error_msg})
+            context.add_error("N/A", error_msg)
         
+        result = context.to_result()
+        self._report_missing(root_dir, result)
+        if result["cancelled"]:
+            self._report_cancelled(result)
         return result
     
-    def process_files(self, callback=None) -> Tuple[bool, str, Dict[str, Any]]:
+    def check_directory(self, root_dir: str, scan_cache=None,
+                        max_workers: int = 1) -> Dict[str, Any]:
+        """
+        检查目录中的锚点，不插桩也不写出任何文件（见 :mod:`lint`）
+        
+        Args:
+            root_dir: 根目录路径
+            scan_cache: 可选的扫描结果缓存（:class:`lint.ScanCache`），签名未变的文件不再读取
+            max_workers: 并行读取文件的线程数
+            
+        Returns:
+            Dict[str, Any]: 与 :meth:`process_directory` 兼容的统计信息（不含输出目录），
+            另有格式错误的锚点与未引用的代码段
+        """
+        # 插桩不需要检查模块，只在检查时导入
+        try:
+            from .lint import lint_directory
+        except ImportError:
+            from code.core.lint import lint_directory
+        return lint_directory(root_dir, self.yaml_handler, cache=scan_cache, max_workers=max_workers)
+    
+    def _merge_file_result(self, config: WeaveConfig, context: RunContext,
+                           file_result: FileResult, index: int, callback=None) -> None:
+        """合并单个文件结果，并将插桩内容写入结果目录"""
+        file_path = file_result.file_path
+        timings = file_result.timings
+        counters = {}
+        
+        if file_result.success and file_result.output_current:
+            # 按索引复用的结果，结果文件与上次写出时相同
+            pass
+        elif file_result.success and file_result.updated:
+            stub_file_path = config.output_path(file_path)
+            start = time.perf_counter() if timings is not None else 0.0
+            if not write_output_file(stub_file_path, file_result.new_content, file_result.encoding,
+                                     only_if_changed=config.incremental, counters=counters):
+                file_result.success = False
+                file_result.message = f"写入结果文件失败: {stub_file_path}"
+            if timings is not None:
+                add_elapsed(timings, 'write', start)
+        elif file_result.success and config.incremental:
+            # 固定结果目录中可能还留有上次插桩的内容，需要同步为原文件
+            stub_file_path = config.output_path(file_path)
+            start = time.perf_counter() if timings is not None else 0.0
+            if not copy_output_file(file_path, stub_file_path, only_if_changed=True, counters=counters):
+                file_result.success = False
+                file_result.message = f"写入结果文件失败: {stub_file_path}"
+            if timings is not None:
+                add_elapsed(timings, 'copy', start)
+        if (file_result.success and config.incremental and config.anchor_index is not None
+                and not file_result.output_current):
+            config.anchor_index.set_output(file_path, config.output_path(file_path))
+        
+        if file_result.success and config.depfiles is not None:
+            if not config.depfiles.update(config.root_dir, file_path, file_result.anchor_keys,
+                                          config.yaml_handler):
+                file_result.success = False
+                file_result.message = f"写入依赖文件失败: {file_path}"
+        
+        # 每个文件只输出一条汇总日志，锚点级别的细节在DEBUG级别输出
+        if not file_result.success:
+            self.logger.warning("文件处理失败: %s, %s", file_path, file_result.message)
+        elif file_result.missing_anchors:
+            self.logger.info("处理文件 %s: 插入 %d 个桩点, 缺失 %d 个",
+                             file_path, file_result.inserted, len(file_result.missing_anchors))
+        else:
+            self.logger.info("处理文件 %s: 插入 %d 个桩点", file_path, file_result.inserted)
+        file_result.bytes_written = counters.get('bytes_written', 0)
+        # 内容已写出，不再保留在内存中
+        file_result.new_content = None
+        context.merge(file_result)
+        
+        if callback:
+            callback(file_path, file_result.updated)
+    
+    def _report_progress(self, percentage: int, status_text: str, current: int, total: int) -> None:
+        """更新进度显示（UI内部排队，由主线程定时刷新）"""
+        if self.ui and hasattr(self.ui, "update_progress"):
+            self.ui.update_progress(percentage, status_text, current, total)
+    
+    def _report_cancelled(self, result: Dict[str, Any]) -> None:
+        """记录取消时已处理与未处理的文件"""
+        unprocessed = result["unprocessed_files"]
+        done = result["total_files"] - len(unprocessed)
+        message = f"处理已取消: 已完成 {done} 个文件, 未处理 {len(unprocessed)} 个文件"
+        self.logger.warning(message)
+        for rel_path in unprocessed:
+            self.logger.debug("未处理文件: %s", rel_path)
+        if self.ui:
+            self.ui.log(f"[取消] {message}", tag="warning")
+            self.ui.log("[取消] 结果目录中未处理的文件保持原样", tag="warning")
+    
+    def _report_missing(self, root_dir: str, result: Dict[str, Any]) -> None:
+        """记录缺失锚点与无锚点文件信息"""
+        missing_list = result["missing_anchor_details"]
+        missing_count = len(missing_list)
+        if missing_count > 0:
+            self.logger.warning(f"缺失桩代码锚点数: {missing_count}")
+            if self.ui:
+                self.ui.log(f"[警告] 缺失桩代码锚点共 {missing_count} 个", tag="warning")
+                for entry in missing_list:
+                    rel_file = os.path.relpath(entry.get('file', ''), root_dir)
+                    line = entry.get('line', '')
+                    anchor = entry.get('anchor', '')
+                    msg = f"{rel_file} 第 {line} 行: {anchor} 未在YAML中找到"
+                    self.ui.log(f"[缺失] {msg}", tag="missing")
+                if hasattr(self.ui, 'update_status'):
+                    self.ui.update_status(f"缺失桩代码 {missing_count} 个")
+
+        no_anchor_files = result["files_without_anchors"]
+        if no_anchor_files:
+            self.logger.info(f"未发现锚点的文件数: {len(no_anchor_files)}")
+            if self.ui:
+                self.ui.log("[信息] 以下文件未找到锚点:", tag="warning")
+                for fp in no_anchor_files[:10]:
+                    self.ui.log(f"└─ {fp}", tag="warning")
+                if len(no_anchor_files) > 10:
+                    self.ui.log(f"...还有{len(no_anchor_files)-10}个未显示...", tag="info")
+    
+    def process_files(self, callback=None, backup_dir: Optional[str] = None,
+                      stubbed_dir: Optional[str] = None) -> Tuple[bool, str, Dict[str, Any]]:
         """
         处理文件并插入桩代码（与MinimalStubProcessor接口兼容）
         
         Args:
             callback: 可选的进度回调函数，接受文件路径和更新状态参数
+            backup_dir: 备份目录，可选
+            stubbed_dir: 插桩结果目录，可选
             
         Returns:
             Tuple[bool, str, Dict[str, Any]]: (成功/失败, 消息, 统计信息)
@@ -539,7 +698,7 @@ class StubProcessor:
             return False, error_msg, {}
         
         # 初始化统计信息
-        self.stats = {
+        stats = {
             "scanned_files": 0,
             "updated_files": 0,
             "inserted_stubs": 0,
@@ -548,29 +707,35 @@ class StubProcessor:
         
         try:
             # 处理目录
-            result = self.process_directory(self.project_dir, callback)
+            result = self.process_directory(self.project_dir, callback,
+                                            backup_dir=backup_dir, stubbed_dir=stubbed_dir)
             
             # 更新统计信息
-            self.stats["scanned_files"] = result["total_files"]
-            self.stats["updated_files"] = result["processed_files"]
-            self.stats["inserted_stubs"] = result["successful_stubs"]
-            self.stats["failed_files"] = len(result["errors"])
-            self.stats["missing_stubs"] = result.get("missing_stubs", 0)
+            stats["scanned_files"] = result["total_files"]
+            stats["updated_files"] = result["processed_files"]
+            stats["inserted_stubs"] = result["successful_stubs"]
+            stats["failed_files"] = len(result["errors"])
+            stats["missing_stubs"] = result.get("missing_stubs", 0)
+            stats["bytes_read"] = result.get("bytes_read", 0)
+            stats["bytes_written"] = result.get("bytes_written", 0)
+            stats["cache_hits"] = result.get("cache_hits", 0)
+            stats["backup_dir"] = result["backup_dir"]
+            stats["stubbed_dir"] = result["stubbed_dir"]
             
             # 检查是否有错误
             if result["errors"]:
                 error_msg = f"处理过程中发生 {len(result['errors'])} 个错误"
                 self.logger.warning(error_msg)
-                return False, error_msg, self.stats
+                return False, error_msg, stats
             
-            return True, "处理完成", self.stats
+            return True, "处理完成", stats
             
         except Exception as e:
             error_msg = f"处理文件过程中发生错误: {str(e)}"
             self.logger.error(error_msg)
             import traceback
             self.logger.error(traceback.format_exc())
-            return False, error_msg, self.stats
+            return False, error_msg, stats
 
     def extract_to_yaml(self, root_dir: str, output_file: str) -> bool:
         """根据已插入的桩代码生成YAML配置"""
@@ -625,8 +790,21 @@ class StubProcessor:
             return False
 
 # 辅助函数
-def find_c_files(root_dir):
-    """查找目录下所有.c文件"""
+def _file_size(file_path):
+    """返回文件字节数，无法访问时返回0"""
+    try:
+        return os.path.getsize(file_path)
+    except OSError:
+        return 0
+
+def find_c_files(root_dir, create_sample=True):
+    """
+    查找目录下所有.c文件
+    
+    Args:
+        root_dir: 根目录
+        create_sample: 未找到任何.c文件时是否创建示例文件；命令行模式下关闭
+    """
     files = []
     logger.info(f"在目录 {root_dir} 中查找.c源文件")
     
@@ -646,22 +824,22 @@ def find_c_files(root_dir):
         # 输出目录内容
         try:
             top_files = os.listdir(root_dir)
-            logger.info(f"目录 {root_dir} 内容: {top_files}")
+            logger.debug("目录 %s 内容: %s", root_dir, top_files)
         except Exception as e:
             logger.error(f"列出目录内容失败: {root_dir} - {str(e)}")
         
         # 遍历目录查找C源文件
         for root, dirs, file_names in os.walk(root_dir):
-            logger.debug(f"扫描目录: {root}, 包含 {len(file_names)} 个文件")
+            logger.debug("扫描目录: %s, 包含 %d 个文件", root, len(file_names))
             for file_name in file_names:
                 # 只包含以.c结尾的文件
                 if file_name.lower().endswith('.c'):
                     full_path = os.path.join(root, file_name)
-                    logger.info(f"找到C源文件: {full_path}")
+                    logger.debug("找到C源文件: %s", full_path)
                     files.append(full_path)
         
         # 如果没有找到文件，尝试其他扩展名
-        if not files:
+        if not files and create_sample:
             logger.warning(f"在目录 {root_dir} 中没有找到.c文件，尝试使用示例文件")
             # 检查demo.c文件
             demo_path = os.path.join(root_dir, "demo.c")
@@ -702,10 +880,7 @@ int main() {
                     except Exception as e:
                         logger.error(f"创建示例文件失败: {str(e)}")
         
-        logger.info(f"总共找到 {len(files)} 个.c源文件")
-        if files:
-            for i, f in enumerate(files):
-                logger.info(f"文件 {i+1}: {f}")
+        logger.info("总共找到 %d 个.c源文件", len(files))
         return files
     except Exception as e:
         logger.error(f"查找文件时出错: {str(e)}")
@@ -0,0 +1,187 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave Core 模块 - timing
+按处理阶段统计耗时
+
+阶段划分：
+
+- 运行级：``discovery``（查找源文件）、``backup``（备份项目）、``copy``（复制结果目录）
+- 文件级：``read``（读取文件）、``encoding``（编码检测与解码）、``scan``（扫描锚点）、
+  ``lookup``（查找/渲染桩代码）、``splice``（生成插桩内容）、``write``（写入结果文件）、
+  ``copy``（同步未插桩的文件）
+
+文件级耗时由各工作线程记录在文件结果的 ``timings`` 字典中（阶段 → 秒），
+合并文件结果时汇总到 :class:`PhaseTimer`，同时按耗时区间累计各阶段及单文件总耗时的直方图。
+未启用计时时 ``timings`` 为None，各处只多一次判断，不调用计时函数。
+"""
+
+import time
+from contextlib import contextmanager, nullcontext
+from typing import Dict, List, Optional
+
+PHASES = ('discovery', 'backup', 'read', 'encoding', 'scan', 'lookup', 'splice', 'write', 'copy')
+
+PHASE_NAMES = {
+    'discovery': '查找文件',
+    'backup': '备份项目',
+    'read': '读取文件',
+    'encoding': '编码检测',
+    'scan': '扫描锚点',
+    'lookup': '查找桩代码',
+    'splice': '生成内容',
+    'write': '写入结果',
+    'copy': '复制文件',
+}
+
+# 单文件耗时直方图的区间上界（毫秒），最后一个区间为 +Inf
+HISTOGRAM_BOUNDS_MS = (0.1, 0.25, 0.5, 1, 2.5, 5, 10, 25, 50, 100, 250, 1000)
+
+_NULL_CONTEXT = nullcontext()
+
+
+def add_elapsed(timings: Dict[str, float], phase: str, start: float) -> float:
+    """将 ``start`` 至今的耗时累加到 ``timings[phase]``，返回当前时间供下一阶段使用"""
+    now = time.perf_counter()
+    timings[phase] = timings.get(phase, 0.0) + (now - start)
+    return now
+
+
+def measure(timer: Optional['PhaseTimer'], phase: str):
+    """返回统计运行级阶段耗时的上下文管理器；``timer`` 为None时不计时"""
+    return timer.phase(phase) if timer is not None else _NULL_CONTEXT
+
+
+def memory_phase(timer: Optional['PhaseTimer'], phase: str):
+    """返回只做内存分析的阶段上下文管理器；计时器未带内存分析器时不做任何事"""
+    if timer is None or timer.memory is None:
+        return _NULL_CONTEXT
+    return timer.memory.phase(phase)
+
+
+def _bucket(seconds: float) -> int:
+    ms = seconds * 1000.0
+    for i, bound in enumerate(HISTOGRAM_BOUNDS_MS):
+        if ms <= bound:
+            return i
+    return len(HISTOGRAM_BOUNDS_MS)
+
+
+class PhaseTimer:
+    """
+    单次运行的阶段耗时统计
+
+    运行级阶段用 :meth:`phase` 计时；文件级耗时由 :meth:`add_file` 汇总。
+    两者都只在发起运行的线程中调用，不加锁。
+    指定 ``tracer``（:class:`TraceRecorder`）时，运行级阶段同时记录为跟踪区间，
+    处理流程也会为每个文件记录跟踪区间。
+    指定 ``memory``（:class:`MemoryProfiler`）时，运行级阶段同时统计内存峰值与留存。
+    """
+
+    def __init__(self, tracer=None, memory=None):
+        self.tracer = tracer
+        self.memory = memory
+        self._started = time.perf_counter()
+        self.wall_seconds: Optional[float] = None
+        self.totals: Dict[str, float] = {phase: 0.0 for phase in PHASES}
+        self.files: Dict[str, int] = {phase: 0 for phase in PHASES}
+        self.histograms: Dict[str, List[int]] = {}
+        self.file_histogram: List[int] = [0] * (len(HISTOGRAM_BOUNDS_MS) + 1)
+        self.file_seconds = 0.0
+
+    @contextmanager
+    def phase(self, name: str):
+        """统计运行级阶段耗时（内存快照不计入耗时）"""
+        with memory_phase(self, name):
+            start = time.perf_counter()
+            try:
+                yield
+            finally:
+                end = time.perf_counter()
+                self.totals[name] = self.totals.get(name, 0.0) + (end - start)
+                if self.tracer is not None:
+                    self.tracer.complete(name, 'run', start, end)
+
+    def add_file(self, timings: Optional[Dict[str, float]]) -> None:
+        """汇总单个文件各阶段的耗时，并计入对应阶段及单文件总耗时的直方图"""
+        if not timings:
+            return
+        file_seconds = sum(timings.values())
+        self.file_seconds += file_seconds
+        self.file_histogram[_bucket(file_seconds)] += 1
+        for name, seconds in timings.items():
+            self.totals[name] = self.totals.get(name, 0.0) + seconds
+            self.files[name] = self.files.get(name, 0) + 1
+            histogram = self.histograms.get(name)
+            if histogram is None:
+                histogram = self.histograms[name] = [0] * (len(HISTOGRAM_BOUNDS_MS) + 1)
+            histogram[_bucket(seconds)] += 1
+
+    def stop(self) -> None:
+        """记录运行总耗时（重复调用时以最后一次为准）"""
+        self.wall_seconds = time.perf_counter() - self._started
+
+    def to_dict(self) -> Dict[str, object]:
+        """
+        生成可序列化为JSON的统计结果
+
+        ``phases`` 中每个阶段包含总耗时 ``seconds``、计入的文件数 ``files``，
+        文件级阶段另有 ``histogram_ms``：键为区间上界（毫秒），值为耗时落在该区间内的文件数。
+        有文件级耗时时，``file_histogram_ms`` 为单文件各阶段耗时之和的直方图，
+        ``file_seconds`` 为全部文件的这一耗时之和。
+        """
+        if self.wall_seconds is None:
+            self.stop()
+        labels = [f"{bound:g}" for bound in HISTOGRAM_BOUNDS_MS] + ['+Inf']
+        phases = {}
+        for name, seconds in self.totals.items():
+            entry = {"seconds": round(seconds, 6), "files": self.files.get(name, 0)}
+            histogram = self.histograms.get(name)
+            if histogram is not None:
+                entry["histogram_ms"] = dict(zip(labels, histogram))
+            phases[name] = entry
+        result = {"wall_seconds": round(self.wall_seconds, 6), "phases": phases}
+        if any(self.file_histogram):
+            result["file_histogram_ms"] = dict(zip(labels, self.file_histogram))
+            result["file_seconds"] = round(self.file_seconds, 6)
+        return result
+
+
+def histogram_quantile(histogram_ms: Dict[str, int], quantile: float) -> Optional[float]:
+    """
+    由 :meth:`PhaseTimer.to_dict` 输出的直方图估算分位数（毫秒）
+
+    在分位数所在区间内按线性插值估算；落在 +Inf 区间时返回最大的有限上界。
+
+    Returns:
+        Optional[float]: 分位数估计值，直方图为空时返回None
+    """
+    total = sum(histogram_ms.values())
+    if not total:
+        return None
+    rank = quantile * total
+    seen = 0
+    lower = 0.0
+    for label, count in histogram_ms.items():
+        if label == '+Inf':
+            return lower
+        upper = float(label)
+        if count and seen + count >= rank:
+            return lower + (upper - lower) * (rank - seen) / count
+        seen += count
+        lower = upper
+    return lower
+
+
+def format_timings(timings: Dict[str, object]) -> List[str]:
+    """将 :meth:`PhaseTimer.to_dict` 的结果格式化为文本行（只列出有耗时的阶段）"""
+    lines = [f"总耗时: {timings.get('wall_seconds', 0.0) * 1000:.1f} ms"]
+    for name, entry in timings.get("phases", {}).items():
+        seconds = entry.get("seconds", 0.0)
+        if not seconds:
+            continue
+        text = f"  {PHASE_NAMES.get(name, name)}({name}): {seconds * 1000:.1f} ms"
+        if entry.get("files"):
+            text += f", {entry['files']} 个文件"
+        lines.append(text)
+    return lines
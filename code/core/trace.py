@@ -0,0 +1,131 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave Core 模块 - trace
+将插桩运行记录为 Chrome Trace Event 格式，可在 Perfetto（ui.perfetto.dev）或
+chrome://tracing 中按线程查看每个文件及每个处理阶段的起止时间
+
+记录建立在 :mod:`timing` 的计时点之上：
+
+- :class:`TraceTimings` 作为文件结果的 ``timings`` 字典，每次累加阶段耗时时
+  同时记录一个该阶段的区间，因此读取、编码检测、扫描、查找、生成、写入等阶段
+  无需额外的记录代码
+- 每个文件的完整处理过程记录为 ``file`` 类别的区间，运行级阶段记录为 ``run`` 类别
+- 事件按线程（系统线程ID）区分，并附带线程名，多线程运行时可直接看出
+  处理慢的文件、等待中的工作线程和I/O停顿
+"""
+
+import json
+import os
+import threading
+import time
+from contextlib import contextmanager
+from typing import Any, Dict, List, Optional
+
+try:
+    from ..utils.logger import get_logger
+except ImportError:
+    from code.utils.logger import get_logger
+
+logger = get_logger(__name__)
+
+
+class TraceRecorder:
+    """
+    收集一次运行的跟踪事件
+
+    各工作线程可同时调用 :meth:`complete`；事件追加到列表中，不加锁。
+    """
+
+    def __init__(self):
+        self._origin = time.perf_counter()
+        self._pid = os.getpid()
+        self._threads: Dict[int, str] = {}
+        self.events: List[Dict[str, Any]] = []
+
+    def complete(self, name: str, category: str, start: float, end: float,
+                 args: Optional[Dict[str, Any]] = None) -> None:
+        """
+        记录一个已结束的区间
+
+        Args:
+            name: 区间名称
+            category: 类别（``run``、``file``、``phase``）
+            start / end: ``time.perf_counter()`` 时间
+            args: 附加信息，在Perfetto中选中区间时显示
+        """
+        tid = threading.get_native_id()
+        if tid not in self._threads:
+            self._threads[tid] = threading.current_thread().name
+        event = {
+            "name": name,
+            "cat": category,
+            "ph": "X",
+            "ts": round((start - self._origin) * 1e6, 3),
+            "dur": round((end - start) * 1e6, 3),
+            "pid": self._pid,
+            "tid": tid,
+        }
+        if args:
+            event["args"] = args
+        self.events.append(event)
+
+    @contextmanager
+    def span(self, name: str, category: str = 'run', args: Optional[Dict[str, Any]] = None):
+        """记录 ``with`` 语句块的起止时间"""
+        start = time.perf_counter()
+        try:
+            yield
+        finally:
+            self.complete(name, category, start, time.perf_counter(), args)
+
+    def file_timings(self, file_path: str) -> 'TraceTimings':
+        """创建单个文件的阶段耗时字典，阶段区间附带文件路径"""
+        return TraceTimings(self, file_path)
+
+    def to_dict(self) -> Dict[str, Any]:
+        """生成 Chrome Trace Event JSON 对象（含进程名与线程名元数据）"""
+        metadata = [{"name": "process_name", "ph": "M", "pid": self._pid, "tid": 0,
+                     "args": {"name": "YAMLWeave"}}]
+        for tid, thread_name in list(self._threads.items()):
+            metadata.append({"name": "thread_name", "ph": "M", "pid": self._pid, "tid": tid,
+                             "args": {"name": thread_name}})
+        return {"traceEvents": metadata + list(self.events), "displayTimeUnit": "ms"}
+
+    def write(self, path: str) -> bool:
+        """
+        写出跟踪文件
+
+        Returns:
+            bool: 写入成功返回True
+        """
+        try:
+            directory = os.path.dirname(os.path.abspath(path))
+            os.makedirs(directory, exist_ok=True)
+            with open(path, 'w', encoding='utf-8') as f:
+                json.dump(self.to_dict(), f, ensure_ascii=False, separators=(',', ':'))
+            logger.info("已写出跟踪文件: %s (%d 个事件)", path, len(self.events))
+            return True
+        except Exception as e:
+            logger.error("写出跟踪文件 %s 失败: %s", path, e)
+            return False
+
+
+class TraceTimings(dict):
+    """
+    记录跟踪区间的阶段耗时字典
+
+    计时点按 ``timings[phase] = timings.get(phase, 0.0) + elapsed`` 累加耗时，
+    赋值时刚好是该阶段结束的时刻，据此记录 ``[当前时间 - elapsed, 当前时间]`` 区间。
+    """
+
+    def __init__(self, recorder: TraceRecorder, file_path: str):
+        super().__init__()
+        self._recorder = recorder
+        self._args = {"file": file_path}
+
+    def __setitem__(self, phase: str, seconds: float) -> None:
+        end = time.perf_counter()
+        elapsed = seconds - self.get(phase, 0.0)
+        self._recorder.complete(phase, 'phase', end - elapsed, end, self._args)
+        super().__setitem__(phase, seconds)
@@ -6,7 +6,12 @@ YAMLWeave Core 模块 - utils
 """
 
 import os
+import codecs
+import filecmp
 import logging
+import shutil
+import tempfile
+import time
 
 try:
     from ..utils.logger import get_logger
@@ -17,71 +22,113 @@ except Exception:
         get_logger = None
 
 logger = get_logger(__name__) if get_logger else logging.getLogger(__name__)
+
+# 结果目录中保存依赖文件等元数据的子目录，同步结果目录时不删除
+OUTPUT_META_DIR = '.yamlweave'
+
 if not logger.hasHandlers():
     logger.setLevel(logging.INFO)
     handler = logging.StreamHandler()
     handler.setFormatter(logging.Formatter('%(levelname)s: %(message)s'))
     logger.addHandler(handler)
 
-def detect_encoding(file_path):
-    """检测文件编码"""
+def detect_bytes_encoding(raw_data, file_path=''):
+    """
+    检测字节内容的编码
+
+    可按UTF-8解码时直接返回，不导入chardet；只有非UTF-8内容才调用chardet检测。
+    """
+    if raw_data.startswith(codecs.BOM_UTF8):
+        return 'utf-8-sig'
+    try:
+        raw_data.decode('utf-8')
+        return 'utf-8'
+    except UnicodeDecodeError:
+        pass
+    
     try:
-        with open(file_path, 'rb') as f:
-            raw_data = f.read(min(1024 * 1024, os.path.getsize(file_path)))
-        
         import chardet
         result = chardet.detect(raw_data)
         encoding = result['encoding'] or 'utf-8'
         confidence = result['confidence']
-        logger.info(f"检测到文件 {file_path} 编码: {encoding}, 置信度: {confidence}")
+        logger.debug("检测到文件 %s 编码: %s, 置信度: %s", file_path, encoding, confidence)
         
         # 常见编码修正
         if encoding.lower() in ('gb2312', 'gbk'):
             return 'gb18030'
         return encoding
     except Exception as e:
-        logger.error(f"检测文件 {file_path} 编码失败: {str(e)}")
+        logger.debug("检测文件 %s 编码失败: %s", file_path, e)
         return 'utf-8'
 
-def read_file(file_path):
-    """读取文件内容，自动处理编码"""
-    # 尝试的编码列表
-    encodings_to_try = []
-    
-    # 首先尝试检测编码
-    detected_encoding = detect_encoding(file_path)
-    encodings_to_try.append(detected_encoding)
+def detect_encoding(file_path):
+    """检测文件编码"""
+    try:
+        with open(file_path, 'rb') as f:
+            raw_data = f.read(1024 * 1024)
+        return detect_bytes_encoding(raw_data, file_path)
+    except Exception as e:
+        logger.debug("检测文件 %s 编码失败: %s", file_path, e)
+        return 'utf-8'
+
+def read_file(file_path, timings=None):
+    """
+    读取文件内容，自动处理编码
+
+    ``timings`` 为字典时，读取与编码检测（含解码）的耗时分别累加到
+    ``'read'`` 与 ``'encoding'`` 项中。
+    """
+    # 只读取一次文件，按检测到的编码解码；换行统一为 \n，与文本模式读取一致
+    try:
+        start = time.perf_counter() if timings is not None else 0.0
+        with open(file_path, 'rb') as f:
+            raw_data = f.read()
+        if timings is not None:
+            now = time.perf_counter()
+            timings['read'] = timings.get('read', 0.0) + (now - start)
+            start = now
+        encoding = detect_bytes_encoding(raw_data, file_path)
+        content = raw_data.decode(encoding, errors='replace')
+        if '\r' in content:
+            content = content.replace('\r\n', '\n').replace('\r', '\n')
+        if timings is not None:
+            timings['encoding'] = timings.get('encoding', 0.0) + (time.perf_counter() - start)
+        return content, encoding
+    except LookupError:
+        # chardet返回了Python不支持的编码名，按下面的编码列表重试
+        pass
+    except Exception as e:
+        logger.error("读取文件 %s 失败: %s", file_path, e)
+        return None, None
     
-    # 添加其他常用编码
-    for enc in ['utf-8', 'gb18030', 'gbk', 'latin1']:
-        if enc != detected_encoding:
-            encodings_to_try.append(enc)
+    # 尝试的编码列表
+    encodings_to_try = ['utf-8', 'gb18030', 'gbk', 'latin1']
     
     # 尝试使用不同的编码读取文件
     for encoding in encodings_to_try:
         try:
-            logger.info(f"尝试使用编码 {encoding} 读取文件 {file_path}")
+            logger.debug("尝试使用编码 %s 读取文件 %s", encoding, file_path)
             with open(file_path, 'r', encoding=encoding, errors='replace') as f:
                 content = f.read()
-                logger.info(f"使用编码 {encoding} 成功读取文件 {file_path}")
+                logger.debug("使用编码 %s 成功读取文件 %s", encoding, file_path)
                 return content, encoding
         except UnicodeDecodeError:
-            logger.warning(f"使用编码 {encoding} 读取文件 {file_path} 失败")
+            logger.debug("使用编码 %s 读取文件 %s 失败", encoding, file_path)
             continue
         except Exception as e:
-            logger.error(f"读取文件 {file_path} 失败: {str(e)}")
+            logger.error("读取文件 %s 失败: %s", file_path, e)
             break
     
     # 如果所有编码都失败，使用二进制模式读取并返回
     try:
-        logger.warning(f"所有编码尝试失败，以二进制模式读取文件 {file_path}")
+        logger.warning("所有编码尝试失败，以二进制模式读取文件 %s", file_path)
         with open(file_path, 'rb') as f:
             binary_content = f.read()
             # 将二进制内容转换为字符串，替换不可解码的字节
             text_content = binary_content.decode('utf-8', errors='replace')
             return text_content, 'utf-8'
     except Exception as e:
-        logger.error(f"以二进制模式读取文件 {file_path} 失败: {str(e)}")
+        logger.error("以二进制模式读取文件 %s 失败: %s", file_path, e)
         return None, None
 
 def write_file(file_path, content, encoding=None):
@@ -109,4 +156,165 @@ def write_file(file_path, content, encoding=None):
         return True
     except Exception as e:
         logger.error(f"写入文件 {file_path} 失败: {str(e)}")
-        return False 
\ No newline at end of file
+        return False
+
+def _same_bytes(target_path, data):
+    """目标文件内容是否与给定字节完全相同"""
+    try:
+        if os.path.getsize(target_path) != len(data):
+            return False
+        with open(target_path, 'rb') as f:
+            return f.read() == data
+    except OSError:
+        return False
+
+def _replace_atomically(target_path, fill):
+    """
+    在目标文件所在目录创建临时文件，由 ``fill(tmp_path)`` 写入内容后原子替换目标文件
+
+    运行中途取消或异常退出时不会留下写了一半的文件。
+    """
+    target_dir = os.path.dirname(target_path)
+    if target_dir:
+        os.makedirs(target_dir, exist_ok=True)
+    fd, tmp_path = tempfile.mkstemp(dir=target_dir or None,
+                                    prefix='.' + os.path.basename(target_path) + '.', suffix='.tmp')
+    os.close(fd)
+    try:
+        fill(tmp_path)
+        os.replace(tmp_path, target_path)
+    except BaseException:
+        if os.path.exists(tmp_path):
+            try:
+                os.remove(tmp_path)
+            except OSError:
+                pass
+        raise
+
+def write_output_file(target_path, content, encoding=None, only_if_changed=False, counters=None):
+    """
+    将处理后的内容写入结果目录中的目标文件，必要时创建上级目录
+
+    Args:
+        target_path: 目标文件路径
+        content: 文件内容
+        encoding: 写入编码，默认UTF-8
+        only_if_changed: 为True时，目标文件内容相同则不写入，保留其修改时间
+        counters: 可选的计数字典，实际写入时将字节数累加到 ``counters['bytes_written']``
+    """
+    try:
+        # 与文本模式写入一致，换行符转换为平台默认形式
+        if os.linesep != '\n':
+            content = content.replace('\n', os.linesep)
+        data = content.encode(encoding or 'utf-8', errors='replace')
+        if only_if_changed and _same_bytes(target_path, data):
+            logger.debug("结果文件未变化: %s", target_path)
+            return True
+
+        def fill(tmp_path):
+            with open(tmp_path, 'wb') as f:
+                f.write(data)
+            # 临时文件默认权限为0600，沿用目标文件原有权限
+            try:
+                mode = os.stat(target_path).st_mode & 0o777
+            except OSError:
+                mode = 0o644
+            os.chmod(tmp_path, mode)
+
+        _replace_atomically(target_path, fill)
+        if counters is not None:
+            counters['bytes_written'] = counters.get('bytes_written', 0) + len(data)
+        logger.debug("成功写入处理后文件: %s", target_path)
+        return True
+    except Exception as e:
+        logger.error("写入文件 %s 失败: %s", target_path, e)
+        return False
+
+def copy_output_file(source_path, target_path, only_if_changed=False, counters=None):
+    """
+    将源文件原样复制到结果目录中的目标文件（保留修改时间），必要时创建上级目录
+
+    与 :func:`write_output_file` 相同，先复制到临时文件再原子替换；
+    ``only_if_changed`` 为True且内容相同时不复制。``counters`` 同 :func:`write_output_file`。
+    """
+    try:
+        if only_if_changed and os.path.isfile(target_path) and filecmp.cmp(source_path, target_path, shallow=False):
+            return True
+        _replace_atomically(target_path, lambda tmp_path: shutil.copy2(source_path, tmp_path))
+        if counters is not None:
+            counters['bytes_written'] = counters.get('bytes_written', 0) + os.path.getsize(target_path)
+        return True
+    except Exception as e:
+        logger.error("复制文件 %s 失败: %s", source_path, e)
+        return False
+
+def remove_output_path(target_path):
+    """删除结果目录中的文件或目录，不存在时忽略"""
+    try:
+        if os.path.isdir(target_path) and not os.path.islink(target_path):
+            shutil.rmtree(target_path)
+        else:
+            os.remove(target_path)
+        return True
+    except FileNotFoundError:
+        return True
+    except Exception as e:
+        logger.error("删除 %s 失败: %s", target_path, e)
+        return False
+
+def _copy_if_missing(src, dst):
+    """仅在目标文件不存在时复制"""
+    if not os.path.exists(dst):
+        shutil.copy2(src, dst)
+
+def fill_output_tree(root_dir, output_dir):
+    """
+    将项目中结果目录里尚不存在的文件复制过去
+
+    用于先写入插桩结果、再补齐其余文件的场景，已写入的插桩结果不会被覆盖。
+    """
+    shutil.copytree(root_dir, output_dir, copy_function=_copy_if_missing, dirs_exist_ok=True)
+
+def prune_output_tree(root_dir, output_dir):
+    """删除结果目录中项目里已不存在的文件和目录（元数据目录除外），返回删除的数量"""
+    removed = 0
+    meta_dir = os.path.join(output_dir, OUTPUT_META_DIR)
+    for dir_path, dir_names, file_names in os.walk(output_dir, topdown=False):
+        if dir_path == meta_dir or dir_path.startswith(meta_dir + os.sep):
+            continue
+        rel_dir = os.path.relpath(dir_path, output_dir)
+        source_dir = root_dir if rel_dir == os.curdir else os.path.join(root_dir, rel_dir)
+        for name in file_names:
+            if not os.path.lexists(os.path.join(source_dir, name)):
+                if remove_output_path(os.path.join(dir_path, name)):
+                    removed += 1
+        if dir_path != output_dir and not os.path.isdir(source_dir):
+            try:
+                os.rmdir(dir_path)
+                removed += 1
+            except OSError:
+                pass
+    return removed
+
+def sync_output_tree(root_dir, output_dir, incremental=False):
+    """
+    补齐结果目录，使其成为完整的项目副本
+
+    Args:
+        root_dir: 项目根目录
+        output_dir: 结果目录
+        incremental: 结果目录固定、跨运行复用时为True。此时.c文件已由插桩流程写入，
+            其余文件只在内容变化时复制，项目中已不存在的文件从结果目录删除，
+            未变化的文件保留原有修改时间，下游增量构建不会重新编译它们
+    """
+    if not incremental:
+        fill_output_tree(root_dir, output_dir)
+        return
+    for dir_path, _dir_names, file_names in os.walk(root_dir):
+        for name in file_names:
+            if name.lower().endswith('.c'):
+                continue
+            source = os.path.join(dir_path, name)
+            copy_output_file(source, os.path.join(output_dir, os.path.relpath(source, root_dir)),
+                             only_if_changed=True)
+    prune_output_tree(root_dir, output_dir)
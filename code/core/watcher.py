@@ -0,0 +1,488 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave Core 模块 - watcher
+监视模式：源文件或YAML配置变化时增量更新插桩结果目录
+
+- Linux上通过ctypes直接使用inotify，无需第三方库；其他平台或inotify
+  不可用时退回到按修改时间与大小轮询
+- 变化事件经过短暂的防抖后合并处理，编辑器保存时产生的多个事件只触发一次更新
+- 只重新处理变化的源文件；YAML配置变化时比较新旧配置中每个代码段的内容，
+  只重新处理用到了变化代码段的文件
+- 未插桩的文件与非.c文件原样复制，源文件删除后结果目录中的对应文件也被删除
+- 只在内容变化时写入结果文件，未变化的文件保留修改时间
+"""
+
+import os
+import select
+import struct
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor
+from dataclasses import replace
+from typing import Any, Callable, Dict, FrozenSet, Iterable, Iterator, List, Optional, Set, Tuple
+
+try:
+    from ..utils.logger import get_logger
+    from .utils import read_file, write_output_file, copy_output_file, remove_output_path, prune_output_tree
+    from .weave_context import WeaveConfig, FileResult, CancelToken, snapshot_handler
+    from .depfile import DepfileWriter
+except ImportError:
+    from code.utils.logger import get_logger
+    from code.core.utils import read_file, write_output_file, copy_output_file, remove_output_path, prune_output_tree
+    from code.core.weave_context import WeaveConfig, FileResult, CancelToken, snapshot_handler
+    from code.core.depfile import DepfileWriter
+
+logger = get_logger(__name__)
+
+# 最后一个事件之后再等待的秒数，期间的新事件并入同一批
+DEFAULT_DEBOUNCE = 0.03
+# 事件持续不断时，一批最多等待的秒数
+MAX_BATCH_DELAY = 0.5
+# 轮询间隔（秒）
+DEFAULT_POLL_INTERVAL = 0.5
+# 等待事件的超时，决定响应停止请求的速度
+WAIT_TIMEOUT = 0.2
+
+# 编辑器保存时产生的临时文件
+_TEMP_PREFIXES = ('.#',)
+_TEMP_SUFFIXES = ('~', '.swp', '.swx', '.tmp')
+
+# inotify 事件掩码（见 <sys/inotify.h>）
+IN_CLOSE_WRITE = 0x00000008
+IN_MOVED_FROM = 0x00000040
+IN_MOVED_TO = 0x00000080
+IN_CREATE = 0x00000100
+IN_DELETE = 0x00000200
+IN_Q_OVERFLOW = 0x00004000
+IN_IGNORED = 0x00008000
+IN_ONLYDIR = 0x01000000
+IN_ISDIR = 0x40000000
+
+_EVENT_HEADER = struct.Struct('iIII')
+
+AnchorKey = Tuple[str, str, str]
+
+
+def _is_temporary(path: str) -> bool:
+    name = os.path.basename(path)
+    return name.startswith(_TEMP_PREFIXES) or name.endswith(_TEMP_SUFFIXES)
+
+
+def _walk_files(path: str) -> Iterator[str]:
+    for dir_path, _dir_names, file_names in os.walk(path):
+        for file_name in file_names:
+            yield os.path.join(dir_path, file_name)
+
+
+class PollingBackend:
+    """按修改时间与大小轮询目录的后备实现"""
+
+    name = "polling"
+
+    def __init__(self, interval: float = DEFAULT_POLL_INTERVAL):
+        self.interval = interval
+        self._trees: List[Tuple[str, bool]] = []
+        self._snapshot: Dict[str, Tuple[int, int]] = {}
+        self._next_poll = time.monotonic() + interval
+
+    def watch(self, path: str, recursive: bool = True) -> None:
+        self._trees.append((path, recursive))
+        self._snapshot.update(self._scan(path, recursive))
+
+    @staticmethod
+    def _scan(path: str, recursive: bool) -> Dict[str, Tuple[int, int]]:
+        if recursive:
+            files = _walk_files(path)
+        else:
+            try:
+                files = (os.path.join(path, name) for name in os.listdir(path))
+            except OSError:
+                files = ()
+        snapshot = {}
+        for file_path in files:
+            try:
+                st = os.stat(file_path)
+            except OSError:
+                continue
+            if not os.path.isdir(file_path):
+                snapshot[file_path] = (st.st_mtime_ns, st.st_size)
+        return snapshot
+
+    def read(self, timeout: float) -> Optional[Set[str]]:
+        """等待至多 ``timeout`` 秒，返回两次轮询之间变化的文件"""
+        delay = self._next_poll - time.monotonic()
+        if delay > timeout:
+            time.sleep(timeout)
+            return set()
+        if delay > 0:
+            time.sleep(delay)
+        self._next_poll = time.monotonic() + self.interval
+
+        snapshot = {}
+        for path, recursive in self._trees:
+            snapshot.update(self._scan(path, recursive))
+        old = self._snapshot
+        self._snapshot = snapshot
+        return {p for p in old.keys() | snapshot.keys() if old.get(p) != snapshot.get(p)}
+
+    def close(self) -> None:
+        self._trees.clear()
+
+
+class InotifyBackend:
+    """基于Linux inotify的实现，每个目录一个监视描述符"""
+
+    name = "inotify"
+    _MASK = IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_ONLYDIR
+
+    def __init__(self):
+        import ctypes
+        import ctypes.util
+        self._ctypes = ctypes
+        self._libc = ctypes.CDLL(ctypes.util.find_library('c') or 'libc.so.6', use_errno=True)
+        self._fd = self._libc.inotify_init1(os.O_NONBLOCK | os.O_CLOEXEC)
+        if self._fd < 0:
+            errno = ctypes.get_errno()
+            raise OSError(errno, f"inotify_init1 失败: {os.strerror(errno)}")
+        self._dirs: Dict[int, Tuple[str, bool]] = {}
+
+    def watch(self, path: str, recursive: bool = True) -> None:
+        if not recursive:
+            self._add(path, False)
+            return
+        for dir_path, _dir_names, _file_names in os.walk(path):
+            self._add(dir_path, True)
+
+    def _add(self, path: str, recursive: bool) -> None:
+        wd = self._libc.inotify_add_watch(self._fd, os.fsencode(path), self._MASK)
+        if wd < 0:
+            errno = self._ctypes.get_errno()
+            logger.warning("无法监视目录 %s: %s", path, os.strerror(errno))
+            return
+        self._dirs[wd] = (path, recursive)
+
+    def read(self, timeout: float) -> Optional[Set[str]]:
+        """
+        等待至多 ``timeout`` 秒，返回发生变化的文件
+
+        Returns:
+            Optional[Set[str]]: 变化的路径；事件队列溢出时返回None，调用方需全部重新同步
+        """
+        ready, _, _ = select.select([self._fd], [], [], timeout)
+        if not ready:
+            return set()
+        changed: Set[str] = set()
+        while True:
+            try:
+                data = os.read(self._fd, 65536)
+            except BlockingIOError:
+                break
+            if not self._parse(data, changed):
+                return None
+        return changed
+
+    def _parse(self, data: bytes, changed: Set[str]) -> bool:
+        offset = 0
+        while offset + _EVENT_HEADER.size <= len(data):
+            wd, mask, _cookie, length = _EVENT_HEADER.unpack_from(data, offset)
+            offset += _EVENT_HEADER.size
+            name = data[offset:offset + length].rstrip(b'\0')
+            offset += length
+
+            if mask & IN_Q_OVERFLOW:
+                return False
+            if mask & IN_IGNORED:
+                self._dirs.pop(wd, None)
+                continue
+            entry = self._dirs.get(wd)
+            if entry is None or not name:
+                continue
+            dir_path, recursive = entry
+            path = os.path.join(dir_path, os.fsdecode(name))
+
+            if mask & IN_ISDIR:
+                if mask & (IN_CREATE | IN_MOVED_TO):
+                    if recursive:
+                        # 新目录：先添加监视，再报告其中已有的文件，避免遗漏
+                        self.watch(path, True)
+                        changed.update(_walk_files(path))
+                else:
+                    changed.add(path)
+            elif not mask & IN_CREATE:
+                # 新建文件等到写入完成（IN_CLOSE_WRITE）时再处理
+                changed.add(path)
+        return True
+
+    def close(self) -> None:
+        if self._fd >= 0:
+            os.close(self._fd)
+            self._fd = -1
+
+
+def create_backend(use_inotify: Optional[bool] = None, poll_interval: float = DEFAULT_POLL_INTERVAL):
+    """
+    创建文件变化监视后端
+
+    Args:
+        use_inotify: None表示在Linux上自动使用inotify；False强制轮询
+        poll_interval: 轮询间隔（秒）
+    """
+    if use_inotify is not False and sys.platform.startswith('linux'):
+        try:
+            return InotifyBackend()
+        except (OSError, AttributeError) as e:
+            logger.warning("inotify不可用，改为轮询: %s", e)
+    return PollingBackend(poll_interval)
+
+
+def _flatten_stub_data(stub_data: Any) -> Dict[AnchorKey, Any]:
+    """将YAML配置展开为 ``{(TC, STEP, segment): 代码}``"""
+    flat = {}
+    if not isinstance(stub_data, dict):
+        return flat
+    for tc_id, steps in stub_data.items():
+        if not isinstance(steps, dict):
+            continue
+        for step_id, segments in steps.items():
+            if not isinstance(segments, dict):
+                continue
+            for segment_id, code in segments.items():
+                flat[(tc_id, step_id, segment_id)] = code
+    return flat
+
+
+class WeaveWatcher:
+    """
+    监视项目目录并增量更新固定的插桩结果目录
+
+    所有处理都在调用 :meth:`run` 的线程中进行；``max_workers`` 大于1时
+    同一批中的多个文件并行插桩。
+    """
+
+    def __init__(self, processor, root_dir: str, output_dir: str,
+                 yaml_file: Optional[str] = None, max_workers: int = 1,
+                 debounce: float = DEFAULT_DEBOUNCE, backend=None, depfiles: bool = False,
+                 callback: Optional[Callable[[Dict[str, Any]], None]] = None):
+        """
+        Args:
+            processor: 已加载YAML配置的 :class:`StubProcessor`
+            root_dir: 项目根目录
+            output_dir: 插桩结果目录，不存在时创建
+            yaml_file: YAML配置文件，修改后自动重新加载
+            max_workers: 并行处理文件的线程数
+            debounce: 防抖间隔（秒）
+            backend: 监视后端，未指定时由 :func:`create_backend` 创建
+            depfiles: 是否同时更新依赖文件与代码段指纹文件
+            callback: 每批更新完成后调用，参数为本批的结果摘要
+        """
+        self.processor = processor
+        self.root_dir = os.path.abspath(root_dir)
+        self.output_dir = os.path.abspath(output_dir)
+        self.yaml_file = os.path.abspath(yaml_file) if yaml_file else None
+        self.debounce = debounce
+        self.backend = backend
+        self.callback = callback
+        self.config = processor.prepare_config(WeaveConfig(
+            root_dir=self.root_dir, backup_dir='', stubbed_dir=self.output_dir,
+            yaml_handler=snapshot_handler(processor.yaml_handler),
+            max_workers=max(1, int(max_workers or 1)),
+            depfiles=DepfileWriter(self.output_dir) if depfiles else None))
+        self._stub_data = _flatten_stub_data(getattr(self.config.yaml_handler, 'stub_data', None))
+        # 每个.c文件用到的锚点，用于确定YAML修改影响的文件
+        self._anchor_keys: Dict[str, FrozenSet[AnchorKey]] = {}
+
+    def _in_output(self, path: str) -> bool:
+        return path == self.output_dir or path.startswith(self.output_dir + os.sep)
+
+    def _relevant(self, path: str) -> bool:
+        """路径是否属于项目且需要同步到结果目录"""
+        return (path.startswith(self.root_dir + os.sep) and not self._in_output(path)
+                and not _is_temporary(path))
+
+    def sync_all(self) -> Dict[str, Any]:
+        """处理项目中的全部文件并删除结果目录中多余的文件，用于启动时和事件队列溢出后"""
+        start = time.perf_counter()
+        paths = [p for p in _walk_files(self.root_dir) if self._relevant(p)]
+        summary = self._sync(paths)
+        if os.path.isdir(self.output_dir):
+            prune_output_tree(self.root_dir, self.output_dir)
+        summary["elapsed_ms"] = round((time.perf_counter() - start) * 1000, 1)
+        return summary
+
+    def apply(self, changed: Optional[Set[str]]) -> Dict[str, Any]:
+        """
+        处理一批变化
+
+        Args:
+            changed: 变化的路径；None表示需要全部重新同步
+
+        Returns:
+            Dict[str, Any]: 本批结果摘要
+        """
+        if changed is None:
+            logger.warning("文件变化事件过多，重新同步全部文件")
+            return self.sync_all()
+
+        start = time.perf_counter()
+        paths = {p for p in changed if self._relevant(p)}
+        if self.yaml_file and self.yaml_file in changed:
+            keys = self._reload_yaml()
+            if keys:
+                affected = [p for p, used in self._anchor_keys.items() if used & keys]
+                logger.info("YAML配置中 %d 个代码段有变化，影响 %d 个文件", len(keys), len(affected))
+                paths.update(affected)
+        summary = self._sync(paths)
+        summary["elapsed_ms"] = round((time.perf_counter() - start) * 1000, 1)
+        return summary
+
+    def _reload_yaml(self) -> Optional[Set[AnchorKey]]:
+        """
+        重新加载YAML配置
+
+        Returns:
+            Optional[Set[AnchorKey]]: 内容变化的代码段；配置无法解析时保留当前配置并返回None
+        """
+        content, _encoding = read_file(self.yaml_file)
+        if content is None:
+            return None
+        try:
+            import yaml
+            yaml.safe_load(content)
+        except Exception as e:
+            # 编辑中途保存的配置可能暂时不合法，等待下一次修改
+            logger.warning("YAML配置解析失败，保留当前配置: %s", e)
+            return None
+
+        handler = type(self.config.yaml_handler)()
+        if not handler.load_yaml(self.yaml_file):
+            logger.warning("重新加载YAML配置失败，保留当前配置: %s", self.yaml_file)
+            return None
+        stub_data = _flatten_stub_data(handler.stub_data)
+        old = self._stub_data
+        changed = {k for k in old.keys() | stub_data.keys() if old.get(k) != stub_data.get(k)}
+        self._stub_data = stub_data
+        self.config = self.processor.prepare_config(replace(self.config, yaml_handler=handler))
+        return changed
+
+    def _weave(self, c_files: List[str]) -> Iterable[FileResult]:
+        if self.config.max_workers > 1 and len(c_files) > 1:
+            with ThreadPoolExecutor(max_workers=self.config.max_workers) as executor:
+                yield from executor.map(lambda fp: self.processor.weave_file(self.config, fp), c_files)
+        else:
+            for file_path in c_files:
+                yield self.processor.weave_file(self.config, file_path)
+
+    def _forget(self, path: str) -> None:
+        prefix = path + os.sep
+        for known in [p for p in self._anchor_keys if p == path or p.startswith(prefix)]:
+            del self._anchor_keys[known]
+
+    def _sync(self, paths: Iterable[str]) -> Dict[str, Any]:
+        """将指定路径同步到结果目录"""
+        updated: List[str] = []
+        removed: List[str] = []
+        errors: List[Dict[str, str]] = []
+        missing: List[Dict[str, Any]] = []
+        inserted = 0
+
+        c_files = []
+        for path in sorted(paths):
+            target = self.config.output_path(path)
+            if not os.path.exists(path):
+                if os.path.lexists(target) and remove_output_path(target):
+                    removed.append(path)
+                if self.config.depfiles is not None:
+                    self.config.depfiles.remove(self.root_dir, path)
+                self._forget(path)
+            elif os.path.isdir(path):
+                continue
+            elif path.lower().endswith('.c'):
+                c_files.append(path)
+            elif copy_output_file(path, target, only_if_changed=True):
+                updated.append(path)
+            else:
+                errors.append({"file": path, "error": f"复制文件失败: {target}"})
+
+        for file_result in self._weave(c_files):
+            path = file_result.file_path
+            target = self.config.output_path(path)
+            if not file_result.success:
+                errors.append({"file": path, "error": file_result.message})
+                continue
+            if file_result.updated:
+                ok = write_output_file(target, file_result.new_content, file_result.encoding,
+                                       only_if_changed=True)
+            else:
+                ok = copy_output_file(path, target, only_if_changed=True)
+            if ok and self.config.depfiles is not None:
+                ok = self.config.depfiles.update(self.root_dir, path, file_result.anchor_keys,
+                                                 self.config.yaml_handler)
+            if not ok:
+                errors.append({"file": path, "error": f"写入结果文件失败: {target}"})
+                continue
+            self._anchor_keys[path] = file_result.anchor_keys
+            inserted += file_result.inserted
+            missing.extend(file_result.missing_anchors)
+            updated.append(path)
+
+        return {
+            "updated_files": [os.path.relpath(p, self.root_dir) for p in updated],
+            "removed_files": [os.path.relpath(p, self.root_dir) for p in removed],
+            "successful_stubs": inserted,
+            "missing_stubs": len(missing),
+            "missing_anchor_details": missing,
+            "errors": errors,
+        }
+
+    def _collect(self, backend, changed: Optional[Set[str]], first: float) -> Optional[Set[str]]:
+        """防抖：合并最后一个事件之后 ``debounce`` 秒内的事件"""
+        deadline = first + MAX_BATCH_DELAY
+        while changed is not None:
+            remaining = deadline - time.perf_counter()
+            if remaining <= 0:
+                break
+            more = backend.read(min(self.debounce, remaining))
+            if more is None:
+                return None
+            if not more:
+                break
+            changed |= more
+        return changed
+
+    def _report(self, summary: Dict[str, Any]) -> None:
+        logger.info("已更新 %d 个文件，删除 %d 个，用时 %.1f ms",
+                    len(summary["updated_files"]), len(summary["removed_files"]),
+                    summary.get("latency_ms", summary["elapsed_ms"]))
+        for entry in summary["errors"]:
+            logger.warning("文件处理失败: %s, %s", entry["file"], entry["error"])
+        if self.callback:
+            self.callback(summary)
+
+    def run(self, cancel_token: Optional[CancelToken] = None) -> None:
+        """
+        同步全部文件后持续监视，直到 ``cancel_token`` 被取消
+
+        每批摘要中的 ``latency_ms`` 为从收到第一个事件到结果写入完成的耗时。
+        """
+        token = cancel_token or CancelToken()
+        backend = self.backend or create_backend()
+        try:
+            # 先开始监视再做全量同步，同步期间的修改不会丢失
+            backend.watch(self.root_dir, recursive=True)
+            if self.yaml_file and not self.yaml_file.startswith(self.root_dir + os.sep):
+                backend.watch(os.path.dirname(self.yaml_file), recursive=False)
+            self._report(self.sync_all())
+            logger.info("正在监视 %s (%s)", self.root_dir, backend.name)
+
+            while not token.cancelled:
+                changed = backend.read(WAIT_TIMEOUT)
+                if changed is not None and not changed:
+                    continue
+                first = time.perf_counter()
+                summary = self.apply(self._collect(backend, changed, first))
+                summary["latency_ms"] = round((time.perf_counter() - first) * 1000, 1)
+                if summary["updated_files"] or summary["removed_files"] or summary["errors"]:
+                    self._report(summary)
+        finally:
+            backend.close()
@@ -0,0 +1,262 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave Core 模块 - weave_context
+定义单次插桩运行所需的配置与上下文对象
+
+- ``WeaveConfig``：运行开始时确定、运行期间只读的配置
+- ``FileResult``：单个文件的处理结果，由工作函数独立生成
+- ``RunContext``：单次运行的统计汇总，仅由发起运行的线程合并文件结果
+- ``CancelToken``：由界面等外部线程控制的取消与暂停标志
+
+所有运行期状态都保存在这些对象中，处理器实例本身不再保存
+与某次运行相关的可变数据，因此同一进程内可以并发处理多个项目。
+"""
+
+import copy
+import os
+import datetime
+import threading
+from dataclasses import dataclass, field
+from typing import Any, Dict, FrozenSet, List, Optional, Tuple
+
+try:
+    from .progress import ProgressTracker
+except ImportError:
+    from code.core.progress import ProgressTracker
+
+
+def snapshot_handler(yaml_handler: Any) -> Any:
+    """返回YAML处理器的浅拷贝，供一次运行使用"""
+    return copy.copy(yaml_handler) if yaml_handler is not None else None
+
+
+@dataclass(frozen=True)
+class WeaveConfig:
+    """
+    单次插桩运行的只读配置
+
+    Attributes:
+        root_dir: 项目根目录
+        backup_dir: 原始项目备份目录
+        stubbed_dir: 插桩结果目录
+        yaml_handler: YAML桩代码处理器的快照（由 :meth:`create` 或调用方用 :func:`snapshot_handler` 生成）。
+            处理器重新加载时整体替换 ``stub_data`` 与 ``templates`` 而不原地修改，
+            因此运行期间调用 ``set_yaml_file`` / ``set_stub_data`` 不影响已开始的运行
+        parser: 本次运行各文件共用的 ``StubParser``，使用 ``yaml_handler`` 快照；
+            由处理器的 ``prepare_config`` 设置，为None时按文件创建
+        timestamp: 运行时间戳，用于生成默认目录名
+        max_workers: 并行处理文件的线程数，1表示顺序处理
+        anchor_index: 可选的 :class:`AnchorIndex`，跨运行复用签名未变的文件的处理结果
+        incremental: 结果目录固定、跨运行复用；所有.c文件都写入结果目录，
+            但只在内容变化时写入，未变化的文件保留修改时间
+        depfiles: 可选的 :class:`DepfileWriter`，为每个结果文件写出依赖文件
+        timings: 是否记录每个文件各处理阶段的耗时（见 :mod:`timing`）
+        tracer: 可选的 :class:`TraceRecorder`，同时记录每个文件及各阶段的跟踪区间
+        memory: 可选的 :class:`MemoryProfiler`，每个文件处理完成后检查是否到达内存高点
+    """
+    root_dir: str
+    backup_dir: str
+    stubbed_dir: str
+    yaml_handler: Any = None
+    timestamp: str = ''
+    max_workers: int = 1
+    anchor_index: Any = None
+    incremental: bool = False
+    depfiles: Any = None
+    timings: bool = False
+    tracer: Any = None
+    memory: Any = None
+    parser: Any = None
+
+    @classmethod
+    def create(cls, root_dir: str, yaml_handler: Any = None,
+               backup_dir: Optional[str] = None,
+               stubbed_dir: Optional[str] = None,
+               max_workers: int = 1,
+               anchor_index: Any = None,
+               incremental: bool = False) -> 'WeaveConfig':
+        """
+        按默认命名规则创建配置
+
+        未指定的目录使用 ``<root>_backup_<ts>`` 与 ``<root>_stubbed_<ts>``。
+        """
+        timestamp = datetime.datetime.now().strftime("%Y%m%d_%H%M%S")
+        return cls(
+            root_dir=root_dir,
+            backup_dir=backup_dir or f"{root_dir}_backup_{timestamp}",
+            stubbed_dir=stubbed_dir or f"{root_dir}_stubbed_{timestamp}",
+            yaml_handler=snapshot_handler(yaml_handler),
+            timestamp=timestamp,
+            max_workers=max(1, int(max_workers or 1)),
+            anchor_index=anchor_index,
+            incremental=incremental,
+        )
+
+    def output_path(self, file_path: str) -> str:
+        """返回源文件在插桩结果目录中的对应路径"""
+        return os.path.join(self.stubbed_dir, os.path.relpath(file_path, self.root_dir))
+
+
+@dataclass
+class FileResult:
+    """
+    单个文件的处理结果
+
+    由处理单个文件的函数创建并填充，不与其他文件共享。
+    ``has_anchors`` 仅在完成锚点扫描且未找到锚点时置为False；
+    ``anchor_keys`` 记录文件中出现的新格式锚点 ``(TC, STEP, segment)``，
+    用于判断YAML中哪些代码段的修改会影响该文件。
+    启用计时时 ``timings`` 记录各处理阶段的耗时（秒），否则为None。
+    ``bytes_read`` / ``bytes_written`` 为读取源文件与写入结果文件的字节数，
+    ``cache_hit`` 表示按锚点索引跳过了读取，``output_current`` 表示固定结果目录中的
+    结果文件与上次写出时相同，无需再写入。
+    """
+    file_path: str
+    success: bool = True
+    message: str = ''
+    inserted: int = 0
+    size: int = 0
+    has_anchors: bool = True
+    encoding: Optional[str] = None
+    new_content: Optional[str] = None
+    missing_anchors: List[Dict[str, Any]] = field(default_factory=list)
+    anchor_keys: FrozenSet[Tuple[str, str, str]] = frozenset()
+    timings: Optional[Dict[str, float]] = None
+    bytes_read: int = 0
+    bytes_written: int = 0
+    cache_hit: bool = False
+    output_current: bool = False
+
+    @property
+    def updated(self) -> bool:
+        """文件是否插入了桩代码"""
+        return self.inserted > 0
+
+
+class CancelToken:
+    """
+    协作式取消与暂停标志
+
+    控制方（界面线程）调用 :meth:`cancel`、:meth:`pause`、:meth:`resume`；
+    处理方在文件之间及各处理阶段之间调用 :meth:`checkpoint`，
+    暂停时在此阻塞，返回False表示应停止处理。
+    """
+
+    def __init__(self):
+        self._cancelled = threading.Event()
+        self._running = threading.Event()
+        self._running.set()
+
+    def cancel(self) -> None:
+        """请求取消，同时解除暂停以便处理线程尽快退出"""
+        self._cancelled.set()
+        self._running.set()
+
+    def pause(self) -> None:
+        """暂停处理（在下一个检查点生效）"""
+        if not self._cancelled.is_set():
+            self._running.clear()
+
+    def resume(self) -> None:
+        """恢复处理"""
+        self._running.set()
+
+    @property
+    def cancelled(self) -> bool:
+        return self._cancelled.is_set()
+
+    @property
+    def paused(self) -> bool:
+        return not self._running.is_set()
+
+    def checkpoint(self) -> bool:
+        """
+        处理检查点：暂停时阻塞直到恢复或取消
+
+        Returns:
+            bool: 是否继续处理
+        """
+        self._running.wait()
+        return not self._cancelled.is_set()
+
+
+class RunContext:
+    """
+    单次运行的统计上下文
+
+    文件结果通过 :meth:`merge` 汇总，最终由 :meth:`to_result`
+    生成与 ``StubProcessor.process_directory`` 兼容的结果字典。
+    合并时同步累加 ``progress`` 计数器，供界面定时采样；
+    指定 ``timer`` 时同时汇总各文件的阶段耗时。
+    """
+
+    def __init__(self, config: WeaveConfig, progress: Optional[ProgressTracker] = None,
+                 cancel_token: Optional[CancelToken] = None, timer: Any = None):
+        self.config = config
+        self.timer = timer
+        self.progress = progress if progress is not None else ProgressTracker()
+        self.cancel_token = cancel_token if cancel_token is not None else CancelToken()
+        self.cancelled = False
+        self.unprocessed_files: List[str] = []
+        self.total_files = 0
+        self.processed_files = 0
+        self.updated_files = 0
+        self.successful_stubs = 0
+        self.bytes_read = 0
+        self.bytes_written = 0
+        self.cache_hits = 0
+        self.errors: List[Dict[str, str]] = []
+        self.missing_anchors: List[Dict[str, Any]] = []
+        self.files_without_anchors: List[str] = []
+
+    def add_error(self, file_path: str, message: str) -> None:
+        """记录与具体文件结果无关的错误"""
+        self.errors.append({"file": file_path, "error": message})
+
+    def mark_cancelled(self, remaining: List[str]) -> None:
+        """记录运行被取消，以及尚未合并结果的文件"""
+        self.cancelled = True
+        self.unprocessed_files.extend(remaining)
+
+    def merge(self, file_result: FileResult) -> None:
+        """合并单个文件的处理结果"""
+        if file_result.success:
+            self.processed_files += 1
+            self.updated_files += file_result.updated
+            self.successful_stubs += file_result.inserted
+        else:
+            self.add_error(file_result.file_path, file_result.message)
+        self.missing_anchors.extend(file_result.missing_anchors)
+        if file_result.success and not file_result.has_anchors:
+            self.files_without_anchors.append(file_result.file_path)
+        self.bytes_read += file_result.bytes_read
+        self.bytes_written += file_result.bytes_written
+        self.cache_hits += file_result.cache_hit
+        self.progress.add(files=1, bytes=file_result.size, anchors=file_result.inserted)
+        if self.timer is not None:
+            self.timer.add_file(file_result.timings)
+
+    def to_result(self) -> Dict[str, Any]:
+        """生成运行结果字典"""
+        root_dir = self.config.root_dir
+        result = {
+            "total_files": self.total_files,
+            "processed_files": self.processed_files,
+            "updated_files": self.updated_files,
+            "successful_stubs": self.successful_stubs,
+            "bytes_read": self.bytes_read,
+            "bytes_written": self.bytes_written,
+            "cache_hits": self.cache_hits,
+            "errors": list(self.errors),
+            "backup_dir": self.config.backup_dir,
+            "stubbed_dir": self.config.stubbed_dir,
+            "missing_stubs": len(self.missing_anchors),
+            "missing_anchor_details": list(self.missing_anchors),
+            "files_without_anchors": [os.path.relpath(p, root_dir) for p in self.files_without_anchors],
+            "cancelled": self.cancelled,
+            "unprocessed_files": [os.path.relpath(p, root_dir) for p in self.unprocessed_files],
+        }
+        if self.timer is not None:
+            result["timings"] = self.timer.to_dict()
+        return result
@@ -0,0 +1,294 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave Core 模块 - weave_engine
+统一的插桩引擎，供 StubParser、CommentHandler 与 MinimalStubProcessor 共用
+
+处理过程分为三步：
+1. ``scan``：扫描源文件行，找出锚点（新格式或传统格式）
+2. ``resolve``：为每个锚点查找桩代码，得到插入项与缺失锚点
+3. ``splice``：一次遍历生成插桩后的行列表
+
+本模块仅依赖标准库，不输出日志，也不调用任何回调，
+便于在UI、命令行及降级处理器中复用，并可单独做性能测试。
+"""
+
+import re
+import time
+from typing import Callable, Dict, Iterable, List, Optional, Sequence, Tuple
+
+# 插入代码行的尾部标记
+STUB_MARKER = "  // 通过桩插入"
+
+# 新格式锚点 - "// TC001 STEP1 segment1 [附加参数...]"
+ANCHOR_PATTERN = re.compile(r'//\s*(TC\d+)\s+(STEP\d+)\s+(\w+)(.*)', re.IGNORECASE)
+
+# 传统格式 - "// TC001 STEP1:" 后跟 "// code: ..." 或 "/* code: ... */"
+TRADITIONAL_PATTERN = re.compile(r'//\s*(TC\d+\s+STEP\d+):', re.IGNORECASE)
+SINGLE_LINE_CODE_PATTERN = re.compile(r'//\s*code:\s*(.*)')
+MULTI_LINE_START = '/* code:'
+MULTI_LINE_END = '*/'
+
+# 行首空白
+_INDENT_PATTERN = re.compile(r'\s*')
+
+
+class Anchor:
+    """
+    源文件中的一个锚点
+
+    Attributes:
+        line_index: 锚点注释所在行索引（从0开始）
+        insert_after: 桩代码插入在该行索引之后
+        test_case_id / step_id / segment_id: 锚点标识
+        args: 代码段ID之后的附加参数（仅新格式）
+        code: 注释中内嵌的代码（仅传统格式）
+        format: ``'new'`` 或 ``'traditional'``
+    """
+
+    __slots__ = ('line_index', 'insert_after', 'test_case_id', 'step_id',
+                 'segment_id', 'args', 'code', 'format')
+
+    def __init__(self, line_index: int, test_case_id: str, step_id: str,
+                 segment_id: str = '', args: Sequence[str] = (),
+                 code: Optional[str] = None, insert_after: Optional[int] = None,
+                 format: str = 'new'):
+        self.line_index = line_index
+        self.insert_after = line_index if insert_after is None else insert_after
+        self.test_case_id = test_case_id
+        self.step_id = step_id
+        self.segment_id = segment_id
+        self.args = tuple(args)
+        self.code = code
+        self.format = format
+
+    @property
+    def text(self) -> str:
+        """锚点标识文本，如 ``TC001 STEP1 segment1``"""
+        if self.format == 'new':
+            return f"{self.test_case_id} {self.step_id} {self.segment_id}"
+        return f"{self.test_case_id} {self.step_id}"
+
+    def __repr__(self) -> str:
+        return f"Anchor({self.text!r}, line={self.line_index + 1})"
+
+
+class Insertion:
+    """一次桩代码插入：在 ``insert_after`` 行之后插入 ``code``"""
+
+    __slots__ = ('insert_after', 'code', 'anchor')
+
+    def __init__(self, insert_after: int, code: str, anchor: Optional[Anchor] = None):
+        self.insert_after = insert_after
+        self.code = code
+        self.anchor = anchor
+
+
+def scan(lines: Sequence[str]) -> List[Anchor]:
+    """
+    扫描新格式锚点
+
+    Args:
+        lines: 源文件行列表
+
+    Returns:
+        List[Anchor]: 按行号排列的锚点列表
+    """
+    anchors = []
+    search = ANCHOR_PATTERN.search
+    for i, line in enumerate(lines):
+        # 绝大多数行不含注释，先做子串判断避免进入正则
+        if '//' not in line:
+            continue
+        match = search(line)
+        if match:
+            tc_id, step_id, segment_id, rest = match.groups()
+            anchors.append(Anchor(i, tc_id, step_id, segment_id, rest.split()))
+    return anchors
+
+
+def scan_traditional(lines: Sequence[str]) -> List[Anchor]:
+    """
+    扫描传统格式锚点及其内嵌代码
+
+    单行代码插入在 ``// code:`` 行之后，多行代码插入在 ``*/`` 行之后；
+    未闭合的多行注释插入在注释开始行之后。
+
+    Args:
+        lines: 源文件行列表
+
+    Returns:
+        List[Anchor]: 带有内嵌代码的锚点列表
+    """
+    anchors = []
+    total = len(lines)
+    for i, line in enumerate(lines):
+        if '//' not in line:
+            continue
+        match = TRADITIONAL_PATTERN.search(line)
+        if not match or i + 1 >= total:
+            continue
+
+        code = None
+        insert_after = i
+        next_line = lines[i + 1]
+        code_match = SINGLE_LINE_CODE_PATTERN.search(next_line)
+        if code_match:
+            code = code_match.group(1)
+            insert_after = i + 1
+        elif MULTI_LINE_START in next_line:
+            j = i + 2
+            while j < total and MULTI_LINE_END not in lines[j]:
+                j += 1
+            if j > i + 2:
+                code = '\n'.join(lines[i + 2:j])
+                insert_after = j if j < total else i + 1
+
+        if code:
+            tc_id, step_id = match.group(1).split()
+            anchors.append(Anchor(i, tc_id, step_id, code=code,
+                                  insert_after=insert_after, format='traditional'))
+    return anchors
+
+
+def resolve(anchors: Iterable[Anchor],
+            lookup: Optional[Callable[[Anchor], Optional[str]]] = None
+            ) -> Tuple[List[Insertion], List[Anchor]]:
+    """
+    为锚点查找桩代码
+
+    Args:
+        anchors: 锚点列表
+        lookup: 查找函数，参数为锚点，返回桩代码或None；
+            传统格式锚点已带有内嵌代码，不调用查找函数
+
+    Returns:
+        Tuple[List[Insertion], List[Anchor]]: (插入项列表, 未找到桩代码的锚点列表)
+    """
+    insertions = []
+    missing = []
+    for anchor in anchors:
+        code = anchor.code
+        if code is None and lookup is not None:
+            code = lookup(anchor)
+        if code:
+            insertions.append(Insertion(anchor.insert_after, code, anchor))
+        else:
+            missing.append(anchor)
+    return insertions, missing
+
+
+def format_stub(code: str, indent: str = '', mark_blank: bool = True) -> List[str]:
+    """
+    将桩代码格式化为带缩进和标记的行
+
+    Args:
+        code: 桩代码
+        indent: 每行前添加的缩进
+        mark_blank: 空行是否也添加标记
+
+    Returns:
+        List[str]: 格式化后的代码行
+    """
+    if mark_blank:
+        return [f"{indent}{line}{STUB_MARKER}" for line in code.splitlines()]
+    return [f"{indent}{line}{STUB_MARKER}" if line.strip() else line
+            for line in code.splitlines()]
+
+
+def line_directive(line_number: int, file_name: str) -> str:
+    """生成C预处理器 ``#line`` 指令"""
+    escaped = file_name.replace('\\', '\\\\').replace('"', '\\"')
+    return f'#line {line_number} "{escaped}"'
+
+
+def splice(lines: Sequence[str], insertions: Iterable[Insertion],
+           indent: bool = True, mark_blank: bool = True,
+           line_file: Optional[str] = None) -> List[str]:
+    """
+    一次遍历生成插桩后的行列表
+
+    每个插入项的代码紧跟在 ``insert_after`` 行之后，缩进与该行一致；
+    超出文件末尾的插入项追加到文件末尾。同一行的多个插入项按给定顺序输出。
+
+    Args:
+        lines: 源文件行列表（不会被修改）
+        insertions: 插入项
+        indent: 是否沿用插入位置所在行的缩进
+        mark_blank: 空行是否也添加标记
+        line_file: 指定时在文件开头和每段桩代码之后添加 ``#line`` 指令，
+            使编译诊断、``__FILE__`` 和调试信息中的文件名与行号对应原文件；
+            桩代码的每一行之前也添加指令，指向插入位置所在行（锚点或内嵌代码行），
+            桩代码中的错误报告在该行而不是其后无关的源代码行
+
+    Returns:
+        List[str]: 插桩后的行列表
+    """
+    total = len(lines)
+    ordered = sorted(insertions, key=lambda ins: ins.insert_after)
+    if not ordered:
+        return list(lines)
+
+    result: List[str] = [line_directive(1, line_file)] if line_file else []
+    pos = 0
+    for ins in ordered:
+        after = min(ins.insert_after, total - 1)
+        if after + 1 > pos:
+            result.extend(lines[pos:after + 1])
+            pos = after + 1
+        prefix = ''
+        if indent and after >= 0:
+            prefix = _INDENT_PATTERN.match(lines[after]).group(0)
+        stub_lines = format_stub(ins.code, prefix, mark_blank)
+        if line_file:
+            anchor_directive = line_directive(after + 1, line_file)
+            for stub_line in stub_lines:
+                result.append(anchor_directive)
+                result.append(stub_line)
+            result.append(line_directive(pos + 1, line_file))
+        else:
+            result.extend(stub_lines)
+    result.extend(lines[pos:])
+    return result
+
+
+def weave_lines(lines: Sequence[str],
+                lookup: Optional[Callable[[Anchor], Optional[str]]] = None,
+                traditional: bool = True,
+                timings: Optional[Dict[str, float]] = None
+                ) -> Tuple[List[Insertion], List[Anchor], List[Anchor]]:
+    """
+    扫描并解析文件中的全部插入项
+
+    优先使用新格式锚点；文件中没有可插入的新格式锚点时，
+    回退到传统格式（``traditional`` 为True时）。
+
+    Args:
+        lines: 源文件行列表
+        lookup: 新格式锚点的桩代码查找函数
+        traditional: 是否启用传统格式回退
+        timings: 可选的耗时字典，扫描与查找桩代码的耗时累加到 ``'scan'`` 与 ``'lookup'`` 项
+
+    Returns:
+        Tuple[List[Insertion], List[Anchor], List[Anchor]]:
+            (插入项, 新格式锚点, 未找到桩代码的锚点)
+    """
+    if timings is None:
+        anchors = scan(lines) if lookup is not None else []
+        insertions, missing = resolve(anchors, lookup)
+        if not insertions and traditional:
+            insertions, _ = resolve(scan_traditional(lines))
+        return insertions, anchors, missing
+
+    start = time.perf_counter()
+    anchors = scan(lines) if lookup is not None else []
+    scanned = time.perf_counter()
+    insertions, missing = resolve(anchors, lookup)
+    resolved = time.perf_counter()
+    scan_time = scanned - start
+    if not insertions and traditional:
+        insertions, _ = resolve(scan_traditional(lines))
+        scan_time += time.perf_counter() - resolved
+    timings['scan'] = timings.get('scan', 0.0) + scan_time
+    timings['lookup'] = timings.get('lookup', 0.0) + (resolved - scanned)
+    return insertions, anchors, missing
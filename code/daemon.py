@@ -0,0 +1,347 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave 守护进程
+常驻进程保持YAML配置与锚点索引的缓存，供命令行客户端重复调用
+
+- 通信使用本机Unix套接字（Windows上为命名管道），由 ``multiprocessing.connection``
+  实现，连接需通过保存在用户私有目录中的随机密钥认证。响应经pickle反序列化，
+  因此POSIX上运行目录与密钥文件必须属于当前用户且其他用户不可访问，否则拒绝使用
+- YAML配置按文件签名缓存，未修改时不重新解析
+- :class:`AnchorIndex` 按文件签名记录各文件的处理结果，签名未变时跳过读取和扫描；
+  未指定结果目录时使用固定的 ``<root>_stubbed`` 增量更新，有插入的文件在结果文件
+  未被改动时同样跳过，不再每次请求生成新的带时间戳目录并整体复制
+- 每个连接在独立线程中处理，耗时的插桩不阻塞 ``ping`` 等请求；
+  写入同一结果目录的插桩请求依次执行
+
+支持的请求：``ping``、``weave``、``lint``、``extract``、``shutdown``。
+客户端部分只依赖标准库，不导入核心处理模块。
+"""
+
+import logging
+import os
+import stat
+import sys
+import tempfile
+import threading
+import time
+from multiprocessing.connection import Client, Listener
+from typing import Any, Dict, Optional
+
+logger = logging.getLogger("yamlweave.daemon")
+
+# 认证密钥长度（字节）
+AUTHKEY_BYTES = 32
+
+
+def _is_private(st: os.stat_result) -> bool:
+    """文件属于当前用户、不是符号链接，且同组与其他用户没有任何权限"""
+    return (not stat.S_ISLNK(st.st_mode) and st.st_uid == os.getuid()
+            and st.st_mode & 0o077 == 0)
+
+
+def runtime_dir() -> Optional[str]:
+    """
+    返回当前用户的守护进程运行目录（权限0700）
+
+    POSIX上优先使用 ``$XDG_RUNTIME_DIR``，否则使用临时目录下的 ``yamlweave-<uid>``。
+    临时目录中的路径可被其他用户抢先创建，因此目录已存在时同样检查：
+    不是当前用户所有的普通目录、或同组与其他用户有权限时拒绝使用。
+
+    Returns:
+        Optional[str]: 目录路径；无法创建或未通过检查时返回None
+    """
+    if sys.platform == "win32":
+        base = os.environ.get("LOCALAPPDATA") or os.path.expanduser("~")
+        path = os.path.join(base, "YAMLWeave")
+        os.makedirs(path, exist_ok=True)
+        return path
+    base = os.environ.get("XDG_RUNTIME_DIR")
+    if base and os.path.isabs(base) and os.path.isdir(base):
+        path = os.path.join(base, "yamlweave")
+    else:
+        path = os.path.join(tempfile.gettempdir(), f"yamlweave-{os.getuid()}")
+    try:
+        os.makedirs(path, mode=0o700, exist_ok=True)
+        st = os.lstat(path)
+    except OSError as e:
+        logger.warning("无法创建运行目录 %s: %s", path, e)
+        return None
+    if not stat.S_ISDIR(st.st_mode) or not _is_private(st):
+        logger.warning("运行目录 %s 不是当前用户私有的目录，拒绝使用", path)
+        return None
+    return path
+
+
+def default_address() -> Optional[str]:
+    """返回默认监听地址；运行目录不可用时返回None"""
+    if sys.platform == "win32":
+        user = os.environ.get("USERNAME", "user")
+        return rf"\\.\pipe\yamlweave-{user}"
+    directory = runtime_dir()
+    return os.path.join(directory, "daemon.sock") if directory else None
+
+
+def _authkey(create: bool = False) -> Optional[bytes]:
+    """读取（或创建）认证密钥；不存在且不创建、或密钥文件不是当前用户私有时返回None"""
+    directory = runtime_dir()
+    if directory is None:
+        return None
+    key_path = os.path.join(directory, "daemon.key")
+    if create and not os.path.lexists(key_path):
+        fd = os.open(key_path, os.O_WRONLY | os.O_CREAT | os.O_EXCL, 0o600)
+        with os.fdopen(fd, "wb") as f:
+            f.write(os.urandom(AUTHKEY_BYTES))
+    try:
+        fd = os.open(key_path, os.O_RDONLY | getattr(os, "O_NOFOLLOW", 0))
+    except OSError:
+        return None
+    with os.fdopen(fd, "rb") as f:
+        if sys.platform != "win32" and not _is_private(os.fstat(f.fileno())):
+            logger.warning("密钥文件 %s 不是当前用户私有的文件，拒绝使用", key_path)
+            return None
+        return f.read()
+
+
+def send_request(op: str, address: Optional[str] = None, **params) -> Optional[Dict[str, Any]]:
+    """
+    向守护进程发送请求
+
+    Args:
+        op: 请求类型
+        address: 守护进程地址，默认使用 :func:`default_address`
+        **params: 请求参数
+
+    Returns:
+        Optional[Dict[str, Any]]: 守护进程的响应；守护进程未运行时返回None
+    """
+    key = _authkey()
+    if key is None:
+        return None
+    try:
+        conn = Client(address or default_address(), authkey=key)
+    except (OSError, EOFError):
+        return None
+    try:
+        conn.send({"op": op, "params": params})
+        return conn.recv()
+    except (OSError, EOFError) as e:
+        return {"ok": False, "error": f"与守护进程通信失败: {e}"}
+    finally:
+        conn.close()
+
+
+class WeaveDaemon:
+    """守护进程服务端，保存跨请求复用的缓存"""
+
+    def __init__(self, address: Optional[str] = None):
+        # 核心模块只在服务端导入
+        try:
+            from .core.stub_processor import StubProcessor
+            from .core.anchor_index import AnchorIndex
+            from .core.lint import ScanCache
+            from .core.utils import sync_output_tree
+            from .core import timing
+        except ImportError:
+            from code.core.stub_processor import StubProcessor
+            from code.core.anchor_index import AnchorIndex
+            from code.core.lint import ScanCache
+            from code.core.utils import sync_output_tree
+            from code.core import timing
+        self._processor_class = StubProcessor
+        self._timing = timing
+        self._signature = AnchorIndex.signature
+        self._sync_output_tree = sync_output_tree
+        self.address = address or default_address()
+        self.anchor_index = AnchorIndex()
+        # 锚点检查的扫描结果与YAML配置无关，所有配置共用
+        self.scan_cache = ScanCache()
+        self._processors: Dict[Optional[str], Any] = {}
+        self._processors_lock = threading.Lock()
+        # 每个结果目录一把锁，同一目录的插桩与同步依次进行
+        self._output_locks: Dict[str, threading.Lock] = {}
+        self._started = time.time()
+        self._requests = 0
+        self._requests_lock = threading.Lock()
+        self._running = False
+        self._key: Optional[bytes] = None
+
+    def _get_processor(self, yaml_file: Optional[str]):
+        """
+        按YAML文件获取处理器，文件签名未变时复用已解析的配置
+
+        Returns:
+            Tuple[Optional[StubProcessor], str]: (处理器, 错误信息)
+        """
+        yaml_file = os.path.abspath(yaml_file) if yaml_file else None
+        signature = self._signature(yaml_file) if yaml_file else None
+        if yaml_file and signature is None:
+            return None, f"YAML配置文件不存在: {yaml_file}"
+        # 加载期间持有锁，并发请求不会重复解析同一配置
+        with self._processors_lock:
+            cached = self._processors.get(yaml_file)
+            if cached is not None and cached[0] == signature:
+                return cached[1], ""
+            processor = self._processor_class()
+            if yaml_file and not processor.set_yaml_file(yaml_file):
+                return None, f"加载YAML配置失败: {yaml_file}"
+            self._processors[yaml_file] = (signature, processor)
+        logger.info("已加载YAML配置: %s", yaml_file)
+        return processor, ""
+
+    def _output_lock(self, output_dir: str) -> threading.Lock:
+        """返回结果目录对应的锁"""
+        with self._processors_lock:
+            return self._output_locks.setdefault(os.path.abspath(output_dir), threading.Lock())
+
+    def handle(self, request: Dict[str, Any]) -> Dict[str, Any]:
+        """处理一个请求并返回响应"""
+        start = time.perf_counter()
+        if not isinstance(request, dict):
+            return {"ok": False, "error": "请求格式错误"}
+        op = request.get("op")
+        params = request.get("params") or {}
+        handler = getattr(self, f"_op_{op}", None) if isinstance(op, str) else None
+        if handler is None:
+            return {"ok": False, "error": f"未知请求: {op}"}
+        with self._requests_lock:
+            self._requests += 1
+        try:
+            response = handler(**params)
+        except Exception as e:
+            logger.exception("处理请求 %s 失败", op)
+            response = {"ok": False, "error": f"处理请求失败: {e}"}
+        response["elapsed_ms"] = round((time.perf_counter() - start) * 1000, 1)
+        return response
+
+    def _op_ping(self) -> Dict[str, Any]:
+        return {
+            "ok": True,
+            "pid": os.getpid(),
+            "uptime": round(time.time() - self._started, 1),
+            "requests": self._requests,
+            "cached_yaml": len(self._processors),
+            "indexed_files": len(self.anchor_index),
+            "index_hits": self.anchor_index.hits,
+            "index_misses": self.anchor_index.misses,
+            "scanned_files": len(self.scan_cache),
+        }
+
+    def _op_weave(self, root: str, yaml: Optional[str] = None, jobs: int = 1,
+                  output: Optional[str] = None, depfile: bool = False,
+                  timings: bool = False, trace: Optional[str] = None) -> Dict[str, Any]:
+        processor, error = self._get_processor(yaml)
+        if processor is None:
+            return {"ok": False, "error": error}
+        tracer = None
+        if trace:
+            try:
+                from .core.trace import TraceRecorder
+            except ImportError:
+                from code.core.trace import TraceRecorder
+            tracer = TraceRecorder()
+        timer = self._timing.PhaseTimer(tracer) if timings or tracer else None
+        # 未指定时使用固定结果目录，跨请求增量更新
+        output = output or f"{os.path.abspath(root)}_stubbed"
+        with self._output_lock(output):
+            result = processor.process_directory(root, stubbed_dir=output, max_workers=jobs, create_sample=False,
+                                                 anchor_index=self.anchor_index, incremental=True,
+                                                 depfiles=depfile, timer=timer)
+            if os.path.isdir(root):
+                with self._timing.measure(timer, 'copy'):
+                    self._sync_output_tree(root, output, incremental=True)
+        if timer is not None:
+            timer.stop()
+            result["timings"] = timer.to_dict()
+            if not timings:
+                result.pop("timings")
+        if tracer is not None and not tracer.write(trace):
+            result["errors"].append({"file": trace, "error": "写出跟踪文件失败"})
+        result.pop("backup_dir", None)
+        return {"ok": True, "result": result}
+
+    def _op_lint(self, root: str, yaml: Optional[str] = None, jobs: int = 1) -> Dict[str, Any]:
+        processor, error = self._get_processor(yaml)
+        if processor is None:
+            return {"ok": False, "error": error}
+        return {"ok": True, "result": processor.check_directory(root, scan_cache=self.scan_cache, max_workers=jobs)}
+
+    def _op_extract(self, root: str, output: str) -> Dict[str, Any]:
+        processor, error = self._get_processor(None)
+        if processor is None:
+            return {"ok": False, "error": error}
+        success = processor.extract_to_yaml(root, output)
+        return {"ok": bool(success), "result": {"output": output},
+                "error": "" if success else f"导出YAML失败: {output}"}
+
+    def _op_shutdown(self) -> Dict[str, Any]:
+        self._running = False
+        return {"ok": True}
+
+    def _serve_connection(self, conn) -> None:
+        """在独立线程中处理一个连接"""
+        with conn:
+            try:
+                request = conn.recv()
+            except (EOFError, OSError):
+                return
+            response = self.handle(request)
+            try:
+                conn.send(response)
+            except (EOFError, OSError) as e:
+                logger.warning("发送响应失败: %s", e)
+        if not self._running:
+            self._wake()
+
+    def _wake(self) -> None:
+        """连接一次自身，使阻塞在 ``accept`` 中的主线程检查退出标志"""
+        try:
+            Client(self.address, authkey=self._key).close()
+        except (OSError, EOFError):
+            pass
+
+    def serve(self) -> int:
+        """
+        开始监听并处理请求，直到收到 ``shutdown`` 请求或被中断
+
+        Returns:
+            int: 退出码，地址已被其他守护进程占用或运行目录不可用时返回1
+        """
+        key = _authkey(create=True)
+        if self.address is None or key is None:
+            logger.error("守护进程运行目录或密钥不可用")
+            return 1
+        if send_request("ping", self.address) is not None:
+            logger.error("守护进程已在运行: %s", self.address)
+            return 1
+        # 清理上次异常退出遗留的套接字文件
+        if sys.platform != "win32" and os.path.exists(self.address):
+            os.remove(self.address)
+
+        self._key = key
+        self._running = True
+        workers = []
+        with Listener(self.address, authkey=key) as listener:
+            logger.warning("YAMLWeave守护进程已启动: %s (pid %d)", self.address, os.getpid())
+            while self._running:
+                try:
+                    conn = listener.accept()
+                except KeyboardInterrupt:
+                    break
+                except Exception as e:
+                    logger.warning("拒绝连接: %s", e)
+                    continue
+                if not self._running:
+                    conn.close()
+                    break
+                worker = threading.Thread(target=self._serve_connection, args=(conn,),
+                                          name="daemon-request", daemon=True)
+                worker.start()
+                workers = [w for w in workers if w.is_alive()]
+                workers.append(worker)
+        # 收到shutdown时等待进行中的请求完成，避免结果目录只写出一半
+        if not self._running:
+            for worker in workers:
+                worker.join()
+        logger.warning("YAMLWeave守护进程已退出")
+        return 0
@@ -5,5 +5,6 @@ YAMLWeave处理器模块 (精简版)
 
 from .yaml_handler import YamlStubHandler
 from .comment_handler import CommentHandler
+from .stub_template import StubTemplate
 
 __version__ = "1.0.0" 
\ No newline at end of file
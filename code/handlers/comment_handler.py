@@ -3,7 +3,6 @@
 处理传统模式下C代码注释中的桩代码提取
 """
 
-import re
 import logging
 from typing import Dict, List, Tuple, Optional, Any
 
@@ -23,16 +22,22 @@ if not logger.hasHandlers():
     logger.addHandler(handler)
     logger.warning("使用基本日志配置")
 
+# 导入统一插桩引擎
+try:
+    from ..core import weave_engine
+except Exception:
+    from code.core import weave_engine
+
 class CommentHandler:
     """处理桩代码插入，支持两种锚点格式"""
     
     def __init__(self):
+        # 匹配规则统一定义在 weave_engine 中
         # 传统格式 - 测试用例ID匹配模式 (如 TC001 STEP1:)
-        self.test_case_pattern = re.compile(r'//\s*(TC\d+\s+STEP\d+):', re.IGNORECASE)
+        self.test_case_pattern = weave_engine.TRADITIONAL_PATTERN
         
-        # 新格式 - 锚点匹配模式 (如 TC001 STEP1 segment1)
-        # 使用更宽松的模式，允许锚点后有其他文本
-        self.anchor_pattern = re.compile(r'//\s*(TC\d+\s+STEP\d+\s+\w+).*', re.IGNORECASE)
+        # 新格式 - 锚点匹配模式 (如 TC001 STEP1 segment1)，允许锚点后有其他文本
+        self.anchor_pattern = weave_engine.ANCHOR_PATTERN
     
     def find_comment_insertion_point(self, lines: List[str], stub_info: Dict[str, Any]) -> Tuple[int, bool]:
         """
@@ -108,19 +113,9 @@ class CommentHandler:
             logger.error(f"无效的插入位置: {insertion_point}")
             return False
         
-        # 拆分代码为多行，并添加标记
         # 对于每一行非空代码，添加"// 通过桩插入"标记
-        code_lines = code.splitlines()
-        marked_code = []
-        for line in code_lines:
-            if line.strip():
-                marked_code.append(f"{line}  // 通过桩插入")
-            else:
-                marked_code.append(line)
-        
-        # 在指定位置插入代码
-        for i, code_line in enumerate(marked_code):
-            lines.insert(insertion_point + i, code_line)
+        marked_code = weave_engine.format_stub(code, mark_blank=False)
+        lines[insertion_point:insertion_point] = marked_code
         
         logger.info(f"在行 {insertion_point} 后插入了 {len(marked_code)} 行代码")
         return True
@@ -0,0 +1,229 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+桩代码模板模块
+支持在YAML代码段中使用 ``${...}`` 占位符，并在锚点处按上下文填充
+
+模板在加载YAML时一次性编译为渲染函数（基于 ``str.format_map``），
+插桩时只需对每个锚点执行一次渲染，不再重复解析模板文本。
+
+支持的占位符：
+- ``${file}``：源文件名，如 ``Demo1.1.c``
+- ``${file_stem}``：不含扩展名的源文件名，如 ``Demo1.1``
+- ``${func}``：锚点所在的函数名（按需计算）
+- ``${line}``：锚点所在行号（从1开始）
+- ``${tc}`` / ``${step}`` / ``${segment}``：锚点标识的三个部分
+- ``${arg1}``、``${arg2}`` ...：锚点中代码段ID之后的附加参数
+- ``${args}``：全部附加参数（以空格连接）
+- ``${name}``：锚点中以 ``name=value`` 形式给出的命名参数
+
+``$${`` 表示字面量 ``${``，不做替换。未知占位符保持原样输出。
+"""
+
+import os
+import re
+from typing import Callable, Dict, List, Optional, Sequence
+
+# 占位符匹配模式 - ``$${`` 为转义，``${name}`` 为占位符
+PLACEHOLDER_PATTERN = re.compile(r'\$\$\{|\$\{\s*([A-Za-z_][A-Za-z0-9_]*)\s*\}')
+
+# C函数定义行匹配模式 - 仅识别顶格书写的函数头，如 "int foo(int a) {"
+FUNCTION_DEF_PATTERN = re.compile(
+    r'^[A-Za-z_][\w\s\*]*?\b([A-Za-z_]\w*)\s*\([^;{}]*\)\s*\{?\s*$'
+)
+
+# 不属于函数名的C关键字
+_NON_FUNCTION_KEYWORDS = {'if', 'for', 'while', 'switch', 'return', 'sizeof', 'else', 'do'}
+
+
+def has_placeholders(text: str) -> bool:
+    """判断代码段文本中是否包含模板占位符"""
+    return '${' in text
+
+
+class StubTemplate:
+    """
+    编译后的桩代码模板
+
+    模板文本被转换为 ``str.format`` 格式串，渲染时直接调用
+    ``format_map``，由解释器内部完成拼接。
+    """
+
+    __slots__ = ('source', 'fields', '_render')
+
+    def __init__(self, source: str):
+        self.source = source
+        fields = []
+        pieces = []
+        pos = 0
+        for match in PLACEHOLDER_PATTERN.finditer(source):
+            pieces.append(_escape_braces(source[pos:match.start()]))
+            name = match.group(1)
+            if name is None:
+                # $${ 转义为字面量 ${
+                pieces.append('${{')
+            else:
+                pieces.append('{' + name + '}')
+                if name not in fields:
+                    fields.append(name)
+            pos = match.end()
+        pieces.append(_escape_braces(source[pos:]))
+
+        self.fields = tuple(fields)
+        self._render = ''.join(pieces).format_map
+
+    def render(self, context: Dict[str, str]) -> str:
+        """
+        使用锚点上下文渲染模板
+
+        Args:
+            context: 占位符取值映射，推荐使用 :class:`AnchorContext`
+
+        Returns:
+            str: 渲染后的桩代码
+        """
+        if not isinstance(context, AnchorContext):
+            context = AnchorContext(context)
+        return self._render(context)
+
+
+class AnchorContext(dict):
+    """
+    锚点上下文
+
+    普通字段在构造时直接填入；``func`` 等开销较大的字段只在模板
+    实际引用时才计算。未知字段渲染为原始占位符文本。
+    """
+
+    def __init__(self, values: Optional[Dict[str, str]] = None,
+                 lines: Optional[Sequence[str]] = None, line_index: int = -1):
+        super().__init__(values or {})
+        self._lines = lines
+        self._line_index = line_index
+
+    def __missing__(self, key: str) -> str:
+        if key == 'func' and self._lines is not None:
+            value = find_enclosing_function(self._lines, self._line_index) or ''
+            self[key] = value
+            return value
+        return '${' + key + '}'
+
+
+def build_anchor_context(file_path: str, lines: Sequence[str], line_index: int,
+                         test_case_id: str, step_id: str, segment_id: str,
+                         args: Optional[List[str]] = None) -> AnchorContext:
+    """
+    构建锚点上下文
+
+    Args:
+        file_path: 源文件路径
+        lines: 源文件行列表
+        line_index: 锚点所在行索引（从0开始）
+        test_case_id: 测试用例ID
+        step_id: 步骤ID
+        segment_id: 代码段ID
+        args: 锚点中代码段ID之后的附加参数
+
+    Returns:
+        AnchorContext: 可直接用于 :meth:`StubTemplate.render` 的上下文
+    """
+    file_name = os.path.basename(file_path)
+    values = {
+        'file': file_name,
+        'file_stem': os.path.splitext(file_name)[0],
+        'line': str(line_index + 1),
+        'tc': test_case_id,
+        'step': step_id,
+        'segment': segment_id,
+    }
+
+    positional = []
+    for arg in args or []:
+        name, sep, value = arg.partition('=')
+        if sep and name.isidentifier():
+            values[name] = value
+        else:
+            positional.append(arg)
+    for i, arg in enumerate(positional, start=1):
+        values[f'arg{i}'] = arg
+    values['args'] = ' '.join(positional)
+
+    return AnchorContext(values, lines, line_index)
+
+
+def make_anchor_lookup(get_stub_code: Callable[..., Optional[str]], file_path: str,
+                       lines: Sequence[str]) -> Callable[..., Optional[str]]:
+    """
+    创建按锚点查找桩代码的函数，供 StubParser 与降级处理器等各前端共用
+
+    Args:
+        get_stub_code: 与 ``YamlStubHandler.get_stub_code`` 签名相同的查找函数，
+            模板代码段按传入的上下文渲染
+        file_path: 源文件路径
+        lines: 源文件行列表
+
+    Returns:
+        Callable: 参数为 ``weave_engine.Anchor``、返回桩代码或None的查找函数
+    """
+    def lookup(anchor) -> Optional[str]:
+        context = build_anchor_context(
+            file_path, lines, anchor.line_index, anchor.test_case_id,
+            anchor.step_id, anchor.segment_id, list(anchor.args)
+        )
+        return get_stub_code(anchor.test_case_id, anchor.step_id, anchor.segment_id, context)
+
+    return lookup
+
+
+def find_enclosing_function(lines: Sequence[str], line_index: int) -> Optional[str]:
+    """
+    向上查找锚点所在的函数名
+
+    支持函数头与左花括号分行书写的风格；遇到顶格的右花括号即认为
+    已离开上一个函数体，停止查找。
+
+    Args:
+        lines: 源文件行列表
+        line_index: 锚点所在行索引
+
+    Returns:
+        Optional[str]: 函数名，未找到时返回None
+    """
+    for i in range(min(line_index, len(lines) - 1), -1, -1):
+        line = lines[i]
+        if line.startswith('}'):
+            return None
+        match = FUNCTION_DEF_PATTERN.match(line)
+        if match and match.group(1) not in _NON_FUNCTION_KEYWORDS:
+            return match.group(1)
+    return None
+
+
+def compile_stub_templates(stub_data: Dict) -> Dict[tuple, StubTemplate]:
+    """
+    预编译YAML配置中所有包含占位符的代码段
+
+    Args:
+        stub_data: YAML解析得到的 ``{TC: {STEP: {segment: code}}}`` 结构
+
+    Returns:
+        Dict[tuple, StubTemplate]: 以 ``(TC, STEP, segment)`` 为键的模板表
+    """
+    templates = {}
+    if not isinstance(stub_data, dict):
+        return templates
+    for tc_id, steps in stub_data.items():
+        if not isinstance(steps, dict):
+            continue
+        for step_id, segments in steps.items():
+            if not isinstance(segments, dict):
+                continue
+            for segment_id, code in segments.items():
+                if isinstance(code, str) and has_placeholders(code):
+                    templates[(tc_id, step_id, segment_id)] = StubTemplate(code)
+    return templates
+
+
+def _escape_braces(text: str) -> str:
+    """转义字面量花括号，避免被 ``str.format`` 解释"""
+    return text.replace('{', '{{').replace('}', '}}')
@@ -7,10 +7,14 @@ YAML处理器模块
 """
 
 import os
-import yaml
 import logging
 from typing import Dict, List, Any, Optional, Tuple
 
+try:
+    from .stub_template import compile_stub_templates
+except Exception:
+    from handlers.stub_template import compile_stub_templates
+
 try:
     from ..utils.logger import get_logger
 except Exception:
@@ -59,6 +63,8 @@ class YamlStubHandler:
         """
         self.yaml_file_path = yaml_file_path
         self.stub_data = {}
+        # 预编译的代码段模板，键为 (TC, STEP, segment)
+        self.templates = {}
         
         if yaml_file_path and os.path.exists(yaml_file_path):
             self.load_yaml(yaml_file_path)
@@ -207,8 +213,38 @@ class YamlStubHandler:
             self.stub_data = {}
             return False
             
+    def set_stub_data(self, stub_data: Dict[str, Any], yaml_file_path: Optional[str] = None) -> None:
+        """
+        直接设置已解析的桩代码配置（如从缓存读取），并预编译模板代码段
+        
+        Args:
+            stub_data: 与 ``load_yaml`` 解析结果相同结构的配置
+            yaml_file_path: 配置来源文件路径，可选
+        """
+        self.stub_data = stub_data
+        self.yaml_file_path = yaml_file_path
+        self._compile_templates()
+    
     def _read_and_process_yaml(self, yaml_file_path: str) -> bool:
+        """读取并解析YAML文件，随后预编译其中的模板代码段"""
+        result = self._load_stub_data(yaml_file_path)
+        self._compile_templates()
+        return result
+
+    def _compile_templates(self) -> None:
+        """将包含 ``${...}`` 占位符的代码段一次性编译为渲染函数"""
+        try:
+            self.templates = compile_stub_templates(self.stub_data)
+            if self.templates:
+                logger.info(f"已预编译 {len(self.templates)} 个模板代码段")
+        except Exception as e:
+            logger.error(f"预编译模板代码段失败: {str(e)}")
+            self.templates = {}
+
+    def _load_stub_data(self, yaml_file_path: str) -> bool:
         """处理YAML文件读取和解析的核心逻辑"""
+        # PyYAML只在真正加载配置时导入，缩短命令行模式的启动时间
+        import yaml
         try:
             # 打印文件信息用于调试
             try:
@@ -221,11 +257,17 @@ class YamlStubHandler:
             encodings_to_try = ['utf-8', 'gbk', 'gb18030', 'gb2312', 'utf-16', 'big5', 'latin1']
             content = None
             
-            # 首先尝试检测编码
+            # 首先尝试检测编码；UTF-8可直接解码时无需导入chardet
             try:
-                import chardet
                 with open(yaml_file_path, 'rb') as f:
                     content_bytes = f.read()
+                try:
+                    content_bytes.decode('utf-8')
+                    needs_detection = False
+                except UnicodeDecodeError:
+                    needs_detection = True
+                if needs_detection:
+                    import chardet
                     result = chardet.detect(content_bytes)
                     detected_encoding = result['encoding']
                     confidence = result['confidence']
@@ -538,17 +580,20 @@ if (!buffer) {
             self.yaml_file_path = yaml_file_path
             return True
     
-    def get_stub_code(self, test_case_id: str, step_id: str, segment_id: str) -> Optional[str]:
+    def get_stub_code(self, test_case_id: str, step_id: str, segment_id: str,
+                      context: Optional[Dict[str, str]] = None) -> Optional[str]:
         """
         获取特定锚点对应的桩代码
         
         按照文档中描述的格式，从YAML配置中查找对应的桩代码。
         使用块字符格式：以"|"标记的代码块，保留所有换行符和缩进。
+        若代码段包含 ``${...}`` 占位符，则使用锚点上下文渲染预编译的模板。
         
         Args:
             test_case_id: 测试用例ID，如"TC001"
             step_id: 步骤ID，如"STEP1"
             segment_id: 代码段标识，如"segment1"
+            context: 锚点上下文，用于填充模板占位符，可选
             
         Returns:
             Optional[str]: 找到的桩代码，未找到则返回None
@@ -556,17 +601,17 @@ if (!buffer) {
         try:
             # 检查测试用例是否存在
             if test_case_id not in self.stub_data:
-                logger.warning(f"未找到测试用例: {test_case_id}")
+                logger.debug("未找到测试用例: %s", test_case_id)
                 return None
             
             # 检查步骤是否存在
             if step_id not in self.stub_data[test_case_id]:
-                logger.warning(f"未找到步骤: {test_case_id} {step_id}")
+                logger.debug("未找到步骤: %s %s", test_case_id, step_id)
                 return None
             
             # 检查代码段是否存在
             if segment_id not in self.stub_data[test_case_id][step_id]:
-                logger.warning(f"未找到代码段: {test_case_id} {step_id} {segment_id}")
+                logger.debug("未找到代码段: %s %s %s", test_case_id, step_id, segment_id)
                 return None
             
             # 获取代码段内容
@@ -574,14 +619,17 @@ if (!buffer) {
             
             # 直接返回代码内容，YAML解析器已处理好格式
             if isinstance(code_content, str):
-                logger.info(f"使用块格式的代码段: {test_case_id} {step_id} {segment_id}")
+                logger.debug("使用块格式的代码段: %s %s %s", test_case_id, step_id, segment_id)
+                template = self.templates.get((test_case_id, step_id, segment_id))
+                if template is not None:
+                    return template.render(context or {})
                 return code_content
             else:
-                logger.error(f"代码段格式不支持，类型: {type(code_content)}")
+                logger.error("代码段格式不支持，类型: %s", type(code_content))
                 return None
             
         except Exception as e:
-            logger.error(f"获取桩代码失败: {str(e)}")
+            logger.error("获取桩代码失败: %s", e)
             return None
     
     def parse_anchor(self, x: str) -> Tuple[Optional[str], Optional[str], Optional[str]]:
@@ -123,8 +123,10 @@ def setup_import_paths():
 setup_import_paths()
 
 from utils.logger import setup_global_logger
+from utils.config import config as app_config
 
-setup_global_logger()
+app_config.load_config()
+setup_global_logger(performance=app_config.is_performance_logging())
 
 def safe_ui_log(ui, message, tag=None):
     """Safely call ui.log with optional tag support."""
@@ -994,7 +996,7 @@ def create_fallback_controller(ui_instance):
             levels = ["完整功能", "降级功能", "最小功能"]
             logger.info(f"控制器功能级别: {levels[self.controller_level]}")
             if self.ui:
-                self.ui.root.after(0, self.ui.log, f"[系统] 初始化控制器功能级别: {levels[self.controller_level]}")
+                self.ui.log(f"[系统] 初始化控制器功能级别: {levels[self.controller_level]}")
         
         def create_minimal_stub_processor(self):
             """
@@ -1040,6 +1042,7 @@ def create_fallback_controller(ui_instance):
                     self.project_dir = project_dir
                     self.yaml_file = yaml_file
                     self.yaml_config = {}
+                    self.yaml_handler = None
                     self.stats = {"scanned_files": 0, "updated_files": 0, "inserted_stubs": 0, "failed_files": 0}
                     self.ui = ui
                     
@@ -1047,7 +1050,7 @@ def create_fallback_controller(ui_instance):
                     self.backup_dir = None
                     self.output_dir = None
                     
-                    if yaml_file and os.path.exists(yaml_file):
+                    if yaml_file and os.path.exists(yaml_file) and not self._load_yaml_handler(yaml_file):
                         try:
                             import yaml
                             with open(yaml_file, 'r', encoding='utf-8') as f:
@@ -1055,305 +1058,119 @@ def create_fallback_controller(ui_instance):
                                 if not self.yaml_config:
                                     logger.warning(f"YAML配置文件为空或格式不正确: {yaml_file}")
                                     if self.ui:
-                                        self.ui.root.after(0, self.ui.log, f"[警告] YAML配置为空或格式不正确: {yaml_file}")
+                                        self.ui.log(f"[警告] YAML配置为空或格式不正确: {yaml_file}")
                         except ImportError:
                             logger.error("无法导入yaml模块，YAML配置将不可用")
                             if self.ui:
-                                self.ui.root.after(0, self.ui.log, "[错误] 无法导入yaml模块，YAML配置将不可用")
+                                self.ui.log("[错误] 无法导入yaml模块，YAML配置将不可用")
                         except Exception as e:
                             logger.error(f"加载YAML配置失败: {str(e)}")
                             if self.ui:
-                                self.ui.root.after(0, self.ui.log, f"[错误] 加载YAML配置失败: {str(e)}")
+                                self.ui.log(f"[错误] 加载YAML配置失败: {str(e)}")
+                
+                def _load_yaml_handler(self, yaml_file):
+                    """
+                    优先用 YamlStubHandler 加载YAML配置，与核心处理器一样编译模板代码段
+                    
+                    返回:
+                        bool: 是否加载成功；处理器无法导入或加载失败时由调用方直接解析YAML
+                    """
+                    try:
+                        try:
+                            from code.handlers.yaml_handler import YamlStubHandler
+                        except ImportError:
+                            from handlers.yaml_handler import YamlStubHandler
+                        handler = YamlStubHandler()
+                        if not handler.load_yaml(yaml_file):
+                            return False
+                    except Exception as e:
+                        logger.warning(f"无法使用YamlStubHandler加载YAML配置: {str(e)}")
+                        return False
+                    self.yaml_handler = handler
+                    self.yaml_config = handler.stub_data
+                    return True
+                
+                def _get_stub_code(self, test_case_id, step_id, segment_id, context=None):
+                    """
+                    查找桩代码；原样的标识找不到时按旧版降级处理器的规则
+                    （TC与STEP大写、代码段小写）再查一次
+                    """
+                    if self.yaml_handler is not None:
+                        get = self.yaml_handler.get_stub_code
+                    else:
+                        # 未能使用YamlStubHandler时直接查YAML字典，模板占位符不做替换
+                        yaml_config = self.yaml_config if isinstance(self.yaml_config, dict) else {}
+                        
+                        def get(tc_id, step, segment, context=None):
+                            steps = yaml_config.get(tc_id)
+                            segments = steps.get(step) if isinstance(steps, dict) else None
+                            code = segments.get(segment) if isinstance(segments, dict) else None
+                            return code if isinstance(code, str) else None
+                    code = get(test_case_id, step_id, segment_id, context)
+                    normalized = (test_case_id.upper(), step_id.upper(), segment_id.lower())
+                    if code is None and normalized != (test_case_id, step_id, segment_id):
+                        code = get(*normalized, context)
+                    return code
                 
                 def process_single_file(self, content, file_path, callback=None):
                     """
                     处理单个文件内容，执行桩代码插入
                     返回处理后的文件内容
                     
+                    锚点扫描、模板渲染与代码拼接使用与核心处理器相同的 weave_engine 和
+                    make_anchor_lookup，``${file}``/``${line}``/``${func}`` 等占位符同样按锚点上下文填充。
+                    插入格式与 StubParser 一致：沿用锚点缩进、每行带标记，
+                    不再像旧版降级处理器那样在桩代码后追加空行。
+                    
                     参数:
                         content: 文件内容
                         file_path: 文件路径
-                        callback: 可选回调函数，用于报告处理进度
+                        callback: 可选回调函数，文件处理完成后报告一次进度
                     """
                     try:
-                        logger.info(f"处理文件内容: {file_path}")
-                        if self.ui:
-                            self.ui.log(f"[处理] 正在处理: {os.path.basename(file_path)}")
-                        
-                        # 保存当前处理的文件路径和内容，供钩子函数使用
-                        self.current_file = file_path
-                        self.current_content = content
+                        try:
+                            from code.core import weave_engine
+                            from code.handlers.stub_template import make_anchor_lookup
+                        except ImportError:
+                            from core import weave_engine
+                            from handlers.stub_template import make_anchor_lookup
                         
-                        # 存储原始内容以便检查是否有变化
-                        original_content = content
-                        updated_content = content
+                        logger.info(f"处理文件内容: {file_path}")
+                        file_name = os.path.basename(file_path)
                         lines = content.splitlines()
+                        find_stub = make_anchor_lookup(self._get_stub_code, file_path, lines)
                         
-                        # 计数器-用于跟踪修改过的行数
-                        inserted_stubs = 0
+                        def lookup(anchor):
+                            # 使用钩子函数 - 如果控制器注入了hook
+                            if hasattr(self, 'anchor_hook'):
+                                try:
+                                    self.anchor_hook(file_name, anchor.line_index + 1, anchor.test_case_id,
+                                                     anchor.step_id, anchor.segment_id)
+                                except Exception as e:
+                                    logger.error(f"调用锚点钩子失败: {str(e)}")
+                            return find_stub(anchor)
                         
-                        # 处理每一行
-                        i = 0
-                        total_lines = len(lines)
-                        while i < total_lines:
-                            # 设置当前处理的行号，用于钩子函数和拦截函数
-                            self.current_line = i + 1
-                            
-                            # 调用进度回调
-                            if callback:
-                                progress = int((i / total_lines) * 100)
-                                callback(progress, f"处理文件 {os.path.basename(file_path)}: {i+1}/{total_lines} 行")
-                            
-                            line = lines[i]
-                            
-                            # 搜索注释中的锚点
-                            # 样式1: // TC001 STEP1 segment1 
-                            # 样式2: // TC001 STEP1: 数据边界检查
-                            # 样式3: // TC001 STEP1 format_check
-                            anchor_match = None
-                            
-                            if "//" in line and "TC" in line and "STEP" in line:
-                                # 尝试匹配锚点模式
-                                comment_part = line.split("//")[1].strip()
-                                parts = comment_part.split()
-                                
-                                # 直接输出调试信息到控制台
-                                print(f"\n==== MinimalStubProcessor检测到锚点 ====")
-                                print(f"文件: {os.path.basename(file_path)}")
-                                print(f"行号: {i+1}")
-                                print(f"内容: {line.strip()}")
-                                print(f"Parts: {parts}")
-                                print("=====================================\n")
-                                
-                                if len(parts) >= 3 and parts[0].startswith("TC") and parts[1].startswith("STEP"):
-                                    tc_id = parts[0].upper()
-                                    step_id = parts[1].upper()
-                                    segment_id = parts[2].lower()
-                                    
-                                    # 直接输出锚点信息到控制台
-                                    print(f"\n==== 确认锚点 ====")
-                                    print(f"文件: {os.path.basename(file_path)}")
-                                    print(f"行号: {i+1}")
-                                    print(f"锚点: {tc_id} {step_id} {segment_id}")
-                                    print("=================\n")
-                                    
-                                    # 使用钩子函数 - 如果控制器注入了hook
-                                    if hasattr(self, 'anchor_hook'):
-                                        try:
-                                            self.anchor_hook(os.path.basename(file_path), i+1, tc_id, step_id, segment_id)
-                                        except Exception as e:
-                                            print(f"调用锚点钩子失败: {str(e)}")
-                                            import traceback
-                                            print(traceback.format_exc())
-                                    
-                                    # 直接输出锚点信息到UI
-                                    if self.ui:
-                                        try:
-                                            anchor_message = f"[锚点] 在文件 {os.path.basename(file_path)} 的第 {i+1} 行找到锚点: {tc_id} {step_id} {segment_id}"
-                                            
-                                            # 直接尝试多种方式将信息输出到UI
-                                            
-                                            # 方法1: 直接调用log方法
-                                            self.ui.log(anchor_message, tag="find")
-                                            self.ui.log(f"[代码] {line.strip()}", tag="info")
-                                            
-                                            # 方法2: 直接操作Text控件
-                                            if hasattr(self.ui, 'log_text'):
-                                                import tkinter as tk
-                                                import datetime
-                                                timestamp = datetime.datetime.now().strftime("[%H:%M:%S] ")
-                                                self.ui.log_text.insert(tk.END, timestamp, "info")
-                                                self.ui.log_text.insert(tk.END, anchor_message + "\n", "find")
-                                                self.ui.log_text.see(tk.END)
-                                                self.ui.log_text.update_idletasks()
-                                            
-                                            # 方法3: 使用after方法
-                                            if hasattr(self.ui, 'root'):
-                                                try:
-                                                    self.ui.root.after(100, lambda: self.ui.log(f"[锚点后续] {tc_id} {step_id} {segment_id} @ {os.path.basename(file_path)}:{i+1}", tag="find"))
-                                                except Exception as e:
-                                                    print(f"使用after方法失败: {str(e)}")
-                                        except Exception as e:
-                                            print(f"UI日志输出失败: {str(e)}")
-                                            import traceback
-                                            print(traceback.format_exc())
-                                    
-                                    anchor_match = {
-                                        "tc_id": tc_id,
-                                        "step_id": step_id,
-                                        "segment_id": segment_id
-                                    }
-                                    
-                                    logger.info(f"找到锚点: {tc_id} {step_id} {segment_id}")
-                            
-                            # 如果找到锚点，尝试插入代码
-                            if anchor_match:
-                                tc_id = anchor_match["tc_id"]
-                                step_id = anchor_match["step_id"]
-                                segment_id = anchor_match["segment_id"]
-                                
-                                # 1. 首先检查YAML配置
-                                if self.yaml_config and tc_id in self.yaml_config:
-                                    tc_config = self.yaml_config[tc_id]
-                                    
-                                    # 查找对应步骤
-                                    if step_id in tc_config:
-                                        step_config = tc_config[step_id]
-                                        
-                                        # 查找对应段
-                                        stub_code = None
-                                        if segment_id and segment_id in step_config:
-                                            stub_code = step_config[segment_id]
-                                            # 输出锚点信息到UI - 确保锚点信息被直接输出
-                                            if self.ui:
-                                                try:
-                                                    filename = os.path.basename(file_path)
-                                                    print(f"检测YAML配置锚点: {tc_id} {step_id} {segment_id} 行号: {i+1}")
-                                                    anchor_message = f"[锚点] 在文件 {filename} 的第 {i+1} 行找到YAML配置锚点: {tc_id} {step_id} {segment_id}"
-                                                    self.ui.log(anchor_message, tag="find")
-                                                    # 显示代码内容
-                                                    if i < len(lines):
-                                                        self.ui.log(f"[代码] {lines[i].strip()}", tag="info")
-                                                except Exception as e:
-                                                    print(f"输出YAML配置锚点信息失败: {str(e)}")
-                                        
-                                        if stub_code:
-                                            # 插入桩代码
-                                            indent = len(line) - len(line.lstrip())
-                                            indent_str = " " * indent
-                                            
-                                            # 准备插入的代码行
-                                            code_lines = []
-                                            for code_line in stub_code.splitlines():
-                                                # 为每行添加插桩注释
-                                                code_lines.append(f"{code_line}  // 通过桩插入")
-                                            
-                                            # 插入代码行
-                                            lines.insert(i + 1, "")  # 空行
-                                            for idx, code_line in enumerate(code_lines):
-                                                full_line = f"{indent_str}{code_line}"
-                                                lines.insert(i + 1 + idx, full_line)
-                                                if self.ui and hasattr(self.ui, 'root'):
-                                                    self.ui.root.after(0, self.ui.log, f"[插桩行] {full_line}", "code")
-                                                    self.ui.root.after(0, self.ui.root.update_idletasks)
-                                                elif self.ui:
-                                                    self.ui.log(f"[插桩行] {full_line}", tag="code")
-                                            # 更新插入统计
-                                            inserted_stubs += 1
-                                            self.stats["inserted_stubs"] += 1
-                                            logger.info(f"从YAML插入桩代码: {tc_id} {step_id} {segment_id}")
-                                            
-                                            # 输出插桩信息到UI
-                                            if self.ui:
-                                                insertion_message = f"[插桩] 在文件 {os.path.basename(file_path)} 第 {i+1} 行插入 {tc_id} {step_id} {segment_id} 桩代码 ({len(code_lines)}行)"
-                                                self.ui.log(insertion_message, tag="insert")
-                                                
-                                                # 强化插桩信息显示
-                                                print(f"\n===== 插入桩代码信息 =====")
-                                                print(f"文件: {os.path.basename(file_path)}")
-                                                print(f"行号: {i+1}")
-                                                print(f"锚点: {tc_id} {step_id} {segment_id}")
-                                                print(f"插入行数: {len(code_lines)}")
-                                                print("========================")
-                                                
-                                                # 尝试多种方式确保显示
-                                                try:
-                                                    # 方式1: 使用强制显示格式
-                                                    enhanced_insertion = f"[插桩强制显示] {tc_id} {step_id} {segment_id} 在文件 {os.path.basename(file_path)}:{i+1} 插入{len(code_lines)}行"
-                                                    self.ui.log(enhanced_insertion, tag="insert")
-                                                    
-                                                    # 方式2: 使用after方法
-                                                    if hasattr(self.ui, 'root'):
-                                                        self.ui.root.after(30, lambda: self.ui.log(f"[插桩确认] {tc_id} {step_id} {segment_id} @ {os.path.basename(file_path)}:{i+1}", tag="insert"))
-                                                except Exception as e:
-                                                    print(f"增强插桩显示失败: {str(e)}")
-                                                
-                                                # 最多显示3行代码预览
-                                                preview_lines = code_lines[:3] if len(code_lines) > 3 else code_lines
-                                                for idx, preview in enumerate(preview_lines):
-                                                    self.ui.log(f"[代码] {' '*4}{preview}", tag="info")
-                                                if len(code_lines) > 3:
-                                                    self.ui.log(f"[代码] {' '*4}...还有 {len(code_lines)-3} 行未显示...", tag="info")
-                                
-                                # 2. 如果YAML配置不存在，则查找下一行是否包含code注释
-                                code_line = None
-                                if i + 1 < len(lines):
-                                    next_line = lines[i + 1]
-                                    if "//" in next_line and "code:" in next_line.lower():
-                                        code_part = next_line.split("code:")[1].strip()
-                                        code_line = code_part
-                                
-                                if code_line:
-                                    # 获取缩进
-                                    indent = len(line) - len(line.lstrip())
-                                    indent_str = " " * indent
-                                    
-                                    # 处理代码行 (可能有多个语句用分号分隔)
-                                    statements = code_line.split(";")
-                                    code_lines = []
-                                    
-                                    for stmt in statements:
-                                        stmt = stmt.strip()
-                                        if stmt:  # 忽略空语句
-                                            if stmt.endswith("}"):  # 处理包含 } 的语句
-                                                # 分离 } 和前面的代码
-                                                if stmt != "}":
-                                                    before_brace = stmt[:stmt.rfind("}")].strip()
-                                                    if before_brace:
-                                                        code_lines.append(f"{before_brace};  // 通过桩插入")
-                                                    code_lines.append("}  // 通过桩插入")
-                                                else:
-                                                    code_lines.append("}  // 通过桩插入")
-                                            else:
-                                                code_lines.append(f"{stmt};  // 通过桩插入")
-                                    
-                                    # 插入代码行
-                                    for idx, code_line in enumerate(code_lines):
-                                        full_line = f"{indent_str}{code_line}"
-                                        lines.insert(i + 2 + idx, full_line)
-                                        if self.ui and hasattr(self.ui, 'root'):
-                                            self.ui.root.after(0, self.ui.log, f"[插桩行] {full_line}", "code")
-                                            self.ui.root.after(0, self.ui.root.update_idletasks)
-                                        elif self.ui:
-                                            self.ui.log(f"[插桩行] {full_line}", tag="code")
-                                    # 更新插入统计
-                                    inserted_stubs += 1
-                                    self.stats["inserted_stubs"] += 1
-                                    logger.info(f"从注释插入桩代码: {tc_id} {step_id}")
-                                    
-                                    # 输出插桩信息到UI
-                                    if self.ui:
-                                        self.ui.log(f"[插桩] 在文件 {os.path.basename(file_path)} 第 {i+1} 行插入注释桩代码 ({len(code_lines)}行)", tag="insert")
-                                        # 最多显示3行代码预览
-                                        preview_lines = code_lines[:3] if len(code_lines) > 3 else code_lines
-                                        for idx, preview in enumerate(preview_lines):
-                                            self.ui.log(f"[代码] {' '*4}{preview}", tag="info")
-                                        if len(code_lines) > 3:
-                                            self.ui.log(f"[代码] {' '*4}...还有 {len(code_lines)-3} 行未显示...", tag="info")
-                                    
-                                    # 跳过刚插入的行
-                                    i += len(code_lines) + 1
-                                    continue
-                            
-                            i += 1
+                        insertions, anchors, missing = weave_engine.weave_lines(lines, lookup)
+                        for anchor in missing:
+                            logger.warning(f"未找到锚点 {anchor.text} 对应的桩代码 ({file_name}:{anchor.line_index + 1})")
                         
-                        # 检查是否需要更新文件
-                        if inserted_stubs > 0:
-                            # 构建更新后的内容
-                            updated_content = "\n".join(lines)
-                            
-                            if self.ui:
-                                self.ui.root.after(0, self.ui.log, f"[插桩] {os.path.basename(file_path)}: 已插入 {inserted_stubs} 个桩点")
-                            
-                            return updated_content
-                        else:
+                        if callback:
+                            callback(100, f"处理文件 {file_name}: 插入桩点 {len(insertions)} 个")
+                        
+                        if not insertions:
                             logger.info(f"文件无需更新: {file_path}")
                             return content
+                        
+                        self.stats["inserted_stubs"] += len(insertions)
+                        logger.info(f"{file_name}: 已插入 {len(insertions)} 个桩点")
+                        if self.ui:
+                            self.ui.log(f"[插桩] {file_name}: 已插入 {len(insertions)} 个桩点", "insert")
+                        return "\n".join(weave_engine.splice(lines, insertions))
                     except Exception as e:
                         error_msg = f"处理文件内容失败: {file_path}, 错误: {str(e)}"
                         logger.error(error_msg)
                         if self.ui:
-                            self.ui.root.after(0, self.ui.log, f"[错误] {error_msg}")
+                            self.ui.log(f"[错误] {error_msg}")
                         # 重新引发异常，让上层处理
                         raise
                 
@@ -1450,6 +1267,8 @@ def create_fallback_controller(ui_instance):
                         # 非UI环境下直接顺序处理
                         for idx in range(len(c_files)):
                             process_next_file(idx)
+            
+            return MinimalStubProcessor
 
     # 创建控制器实例并返回
     return FallbackAppController(ui_instance)
@@ -12,7 +12,19 @@ import traceback
 import shutil
 import datetime
 from typing import Callable, Dict, List, Optional, Any, Tuple
-from ..utils.logger import add_ui_handler
+from ..utils.logger import add_ui_handler, execution_stats, save_execution_log
+try:
+    from ..core.weave_context import CancelToken
+    from ..core.timing import PhaseTimer
+    from ..core.memprofile import MemoryProfiler, measure_memory
+    from ..core.profiler import MODES as PROFILE_MODES, CpuProfiler
+    from ..core.metrics import write_metrics
+except ImportError:
+    from code.core.weave_context import CancelToken
+    from code.core.timing import PhaseTimer
+    from code.core.memprofile import MemoryProfiler, measure_memory
+    from code.core.profiler import MODES as PROFILE_MODES, CpuProfiler
+    from code.core.metrics import write_metrics
 
 # 定义一个模拟的StubProcessor类，在无法导入真实类时使用
 class MockStubProcessor:
@@ -83,6 +95,23 @@ except Exception as e:
     StubProcessor = MockStubProcessor
     found_real_processor = False
 
+class CopyCancelled(Exception):
+    """复制项目目录期间收到取消请求（不继承OSError，shutil.copytree不会将其收集为复制错误）"""
+
+
+def _cancellable_copy(cancel_token):
+    """
+    返回供 ``shutil.copytree`` 使用的复制函数
+
+    每复制一个文件前经过取消标志的检查点：暂停时等待，取消后抛出 :class:`CopyCancelled`。
+    """
+    def copy(src, dst):
+        if not cancel_token.checkpoint():
+            raise CopyCancelled()
+        return shutil.copy2(src, dst)
+    return copy
+
+
 # 添加StubProcessor的兼容适配器类
 class StubProcessorAdapter:
     """
@@ -126,12 +155,17 @@ class StubProcessorAdapter:
         except Exception as e:
             self.logger.error(f"设置YAML文件时出错: {str(e)}")
 
-    def process_directory(self, root_dir):
+    def process_directory(self, root_dir, cancel_token=None, memory=None):
         """
         处理目录 - 兼容接口
         
         如果原始处理器有process_directory方法，直接调用；
         如果没有，但有process_files方法，则进行适配调用。
+        
+        Args:
+            root_dir: 项目根目录
+            cancel_token: 可选的取消与暂停标志，仅原生process_directory支持
+            memory: 可选的内存分析器，仅原生process_directory支持
         """
         try:
             # 详细日志
@@ -149,23 +183,32 @@ class StubProcessorAdapter:
                 # 确保processor具有必要的目录属性
                 self.processor.project_dir = root_dir
                 
-                # 尝试创建备份目录和结果目录
+                # 统计备份、复制与各处理阶段的耗时，写入执行日志
+                timer = PhaseTimer(memory=memory)
+                
+                # 尝试创建备份目录和结果目录；复制期间同样响应取消与暂停
+                copy_function = _cancellable_copy(cancel_token) if cancel_token is not None else shutil.copy2
                 try:
+                    if copy_function is not shutil.copy2 and not cancel_token.checkpoint():
+                        raise CopyCancelled()
                     self.logger.info(f"开始备份整个项目目录: {root_dir} -> {backup_dir}")
-                    shutil.copytree(root_dir, backup_dir)
+                    with timer.phase('backup'):
+                        shutil.copytree(root_dir, backup_dir, copy_function=copy_function)
                     self.logger.info(f"项目目录备份成功: {backup_dir}")
                     
                     self.logger.info(f"创建插桩结果目录: {stubbed_dir}")
-                    shutil.copytree(root_dir, stubbed_dir)
-                    
-                    # 将备份和结果目录设置为处理器属性
-                    self.processor.backup_dir = backup_dir
-                    self.processor.stubbed_dir = stubbed_dir
+                    with timer.phase('copy'):
+                        shutil.copytree(root_dir, stubbed_dir, copy_function=copy_function)
+                except CopyCancelled:
+                    return self._copy_cancelled(root_dir, backup_dir, stubbed_dir, timer)
                 except Exception as backup_error:
                     self.logger.error(f"创建备份或结果目录失败: {str(backup_error)}")
                 
-                # 调用原始方法处理目录
-                result = self.processor.process_directory(root_dir)
+                # 调用原始方法处理目录，备份和结果目录作为本次运行的参数传入
+                run_options = {"backup_dir": backup_dir, "stubbed_dir": stubbed_dir, "timer": timer}
+                if cancel_token is not None:
+                    run_options["cancel_token"] = cancel_token
+                result = self.processor.process_directory(root_dir, **run_options)
                 
                 # 处理完成后，将结果目录信息添加到返回结果中
                 if not hasattr(result, "backup_dir"):
@@ -192,8 +235,8 @@ class StubProcessorAdapter:
                         "successful_stubs": stats.get('inserted_stubs', 0),
                         "errors": [{"file": "统计信息", "error": f"失败文件数: {stats.get('failed_files', 0)}"}] 
                         if stats.get('failed_files', 0) > 0 else [],
-                        "backup_dir": getattr(self.processor, 'backup_dir', backup_dir),
-                        "stubbed_dir": getattr(self.processor, 'stubbed_dir', stubbed_dir)
+                        "backup_dir": stats.get('backup_dir') or getattr(self.processor, 'backup_dir', backup_dir),
+                        "stubbed_dir": stats.get('stubbed_dir') or getattr(self.processor, 'stubbed_dir', stubbed_dir)
                     }
                     
                     return result
@@ -234,8 +277,8 @@ class StubProcessorAdapter:
                                         "successful_stubs": stats.get('inserted_stubs', 0),
                                         "errors": [{"file": "统计信息", "error": f"失败文件数: {stats.get('failed_files', 0)}"}] 
                                         if stats.get('failed_files', 0) > 0 else [],
-                                        "backup_dir": getattr(self.processor, 'backup_dir', backup_dir),
-                                        "stubbed_dir": getattr(self.processor, 'stubbed_dir', stubbed_dir)
+                                        "backup_dir": stats.get('backup_dir') or getattr(self.processor, 'backup_dir', backup_dir),
+                                        "stubbed_dir": stats.get('stubbed_dir') or getattr(self.processor, 'stubbed_dir', stubbed_dir)
                                     }
                                     
                                     return result
@@ -284,9 +327,9 @@ class StubProcessorAdapter:
                 try:
                     from code.core.stub_processor import StubProcessor as CoreStubProcessor
                     core_processor = CoreStubProcessor(root_dir)
-                    core_processor.backup_dir = backup_dir
-                    core_processor.stubbed_dir = stubbed_dir
-                    result = core_processor.process_files()
+                    result = core_processor.process_files(
+                        backup_dir=backup_dir, stubbed_dir=stubbed_dir
+                    )
                     
                     # 转换结果格式
                     if isinstance(result, tuple) and len(result) >= 3:
@@ -321,6 +364,33 @@ class StubProcessorAdapter:
                 "errors": [{"file": "异常", "error": str(e)}]
             }
 
+    def _copy_cancelled(self, root_dir, backup_dir, stubbed_dir, timer):
+        """
+        复制项目目录期间被取消：删除本次只复制了一部分的目录，返回已取消的结果
+
+        此时尚未处理任何文件，原项目未被修改，备份与结果目录均不保留。
+        """
+        self.logger.warning("处理已取消: 复制项目目录期间取消，未处理任何文件")
+        for path in (backup_dir, stubbed_dir):
+            shutil.rmtree(path, ignore_errors=True)
+        if self.ui:
+            self.ui.log("[取消] 复制项目目录期间取消，未处理任何文件", tag="warning")
+        return {
+            "total_files": 0,
+            "processed_files": 0,
+            "updated_files": 0,
+            "successful_stubs": 0,
+            "errors": [],
+            "backup_dir": "",
+            "stubbed_dir": "",
+            "missing_stubs": 0,
+            "missing_anchor_details": [],
+            "files_without_anchors": [],
+            "cancelled": True,
+            "unprocessed_files": [],
+            "timings": timer.to_dict(),
+        }
+    
     def extract_to_yaml(self, root_dir, output_file):
         """兼容导出YAML配置"""
         try:
@@ -344,6 +414,8 @@ class AppController:
     def __init__(self, ui=None):
         # 实例变量初始化 - 首先设置UI属性
         self.ui = ui
+        # 当前运行的取消与暂停标志
+        self.cancel_token = None
         
         # 日志系统初始化
         self.setup_logging()
@@ -383,6 +455,9 @@ class AppController:
             try:
                 self.ui.set_process_callback(self.process_directory)
                 self.ui.set_reverse_callback(self.export_yaml)
+                if hasattr(self.ui, 'set_cancel_callback'):
+                    self.ui.set_cancel_callback(self.cancel_processing)
+                    self.ui.set_pause_callback(self.pause_processing)
                 self.log_info("成功设置处理回调")
             except Exception as e:
                 self.log_error(f"设置UI回调失败: {str(e)}")
@@ -432,6 +507,9 @@ class AppController:
         if self.ui:
             self.ui.update_status("正在处理...")
         
+        # 每次运行使用新的取消标志
+        self.cancel_token = CancelToken()
+        
         # 创建并启动处理线程
         thread = threading.Thread(
             target=self._process_directory_thread,
@@ -440,8 +518,83 @@ class AppController:
         thread.daemon = True
         thread.start()
     
+    def cancel_processing(self):
+        """取消当前运行，已写入结果目录的文件保留"""
+        if self.cancel_token is not None and not self.cancel_token.cancelled:
+            self.cancel_token.cancel()
+            self.log_warning("已请求取消处理，当前文件完成后停止")
+            if self.ui:
+                self.ui.update_status("正在取消...")
+    
+    def pause_processing(self, paused):
+        """
+        暂停或继续当前运行
+        
+        Args:
+            paused: True为暂停，False为继续
+        """
+        if self.cancel_token is None or self.cancel_token.cancelled:
+            return
+        if paused:
+            self.cancel_token.pause()
+            self.log_info("处理已暂停")
+            if self.ui:
+                self.ui.update_status("已暂停")
+        else:
+            self.cancel_token.resume()
+            self.log_info("处理已继续")
+            if self.ui:
+                self.ui.update_status("正在处理...")
+    
+    def _save_execution_log(self, root_dir, result, profiler=None):
+        """将本次运行的统计信息、阶段耗时与内存分析结果写入执行日志，CPU分析结果写在执行日志旁边"""
+        try:
+            save_execution_log(execution_stats(result), root_dir, result.get('backup_dir'), result.get('stubbed_dir'),
+                               timings=result.get('timings'), memory=result.get('memory'), profiler=profiler)
+        except Exception as e:
+            self.logger.warning(f"保存执行日志失败: {str(e)}")
+    
+    def _write_metrics(self, root_dir, result):
+        """配置了 ``logging.metrics_file`` 时将运行统计累加写入Prometheus指标文件"""
+        path = self._app_config().get_metrics_file()
+        if path and not write_metrics(path, result, {"project": os.path.basename(os.path.normpath(root_dir))}):
+            self.log_warning(f"写出运行指标失败: {path}")
+    
+    @staticmethod
+    def _app_config():
+        """返回已加载的应用配置"""
+        try:
+            from ..utils.config import config
+        except ImportError:
+            from code.utils.config import config
+        # 图形界面入口可能经不同的包路径导入配置模块，此处的配置尚未加载时先加载
+        if config._config_file is None:
+            config.load_config()
+        return config
+    
+    def _create_cpu_profiler(self):
+        """配置 ``logging.profile_cpu`` 为 cprofile 或 sample 时创建CPU分析器（未启动），否则返回None"""
+        mode = self._app_config().get_cpu_profile_mode()
+        if not mode:
+            return None
+        if mode not in PROFILE_MODES:
+            self.log_warning(f"未知的CPU分析模式: {mode}（可用: {', '.join(PROFILE_MODES)}），不进行分析")
+            return None
+        self.log_info(f"已开启CPU分析（{mode}），结果写在执行日志旁边")
+        return CpuProfiler(mode)
+    
+    def _create_memory_profiler(self):
+        """配置 ``logging.profile_memory`` 开启时创建并启动内存分析器，否则返回None"""
+        if not self._app_config().is_memory_profiling():
+            return None
+        self.log_info("已开启内存分析，处理速度会明显变慢")
+        memory = MemoryProfiler()
+        memory.start()
+        return memory
+    
     def _process_directory_thread(self, root_dir, yaml_file=None):
         """在独立线程中运行目录处理"""
+        memory = profiler = None
         try:
             self.log_info(f"开始处理目录: {root_dir}")
             
@@ -452,10 +605,17 @@ class AppController:
                     self.ui.update_status("错误: 处理器未初始化")
                 return
             
+            # 配置中开启内存分析或CPU分析时，从加载YAML配置开始跟踪
+            memory = self._create_memory_profiler()
+            profiler = self._create_cpu_profiler()
+            if profiler is not None:
+                profiler.start()
+            
             # 设置YAML文件
             if yaml_file:
                 self.log_info(f"使用YAML配置: {yaml_file}")
-                self.processor.set_yaml_file(yaml_file)
+                with measure_memory(memory, 'yaml'):
+                    self.processor.set_yaml_file(yaml_file)
                 
                 # 如果处理器有内部处理器（适配器情况），确保内部处理器也设置了yaml_file
                 if hasattr(self.processor, 'processor') and hasattr(self.processor.processor, 'yaml_file'):
@@ -476,7 +636,18 @@ class AppController:
             
             # 处理目录
             try:
-                result = self.processor.process_directory(root_dir)
+                run_options = {"cancel_token": self.cancel_token}
+                if memory is not None:
+                    run_options["memory"] = memory
+                try:
+                    result = self.processor.process_directory(root_dir, **run_options)
+                finally:
+                    if memory is not None:
+                        memory.stop()
+                    if profiler is not None:
+                        profiler.stop()
+                if memory is not None:
+                    result["memory"] = memory.to_dict()
                 
                 # 处理结果
                 self.log_info(f"文件总数: {result.get('total_files', 0)}")
@@ -514,9 +685,17 @@ class AppController:
                     for error in errors:
                         self.log_error(f"  - {error.get('file')}: {error.get('error')}")
                 
+                self._save_execution_log(root_dir, result, profiler)
+                self._write_metrics(root_dir, result)
+                
                 # 更新状态
                 if self.ui:
-                    self.ui.update_status(f"完成. 处理了 {result.get('processed_files', 0)} 个文件")
+                    if result.get('cancelled'):
+                        self.ui.update_status(
+                            f"已取消. 处理了 {result.get('processed_files', 0)} 个文件, "
+                            f"未处理 {len(result.get('unprocessed_files', []))} 个文件")
+                    else:
+                        self.ui.update_status(f"完成. 处理了 {result.get('processed_files', 0)} 个文件")
             except AttributeError as attr_err:
                 # 特殊处理AttributeError，可能是'process_files'方法不存在
                 error_msg = f"处理器方法调用失败: {str(attr_err)}"
@@ -580,6 +759,12 @@ class AppController:
             # 更新状态
             if self.ui:
                 self.ui.update_status("处理时出错")
+        finally:
+            # 出错时也停止分析，避免分析钩子留在后续创建的线程中
+            if memory is not None:
+                memory.stop()
+            if profiler is not None:
+                profiler.stop()
 
     def export_yaml(self, root_dir, output_file):
         """反向生成YAML配置文件"""
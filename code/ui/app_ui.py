@@ -6,15 +6,42 @@ YAMLWeave UI 模块 - 提供图形界面和日志显示功能
 
 import os
 import sys
+import queue
+import threading
 import tkinter as tk
-from tkinter import ttk, filedialog, messagebox, scrolledtext
+from tkinter import ttk, filedialog, messagebox
 from .rounded_progressbar import RoundedProgressBar
+from .log_model import LogModel
+from .log_view import VirtualLogView
 import datetime
 import re
 from typing import Callable, Dict, List, Optional, Any, Tuple
 
+# 日志队列刷新间隔（毫秒），约30次/秒
+LOG_FLUSH_INTERVAL_MS = 33
+# 单次刷新最多写入的日志条数，避免一次性积压阻塞界面
+LOG_FLUSH_MAX_ENTRIES = 2000
+# 进度采样间隔（毫秒）
+PROGRESS_SAMPLE_INTERVAL_MS = 200
+
+# 日志筛选选项：显示名称 -> 标签
+LOG_FILTERS = {
+    "全部": None,
+    "缺失": "missing",
+    "警告": "warning",
+    "插桩": "insert",
+    "文件": "file",
+}
+
+
 class YAMLWeaveUI:
-    """YAMLWeave工具的图形用户界面"""
+    """
+    YAMLWeave工具的图形用户界面
+
+    ``log``、``log_batch``、``update_status`` 与 ``update_progress`` 可以在任意
+    线程中调用：消息先进入线程安全队列，由Tk主循环定时批量取出并刷新界面，
+    工作线程不会直接调用任何Tk接口。
+    """
     
     def __init__(self, root):
         """
@@ -56,6 +83,21 @@ class YAMLWeaveUI:
         # 回调函数
         self.process_callback = None
         self.reverse_callback = None
+        self.cancel_callback = None
+        self.pause_callback = None
+        self._paused = False
+        
+        # 跨线程UI消息队列，仅由Tk主线程消费
+        self._ui_queue = queue.SimpleQueue()
+        self._ui_thread = threading.get_ident()
+        
+        # 日志记录保存在磁盘文件中，窗口只渲染可见行
+        self.log_model = LogModel()
+        self.log_filter = tk.StringVar(value="全部")
+        
+        # 当前运行的进度计数器，由界面定时采样
+        self._progress_tracker = None
+        self.rate_text = tk.StringVar(value="")
         
         # 创建UI组件
         self._create_widgets()
@@ -67,6 +109,10 @@ class YAMLWeaveUI:
         # 结束初始化日志
         self.log("[初始化] YAMLWeave界面初始化完成", tag="info")
         self.log("[提示] 请设置项目目录和YAML配置文件，然后点击\"扫描并插入\"", tag="info")
+        
+        # 启动UI消息队列的定时刷新与进度采样
+        self.root.after(LOG_FLUSH_INTERVAL_MS, self._drain_ui_queue)
+        self.root.after(PROGRESS_SAMPLE_INTERVAL_MS, self._sample_progress)
     
     def _create_widgets(self):
         """创建UI组件"""
@@ -104,6 +150,9 @@ class YAMLWeaveUI:
         button_frame.grid(row=2, column=0, columnspan=3, pady=10)
         
         ttk.Button(button_frame, text="扫描并插入", command=self._process).pack(side=tk.LEFT, padx=5)
+        self.pause_button = ttk.Button(button_frame, text="暂停", command=self._toggle_pause)
+        self.pause_button.pack(side=tk.LEFT, padx=5)
+        ttk.Button(button_frame, text="取消", command=self._cancel).pack(side=tk.LEFT, padx=5)
         ttk.Button(button_frame, text="清除日志", command=self._clear_log).pack(side=tk.LEFT, padx=5)
         ttk.Button(button_frame, text="导出日志", command=self._export_log).pack(side=tk.LEFT, padx=5)
         ttk.Button(button_frame, text="反向生成YAML", command=self._reverse_extract).pack(side=tk.LEFT, padx=5)
@@ -113,9 +162,18 @@ class YAMLWeaveUI:
         log_frame = ttk.LabelFrame(main_frame, text="执行日志", padding="5")
         log_frame.pack(fill=tk.BOTH, expand=True, padx=5, pady=5)
         
-        # 使用Text控件并设置滚动条
-        self.log_text = scrolledtext.ScrolledText(
-            log_frame, wrap=tk.WORD, height=20, font=("Consolas", 10)
+        # 日志筛选
+        filter_frame = ttk.Frame(log_frame)
+        filter_frame.pack(fill=tk.X, padx=5)
+        ttk.Label(filter_frame, text="筛选:").pack(side=tk.LEFT)
+        filter_box = ttk.Combobox(filter_frame, textvariable=self.log_filter, values=list(LOG_FILTERS),
+                                  state="readonly", width=8)
+        filter_box.pack(side=tk.LEFT, padx=5)
+        filter_box.bind("<<ComboboxSelected>>", self._on_filter_changed)
+        
+        # 虚拟化日志视图，仅渲染可见行
+        self.log_text = VirtualLogView(
+            log_frame, self.log_model, height=20, wrap=tk.WORD, font=("Consolas", 10)
         )
         self.log_text.pack(fill=tk.BOTH, expand=True, padx=5, pady=5)
         
@@ -138,6 +196,8 @@ class YAMLWeaveUI:
             radius=5,
         )
         self.progress_bar.pack(side=tk.LEFT, padx=5, pady=5)
+        # 处理速率与剩余时间
+        ttk.Label(status_frame, textvariable=self.rate_text).pack(side=tk.LEFT, padx=5)
         
         # 设置列权重以允许自动调整大小
         input_frame.columnconfigure(1, weight=1)
@@ -182,6 +242,10 @@ class YAMLWeaveUI:
         # 统计和分隔线
         self.log_text.tag_configure("separator", foreground="#999999")
     
+    def _on_filter_changed(self, _event=None):
+        """切换日志筛选标签"""
+        self.log_text.set_filter(LOG_FILTERS.get(self.log_filter.get()))
+    
     def _browse_project_dir(self):
         """浏览并选择项目目录"""
         directory = filedialog.askdirectory()
@@ -217,6 +281,9 @@ class YAMLWeaveUI:
         # 更新状态
         self.update_status("开始处理...")
         self.progress.set(0)
+        self._paused = False
+        self.pause_button.configure(text="暂停")
+        self.rate_text.set("")
         
         # 清除日志
         self._clear_log()
@@ -237,9 +304,26 @@ class YAMLWeaveUI:
             self.log("[错误] 未设置处理回调函数", tag="error")
             self.update_status("处理失败")
     
+    def _toggle_pause(self):
+        """暂停或继续当前处理"""
+        if not self.pause_callback:
+            return
+        self._paused = not self._paused
+        self.pause_button.configure(text="继续" if self._paused else "暂停")
+        self.pause_callback(self._paused)
+    
+    def _cancel(self):
+        """取消当前处理"""
+        if self.cancel_callback:
+            self._paused = False
+            self.pause_button.configure(text="暂停")
+            self.cancel_callback()
+    
     def _clear_log(self):
         """清除日志文本"""
-        self.log_text.delete(1.0, tk.END)
+        self._flush_ui_queue()
+        self.log_model.clear()
+        self.log_text.refresh()
         self.processed_lines = 0
         self.log("[信息] 日志已清除", tag="info")
     
@@ -253,8 +337,8 @@ class YAMLWeaveUI:
         
         if file_path:
             try:
-                with open(file_path, 'w', encoding='utf-8') as f:
-                    f.write(self.log_text.get(1.0, tk.END))
+                self._flush_ui_queue()
+                self.log_model.export(file_path)
                 self.log(f"[信息] 日志已导出到: {file_path}", tag="success")
             except Exception as e:
                 messagebox.showerror("导出错误", f"导出日志时出错: {str(e)}")
@@ -309,13 +393,27 @@ class YAMLWeaveUI:
         """设置反向导出回调函数"""
         self.reverse_callback = callback
     
+    def set_cancel_callback(self, callback):
+        """设置取消处理回调函数"""
+        self.cancel_callback = callback
+    
+    def set_pause_callback(self, callback):
+        """设置暂停/继续回调函数，参数为是否暂停"""
+        self.pause_callback = callback
+    
     def update_status(self, status_text):
         """更新状态栏文本"""
+        if threading.get_ident() != self._ui_thread:
+            self._ui_queue.put(("status", status_text))
+            return
         self.status.set(status_text)
-        self.root.update_idletasks()
     
     def update_progress(self, value, status_text=None, current=None, total=None):
         """更新进度条和状态栏"""
+        if threading.get_ident() != self._ui_thread:
+            self._ui_queue.put(("progress", (value, status_text, current, total)))
+            return
+        
         self.progress.set(value)
         if hasattr(self, "progress_bar") and hasattr(self.progress_bar, "set"):
             self.progress_bar.set(value)
@@ -327,32 +425,59 @@ class YAMLWeaveUI:
             percentage = f"{value}%" if value <= 100 else "100%"
             progress_text = f"{current}/{total} ({percentage})"
             self.update_status(progress_text)
+    
+    def track_progress(self, tracker):
+        """
+        设置需要定时采样的进度计数器（可在任意线程中调用）
         
-        self.root.update_idletasks()
+        Args:
+            tracker: :class:`ProgressTracker` 实例
+        """
+        self._progress_tracker = tracker
+    
+    def _sample_progress(self):
+        """定时任务：采样进度计数器，更新进度条与速率显示"""
+        try:
+            tracker = self._progress_tracker
+            if tracker is not None:
+                snapshot = tracker.snapshot()
+                self.progress.set(snapshot.percentage)
+                self.progress_bar.set(snapshot.percentage)
+                self.rate_text.set(snapshot.describe())
+                if snapshot.finished:
+                    self._progress_tracker = None
+        finally:
+            self.root.after(PROGRESS_SAMPLE_INTERVAL_MS, self._sample_progress)
     
     def log(self, message, tag="info"):
         """添加日志消息到日志区域
         
+        可在任意线程中调用，消息在下一次定时刷新时写入日志区域。
+        
         Args:
             message: 日志消息
             tag: 用于设置文本样式的标签
         """
-        # 直接打印日志信息，便于调试
-        print(f"UI日志输出: [{tag}] {message}")
+        self._ui_queue.put(("log", self._format_log_entry(message, tag)))
+    
+    def log_batch(self, entries):
+        """批量添加日志消息
         
+        Args:
+            entries: ``(消息, 标签)`` 元组序列
+        """
+        format_entry = self._format_log_entry
+        self._ui_queue.put(("logs", [format_entry(message, tag) for message, tag in entries]))
+    
+    @staticmethod
+    def _format_log_entry(message, tag):
+        """生成一条日志记录 ``(文本, 标签)``"""
         # 获取当前时间
         timestamp = datetime.datetime.now().strftime("[%H:%M:%S] ")
         
-        # 特殊处理锚点消息
+        # 特殊处理锚点消息，强制使用特定格式高亮显示（时间戳由视图单独着色）
         if "[锚点]" in message:
-            print(f"锚点信息: {message}")
-            # 强制使用特定格式高亮显示
-            self.log_text.insert(tk.END, timestamp, "info")
-            self.log_text.insert(tk.END, message + "\n", "find")
-            self.log_text.see(tk.END)
-            self.log_text.update_idletasks()
-            self.processed_lines += 1
-            return
+            return (timestamp + message + "\n", "find")
 
         # 根据消息内容自动选择标签
         if tag == "info":
@@ -365,21 +490,55 @@ class YAMLWeaveUI:
             elif "[统计]" in message:
                 tag = "stats"
         
-        # 常规日志条目
-        self.log_text.insert(tk.END, timestamp + message + "\n", tag)
-        
-        # 自动滚动到最新消息
-        self.log_text.see(tk.END)
-        
-        # 强制更新UI
-        self.root.update_idletasks()
+        return (timestamp + message + "\n", tag)
+    
+    def _drain_ui_queue(self):
+        """定时任务：批量处理UI消息队列，并安排下一次刷新"""
+        try:
+            self._flush_ui_queue(LOG_FLUSH_MAX_ENTRIES)
+        finally:
+            self.root.after(LOG_FLUSH_INTERVAL_MS, self._drain_ui_queue)
+    
+    def _flush_ui_queue(self, max_entries=None):
+        """
+        在Tk主线程中取出队列中的消息并刷新界面
         
-        # 增加处理行数计数
-        self.processed_lines += 1
+        日志记录批量追加到日志模型，视图每批只重绘一次；状态与进度只应用最后一次的值。
+        """
+        records = []
+        count = 0
+        status = None
+        progress = None
+        while max_entries is None or count < max_entries:
+            try:
+                kind, payload = self._ui_queue.get_nowait()
+            except queue.Empty:
+                break
+            if kind == "log":
+                records.append(payload)
+                count += 1
+            elif kind == "logs":
+                records.extend(payload)
+                count += len(payload)
+            elif kind == "status":
+                status = payload
+            elif kind == "progress":
+                # 进度更新自带状态文本，此前的状态不再需要
+                progress, status = payload, None
+        
+        if records:
+            self.log_model.extend(records)
+            self.log_text.refresh()
+            self.processed_lines += count
+        if progress is not None:
+            self.update_progress(*progress)
+        if status is not None:
+            self.update_status(status)
     
     def get_log_content(self):
-        """获取日志内容"""
-        return self.log_text.get(1.0, tk.END)
+        """获取日志内容（大日志请使用 ``log_model.export`` 流式导出）"""
+        self._flush_ui_queue()
+        return self.log_model.read_all()
 
 def main():
     """创建并启动独立UI测试"""
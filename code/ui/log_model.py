@@ -0,0 +1,204 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave UI 模块 - log_model
+日志窗口的数据模型
+
+所有日志记录追加写入磁盘上的临时文件，内存中只保留：
+- 每条记录在文件中的起始偏移（``array('q')``，每条8字节）
+- 每条记录的标签编号（``array('B')``，每条1字节）
+- 按标签建立的记录索引，用于快速筛选
+- 最近若干条记录的环形缓存，日志窗口跟随末尾时无需读盘
+
+百万行级别的日志只占用十几MB内存，导出时直接流式复制日志文件。
+"""
+
+import os
+import shutil
+import tempfile
+import weakref
+from array import array
+from collections import deque
+from typing import Dict, List, Optional, Tuple
+
+# 内存中保留的最近记录条数
+DEFAULT_RING_SIZE = 5000
+
+
+def _cleanup(handle, path):
+    """关闭并删除日志文件（模型被回收或显式关闭时调用）"""
+    try:
+        handle.close()
+    except Exception:
+        pass
+    try:
+        os.remove(path)
+    except OSError:
+        pass
+
+
+class LogModel:
+    """
+    追加写入的日志模型
+
+    仅由Tk主线程访问，不做加锁。记录以 ``(文本, 标签)`` 表示，
+    文本以换行结尾，可以包含多行（例如异常堆栈）。
+    """
+
+    def __init__(self, path: Optional[str] = None, ring_size: int = DEFAULT_RING_SIZE):
+        """
+        初始化日志模型
+
+        Args:
+            path: 日志文件路径，为空时在系统临时目录中创建，关闭时删除
+            ring_size: 内存环形缓存的记录条数
+        """
+        if path is None:
+            fd, path = tempfile.mkstemp(prefix="yamlweave_ui_", suffix=".log")
+            os.close(fd)
+        self.path = path
+        self._file = open(path, "w+b")
+        self._finalizer = weakref.finalize(self, _cleanup, self._file, path)
+        self._offsets = array('q')
+        self._tag_ids = array('B')
+        self._tags: List[str] = []
+        self._tag_lookup: Dict[str, int] = {}
+        self._tag_index: Dict[str, array] = {}
+        self._ring_size = ring_size
+        self._ring: deque = deque(maxlen=ring_size)
+        self._size = 0
+
+    def __len__(self) -> int:
+        return len(self._offsets)
+
+    def _tag_id(self, tag: str) -> int:
+        """返回标签编号，新标签自动登记"""
+        tag_id = self._tag_lookup.get(tag)
+        if tag_id is None:
+            tag_id = len(self._tags)
+            self._tags.append(tag)
+            self._tag_lookup[tag] = tag_id
+            self._tag_index[tag] = array('I')
+        return tag_id
+
+    def extend(self, records) -> int:
+        """
+        批量追加记录
+
+        Args:
+            records: ``(文本, 标签)`` 序列
+
+        Returns:
+            int: 追加的记录数
+        """
+        chunks = []
+        count = 0
+        offsets = self._offsets
+        for text, tag in records:
+            data = text.encode("utf-8")
+            index = len(offsets)
+            offsets.append(self._size)
+            self._tag_ids.append(self._tag_id(tag))
+            self._tag_index[tag].append(index)
+            self._ring.append((text, tag))
+            self._size += len(data)
+            chunks.append(data)
+            count += 1
+        if chunks:
+            self._file.seek(0, os.SEEK_END)
+            self._file.write(b"".join(chunks))
+        return count
+
+    def append(self, text: str, tag: str = "info") -> None:
+        """追加单条记录"""
+        self.extend(((text, tag),))
+
+    def count(self, tag: Optional[str] = None) -> int:
+        """记录总数，或指定标签的记录数"""
+        if tag is None:
+            return len(self._offsets)
+        index = self._tag_index.get(tag)
+        return len(index) if index is not None else 0
+
+    def tags(self) -> List[str]:
+        """已出现过的标签列表"""
+        return list(self._tags)
+
+    def record_index(self, row: int, tag: Optional[str] = None) -> int:
+        """将（筛选后的）行号转换为记录编号"""
+        if tag is None:
+            return row
+        return self._tag_index[tag][row]
+
+    def get(self, index: int) -> Tuple[str, str]:
+        """读取单条记录"""
+        return self.records([index])[0]
+
+    def rows(self, start: int, count: int, tag: Optional[str] = None) -> List[Tuple[str, str]]:
+        """
+        读取一段连续行
+
+        Args:
+            start: 起始行号（按 ``tag`` 筛选后的行号）
+            count: 最多读取的行数
+            tag: 筛选标签，为空时不筛选
+
+        Returns:
+            List[Tuple[str, str]]: ``(文本, 标签)`` 列表
+        """
+        total = self.count(tag)
+        start = max(0, min(start, total))
+        end = min(total, start + max(0, count))
+        if tag is None:
+            indexes = range(start, end)
+        else:
+            indexes = self._tag_index.get(tag, array('I'))[start:end]
+        return self.records(indexes)
+
+    def records(self, indexes) -> List[Tuple[str, str]]:
+        """按记录编号读取记录，环形缓存命中时不读盘"""
+        total = len(self._offsets)
+        ring_start = total - len(self._ring)
+        result = []
+        read_from_disk = False
+        for index in indexes:
+            if index >= ring_start:
+                result.append(self._ring[index - ring_start])
+                continue
+            if not read_from_disk:
+                self._file.flush()
+                read_from_disk = True
+            begin = self._offsets[index]
+            end = self._offsets[index + 1] if index + 1 < total else self._size
+            self._file.seek(begin)
+            text = self._file.read(end - begin).decode("utf-8", errors="replace")
+            result.append((text, self._tags[self._tag_ids[index]]))
+        return result
+
+    def export(self, target_path: str) -> None:
+        """将全部日志流式复制到目标文件"""
+        self._file.flush()
+        self._file.seek(0)
+        with open(target_path, "wb") as target:
+            shutil.copyfileobj(self._file, target)
+
+    def read_all(self) -> str:
+        """读取全部日志文本（仅用于兼容 ``get_log_content``，大日志请使用 :meth:`export`）"""
+        self._file.flush()
+        self._file.seek(0)
+        return self._file.read().decode("utf-8", errors="replace")
+
+    def clear(self) -> None:
+        """清空全部记录"""
+        self._file.seek(0)
+        self._file.truncate()
+        self._offsets = array('q')
+        self._tag_ids = array('B')
+        for index in self._tag_index.values():
+            del index[:]
+        self._ring.clear()
+        self._size = 0
+
+    def close(self) -> None:
+        """关闭并删除日志文件"""
+        self._finalizer()
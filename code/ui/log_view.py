@@ -0,0 +1,120 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+"""
+YAMLWeave UI 模块 - log_view
+虚拟化的日志视图
+
+视图只把当前可见的若干条记录写入Text控件，滚动条位置按记录编号计算，
+数据全部来自 :class:`LogModel`。无论日志有多少行，控件中的文本量都保持不变。
+"""
+
+import tkinter as tk
+from tkinter import ttk
+from typing import Optional
+
+try:
+    from .log_model import LogModel
+except ImportError:
+    from ui.log_model import LogModel
+
+
+class VirtualLogView(ttk.Frame):
+    """
+    只渲染可见行的日志视图
+
+    默认跟随日志末尾；用户向上滚动后停止跟随，滚动回底部时恢复。
+    """
+
+    def __init__(self, master, model: LogModel, height: int = 20, **text_options):
+        super().__init__(master)
+        self.model = model
+        self._filter: Optional[str] = None
+        self._first = 0
+        self._follow = True
+        self._height = height
+
+        self.text = tk.Text(self, height=height, **text_options)
+        self.scrollbar = ttk.Scrollbar(self, orient=tk.VERTICAL, command=self._on_scrollbar)
+        self.scrollbar.pack(side=tk.RIGHT, fill=tk.Y)
+        self.text.pack(side=tk.LEFT, fill=tk.BOTH, expand=True)
+        self.text.configure(state=tk.DISABLED)
+
+        self.text.bind("<Configure>", lambda _event: self.refresh())
+        self.text.bind("<MouseWheel>", self._on_mousewheel)
+        self.text.bind("<Button-4>", lambda _event: self._scroll_by(-3))
+        self.text.bind("<Button-5>", lambda _event: self._scroll_by(3))
+
+    def tag_configure(self, tag, **options):
+        """配置标签样式（转发给内部Text控件）"""
+        return self.text.tag_configure(tag, **options)
+
+    def set_filter(self, tag: Optional[str]) -> None:
+        """按标签筛选日志，``None`` 表示显示全部"""
+        self._filter = tag
+        self._follow = True
+        self.refresh()
+
+    def _total(self) -> int:
+        return self.model.count(self._filter)
+
+    def _visible_rows(self) -> int:
+        """根据控件高度估算可见行数"""
+        height = self.text.winfo_height()
+        if height <= 1:
+            return self._height
+        line_height = self.text.tk.call("font", "metrics", self.text.cget("font"), "-linespace")
+        return max(1, int(height) // max(1, int(line_height)))
+
+    def refresh(self) -> None:
+        """重新渲染可见区域"""
+        rows = self._visible_rows()
+        total = self._total()
+        if self._follow:
+            self._first = max(0, total - rows)
+        self._first = max(0, min(self._first, max(0, total - rows)))
+
+        chunks = []
+        for text, tag in self.model.rows(self._first, rows, self._filter):
+            if tag == "find":
+                # 锚点记录的时间戳使用普通样式
+                split = text.find("] ") + 2
+                chunks.extend((text[:split], "info", text[split:], tag))
+            else:
+                chunks.extend((text, tag))
+
+        self.text.configure(state=tk.NORMAL)
+        self.text.delete("1.0", tk.END)
+        if chunks:
+            self.text.insert(tk.END, *chunks)
+        self.text.configure(state=tk.DISABLED)
+
+        if total:
+            self.scrollbar.set(self._first / total, min(1.0, (self._first + rows) / total))
+        else:
+            self.scrollbar.set(0.0, 1.0)
+
+    def _scroll_to(self, first: int) -> None:
+        rows = self._visible_rows()
+        total = self._total()
+        self._first = max(0, min(first, max(0, total - rows)))
+        self._follow = self._first + rows >= total
+        self.refresh()
+
+    def _scroll_by(self, delta: int) -> str:
+        self._scroll_to(self._first + delta)
+        return "break"
+
+    def _on_scrollbar(self, action, *args) -> None:
+        """滚动条回调：``moveto fraction`` 或 ``scroll n units|pages``"""
+        if action == "moveto":
+            self._scroll_to(int(float(args[0]) * self._total()))
+        elif action == "scroll":
+            step = int(args[0])
+            if args[1] == "pages":
+                step *= max(1, self._visible_rows() - 1)
+            self._scroll_by(step)
+
+    def _on_mousewheel(self, event) -> str:
+        # Windows下每格为120，macOS下为1
+        delta = event.delta // 120 if abs(event.delta) >= 120 else event.delta
+        return self._scroll_by(-3 * delta)
@@ -165,7 +165,11 @@ DEFAULT_CONFIG = {
     'logging': {
         'level': 'info',
         'console': True,
-        'file': True
+        'file': True,
+        'performance': False,  # 性能日志模式：经队列由后台线程格式化并批量输出
+        'profile_memory': False,  # 按阶段分析内存占用并写入执行日志（tracemalloc，处理明显变慢）
+        'profile_cpu': '',  # CPU分析：cprofile 或 sample，结果写在执行日志旁边；空表示不分析
+        'metrics_file': ''  # 运行统计累加写入的Prometheus .prom 文件（textfile收集器目录）；空表示不写出
     },
     # UI相关配置
     'ui': {
@@ -305,6 +309,22 @@ class Config:
         """获取线程池最大工作线程数"""
         return self.get('handlers.max_workers', 4)
     
+    def is_performance_logging(self) -> bool:
+        """是否启用性能日志模式"""
+        return bool(self.get('logging.performance', False))
+    
+    def is_memory_profiling(self) -> bool:
+        """是否按阶段分析内存占用"""
+        return bool(self.get('logging.profile_memory', False))
+    
+    def get_cpu_profile_mode(self) -> str:
+        """CPU分析模式（cprofile / sample），空字符串表示不分析"""
+        return str(self.get('logging.profile_cpu', '') or '')
+    
+    def get_metrics_file(self) -> str:
+        """Prometheus指标文件路径，空字符串表示不写出"""
+        return str(self.get('logging.metrics_file', '') or '')
+    
     def get_default_indent(self) -> str:
         """获取默认缩进"""
         return self.get('handlers.default_indent', '    ')
@@ -6,7 +6,11 @@
 import logging
 import os
 import sys
+import queue
+import threading
+import atexit
 from datetime import datetime
+from logging.handlers import QueueHandler, QueueListener
 import glob
 
 
@@ -29,10 +33,10 @@ LOG_LEVELS = {
 # 日志格式
 DEFAULT_LOG_FORMAT = '%(asctime)s - %(name)s - %(levelname)s - %(message)s'
 
-# 统一生成时间戳日志目录和文件
+# 统一生成时间戳日志目录和文件；目录在首次写日志文件时才创建，
+# 仅导入模块（如命令行模式）不会产生空的日志目录
 TIMESTAMP = datetime.now().strftime('%Y%m%d_%H%M%S')
 LOGS_DIR = os.path.join(get_app_root(), f"logs_{TIMESTAMP}")
-os.makedirs(LOGS_DIR, exist_ok=True)
 LOG_FILE = os.path.join(LOGS_DIR, "yamlweave.log")
 
 class UILogHandler(logging.Handler):
@@ -42,41 +46,198 @@ class UILogHandler(logging.Handler):
         super().__init__()
         self.ui = ui
 
+    @staticmethod
+    def _to_entry(record):
+        """将日志记录转换为 (消息, tag) 形式的UI日志条目"""
+        msg = record.getMessage()
+        if record.levelno >= logging.ERROR:
+            tag = "error"
+        elif record.levelno >= logging.WARNING:
+            tag = "warning"
+        else:
+            tag = "info"
+
+        # 根据内容自动调整tag以便在UI中分色显示
+        if "锚点" in msg or "anchor" in msg.lower():
+            tag = "find"
+        elif "用例" in msg:
+            tag = "case"
+        return f"[{record.levelname}] {msg}", tag
+
     def emit(self, record):
         if not self.ui:
             return
         try:
-            msg = record.getMessage()
-            if record.levelno >= logging.ERROR:
-                tag = "error"
-            elif record.levelno >= logging.WARNING:
-                tag = "warning"
-            else:
-                tag = "info"
+            msg, tag = self._to_entry(record)
+            self.ui.log(msg, tag=tag)
+        except Exception:
+            pass
 
-            # 根据内容自动调整tag以便在UI中分色显示
-            lower_msg = msg.lower()
-            if "锚点" in msg or "anchor" in lower_msg:
-                tag = "find"
-            elif "用例" in msg:
-                tag = "case"
+    def handle_batch(self, records):
+        """
+        批量输出日志记录
 
-            self.ui.log(f"[{record.levelname}] {msg}", tag=tag)
+        UI提供 ``log_batch`` 时整批交付，一次刷新界面；否则逐条调用 ``log``。
+        """
+        if not self.ui:
+            return
+        try:
+            entries = [self._to_entry(r) for r in records if self.filter(r)]
+            if not entries:
+                return
+            log_batch = getattr(self.ui, "log_batch", None)
+            if log_batch:
+                log_batch(entries)
+            else:
+                for msg, tag in entries:
+                    self.ui.log(msg, tag=tag)
         except Exception:
             pass
 
+
+class DeferredQueueHandler(QueueHandler):
+    """
+    只将原始日志记录放入队列的处理器
+
+    标准 ``QueueHandler.prepare`` 会在调用线程中格式化消息；这里推迟到
+    监听线程，使处理文件的线程只承担一次入队的开销。
+    """
+
+    def prepare(self, record):
+        return record
+
+
+class BatchingQueueListener(QueueListener):
+    """
+    批量消费日志队列的监听器
+
+    每次唤醒时取出队列中已有的全部记录，支持 ``handle_batch`` 的处理器
+    整批接收，其余处理器逐条处理。
+    """
+
+    max_batch = 500
+
+    def _monitor(self):
+        q = self.queue
+        has_task_done = hasattr(q, 'task_done')
+        stop = False
+        while not stop:
+            try:
+                batch = [self.dequeue(True)]
+                while len(batch) < self.max_batch:
+                    try:
+                        batch.append(self.dequeue(False))
+                    except queue.Empty:
+                        break
+            except queue.Empty:
+                break
+            records = []
+            for record in batch:
+                if record is self._sentinel:
+                    stop = True
+                else:
+                    records.append(record)
+                if has_task_done:
+                    q.task_done()
+            if records:
+                self.handle_batch(records)
+
+    def handle_batch(self, records):
+        """将一批记录分发给各处理器"""
+        for handler in self.handlers:
+            if self.respect_handler_level:
+                accepted = [r for r in records if r.levelno >= handler.level]
+            else:
+                accepted = records
+            if not accepted:
+                continue
+            batch_handler = getattr(handler, 'handle_batch', None)
+            if batch_handler:
+                batch_handler(accepted)
+            else:
+                for record in accepted:
+                    handler.handle(record)
+
+
+def _active_listener():
+    """
+    返回当前生效的队列监听器
+
+    监听器挂在根日志器的入队处理器上而非模块全局变量中，本模块以
+    ``utils.logger`` 和 ``code.utils.logger`` 两种名称被导入时也能找到。
+    """
+    for handler in logging.getLogger().handlers:
+        listener = getattr(handler, 'listener', None)
+        if isinstance(handler, QueueHandler) and listener is not None:
+            return handler, listener
+    return None, None
+
+
+def enable_performance_logging():
+    """
+    启用性能日志模式
+
+    根日志器上原有的处理器移交给后台监听线程，根日志器只保留一个
+    入队处理器；格式化、写文件与UI输出均在监听线程中批量完成。
+
+    Returns:
+        BatchingQueueListener: 日志监听器
+    """
+    _, listener = _active_listener()
+    if listener is not None:
+        return listener
+
+    root_logger = logging.getLogger()
+    handlers = root_logger.handlers[:]
+    for handler in handlers:
+        root_logger.removeHandler(handler)
+
+    log_queue = queue.SimpleQueue()
+    queue_handler = DeferredQueueHandler(log_queue)
+    listener = BatchingQueueListener(log_queue, *handlers, respect_handler_level=True)
+    queue_handler.listener = listener
+    root_logger.addHandler(queue_handler)
+    listener.start()
+    atexit.register(disable_performance_logging)
+    return listener
+
+
+def disable_performance_logging():
+    """停止性能日志模式，输出剩余日志并将处理器还给根日志器"""
+    queue_handler, listener = _active_listener()
+    if listener is None:
+        return
+    root_logger = logging.getLogger()
+    root_logger.removeHandler(queue_handler)
+    queue_handler.listener = None
+    listener.stop()
+    for handler in listener.handlers:
+        root_logger.addHandler(handler)
+
+
+def is_performance_logging():
+    """是否处于性能日志模式"""
+    return _active_listener()[1] is not None
+
+
 def add_ui_handler(ui, level=logging.INFO):
-    """向根日志器添加UI日志处理器"""
+    """向根日志器添加UI日志处理器，性能日志模式下交给队列监听线程"""
     handler = UILogHandler(ui)
     handler.setLevel(level)
-    logging.getLogger().addHandler(handler)
+    _, listener = _active_listener()
+    if listener is not None:
+        listener.handlers = listener.handlers + (handler,)
+    else:
+        logging.getLogger().addHandler(handler)
     return handler
 
-def setup_global_logger(level=logging.INFO):
+def setup_global_logger(level=logging.INFO, performance=False):
     # 清除旧的handler
+    disable_performance_logging()
     for handler in logging.root.handlers[:]:
         logging.root.removeHandler(handler)
     # 文件handler
+    os.makedirs(LOGS_DIR, exist_ok=True)
     file_handler = logging.FileHandler(LOG_FILE, encoding='utf-8')
     file_handler.setFormatter(logging.Formatter('%(asctime)s - %(name)s - %(levelname)s - %(message)s'))
     logging.root.addHandler(file_handler)
@@ -85,6 +246,9 @@ def setup_global_logger(level=logging.INFO):
     console_handler = logging.StreamHandler()
     console_handler.setFormatter(logging.Formatter('%(levelname)s: %(message)s'))
     logging.root.addHandler(console_handler)
+    # 性能日志模式
+    if performance:
+        enable_performance_logging()
 
 def setup_logging(level='info', log_file=None, console=True):
     """
@@ -219,15 +383,32 @@ def setup_file_logger():
     
     return log_file
 
-def save_execution_log(stats, project_dir, backup_dir=None, stubbed_dir=None):
+def execution_stats(result):
+    """由 ``process_directory`` 的结果生成执行日志中的统计信息"""
+    return {
+        "scanned_files": result.get('total_files', 0),
+        "updated_files": result.get('processed_files', 0),
+        "inserted_stubs": result.get('successful_stubs', 0),
+        "failed_files": len(result.get('errors', [])),
+        "missing_stubs": result.get('missing_stubs', 0),
+    }
+
+def save_execution_log(stats, project_dir, backup_dir=None, stubbed_dir=None, timings=None, memory=None,
+                       profiler=None):
     """
-    保存执行日志到固定目录
+    保存执行日志到本次会话的日志目录
     
     Args:
         stats: 统计信息字典
         project_dir: 项目目录
         backup_dir: 备份目录
         stubbed_dir: 插桩结果目录
+        timings: 可选的阶段耗时（``PhaseTimer.to_dict()`` 的结果），
+            写入JSON数据并在文本部分列出各阶段总耗时
+        memory: 可选的内存分析结果（``MemoryProfiler.to_dict()`` 的结果），
+            写入JSON数据并在文本部分列出各阶段的峰值、留存与主要分配位置
+        profiler: 可选的已停止的 ``CpuProfiler``，其 ``.pstats`` 与 ``.collapsed`` 文件
+            写在执行日志旁边（与执行日志同名），文件路径记入执行日志
         
     Returns:
         str: 执行日志文件路径
@@ -242,9 +423,9 @@ def save_execution_log(stats, project_dir, backup_dir=None, stubbed_dir=None):
     print(f"开始保存执行日志，项目目录: {project_dir}")
     logging.info(f"开始保存执行日志，项目目录: {project_dir}")
     
-    # 创建带时间戳的日志目录
+    # 与运行日志 yamlweave.log 放在同一个带时间戳的日志目录中
     timestamp = datetime.now().strftime('%Y%m%d_%H%M%S')
-    log_dir = os.path.join(get_app_root(), f'logs_{timestamp}')
+    log_dir = LOGS_DIR
     os.makedirs(log_dir, exist_ok=True)
     
     # 创建带时间戳的执行日志文件
@@ -261,6 +442,13 @@ def save_execution_log(stats, project_dir, backup_dir=None, stubbed_dir=None):
         "backup_directory": backup_dir,
         "stubbed_directory": stubbed_dir
     }
+    if timings:
+        execution_info["timings"] = timings
+    if memory:
+        execution_info["memory"] = memory
+    if profiler is not None:
+        profile_files = profiler.write(os.path.splitext(log_file_path)[0])
+        execution_info["profile"] = dict(profile_files, mode=profiler.mode)
     
     # 格式化结果信息
     result_lines = []
@@ -298,6 +486,28 @@ def save_execution_log(stats, project_dir, backup_dir=None, stubbed_dir=None):
             stub_per_file = inserted / updated
             result_lines.append(f"平均每文件桩点: {stub_per_file:.1f}")
     
+    if timings:
+        try:
+            from ..core.timing import format_timings
+        except ImportError:
+            from code.core.timing import format_timings
+        result_lines.append("\n----- 阶段耗时 -----")
+        result_lines.extend(format_timings(timings))
+    
+    if memory:
+        try:
+            from ..core.memprofile import format_memory
+        except ImportError:
+            from code.core.memprofile import format_memory
+        result_lines.append("\n----- 内存分析 -----")
+        result_lines.extend(format_memory(memory))
+    
+    if profiler is not None:
+        result_lines.append("\n----- 性能分析 -----")
+        result_lines.append(f"模式: {profiler.mode}")
+        for kind, path in profile_files.items():
+            result_lines.append(f"{kind}: {path}")
+    
     result_lines.append("=====================")
     
     # 写入执行日志文件
@@ -313,6 +523,7 @@ def save_execution_log(stats, project_dir, backup_dir=None, stubbed_dir=None):
         
         print(f"执行日志已成功保存: {log_file_path}")
         logging.info(f"执行日志已成功保存: {log_file_path}")
+        _record_execution_log(log_file_path, execution_info)
         return log_file_path
     
     except Exception as e:
@@ -333,6 +544,7 @@ def save_execution_log(stats, project_dir, backup_dir=None, stubbed_dir=None):
             
             print(f"执行日志已保存到临时目录: {temp_log_path}")
             logging.info(f"执行日志已保存到临时目录: {temp_log_path}")
+            _record_execution_log(temp_log_path, execution_info)
             return temp_log_path
         
         except Exception as inner_e:
@@ -341,10 +553,87 @@ def save_execution_log(stats, project_dir, backup_dir=None, stubbed_dir=None):
             logging.error(error_msg)
             return None
 
-def get_execution_logs():
+# 本进程的执行日志目录，导入检查成功后复用
+_catalog = None
+_catalog_lock = threading.Lock()
+
+def _run_catalog():
+    """
+    返回执行日志目录；SQLite不可用时返回None
+    
+    每个进程只创建一次并检查一次是否已导入已有的执行日志，
+    不可用时下次调用再重试。
+    """
+    global _catalog
+    if _catalog is not None:
+        return _catalog
+    with _catalog_lock:
+        if _catalog is not None:
+            return _catalog
+        try:
+            try:
+                from .run_catalog import RunCatalog
+            except ImportError:
+                from code.utils.run_catalog import RunCatalog
+            catalog = RunCatalog()
+            if catalog.ensure_imported(_scan_execution_logs):
+                _catalog = catalog
+            return _catalog
+        except Exception as e:
+            logging.warning(f"执行日志目录不可用，改为扫描日志目录: {str(e)}")
+            return None
+
+def _record_execution_log(log_path, execution_info):
+    """将新写出的执行日志记入执行日志目录"""
+    catalog = _run_catalog()
+    if catalog is not None:
+        catalog.add(log_path, execution_info)
+
+def get_execution_logs(limit=None, offset=0, project_dir=None):
     """
     获取执行日志历史记录
     
+    从执行日志目录中查询；目录不可用时扫描各日志目录。
+    
+    Args:
+        limit: 最多返回的记录数，None表示全部
+        offset: 跳过的最新记录数
+        project_dir: 只返回该项目目录的记录
+    
+    Returns:
+        list: 执行日志文件列表，按时间降序排序
+    """
+    catalog = _run_catalog()
+    if catalog is not None:
+        records = catalog.runs(limit, offset, project_dir)
+        if records is not None:
+            return records
+    log_files = _scan_execution_logs()
+    if project_dir is not None:
+        log_files = [log for log in log_files
+                     if log.get("execution_info", {}).get("project_directory") == project_dir]
+    return log_files[offset:] if limit is None else log_files[offset:offset + limit]
+
+def get_execution_log_projects():
+    """
+    获取执行日志中记录过的项目目录
+    
+    Returns:
+        list: 项目目录列表，按名称排序
+    """
+    catalog = _run_catalog()
+    projects = catalog.projects() if catalog is not None else None
+    if projects is None:
+        projects = sorted({log.get("execution_info", {}).get("project_directory")
+                           for log in _scan_execution_logs()} - {None})
+    return projects
+
+def _scan_execution_logs():
+    """
+    扫描各日志目录，逐个解析执行日志
+    
+    只在执行日志目录第一次使用（导入已有日志）或不可用时调用。
+    
     Returns:
         list: 执行日志文件列表，按时间降序排序
     """
@@ -464,7 +753,19 @@ def get_execution_log_stats():
     Returns:
         dict: 执行日志统计信息，包括总日志数、最新日志时间等
     """
-    log_files = get_execution_logs()
+    catalog = _run_catalog()
+    # 先查询最近一次运行，日志已删除的记录在此移除后再读取汇总
+    latest = catalog.runs(limit=1) if catalog is not None else None
+    totals = catalog.totals() if latest is not None else None
+    if totals is not None:
+        return {
+            "total_logs": totals["runs"],
+            "latest_log": latest[0] if latest else None,
+            "total_processed_files": totals["updated_files"],
+            "total_inserted_stubs": totals["inserted_stubs"]
+        }
+    
+    log_files = _scan_execution_logs()
     
     if not log_files:
         return {
@@ -509,7 +810,7 @@ def get_latest_execution_log_content():
     Returns:
         str: 最近执行日志的文本内容，如果没有则返回None
     """
-    logs = get_execution_logs()
+    logs = get_execution_logs(limit=1)
     if not logs:
         return None
     
@@ -534,11 +835,11 @@ def get_execution_log_content(log_index=0):
     Returns:
         tuple: (日志内容, 日志记录)，如果没有则返回(None, None)
     """
-    logs = get_execution_logs()
-    if not logs or log_index >= len(logs):
+    logs = get_execution_logs(limit=1, offset=log_index)
+    if not logs:
         return None, None
     
-    log_record = logs[log_index]
+    log_record = logs[0]
     log_path = log_record.get("file_path")
     
     try:
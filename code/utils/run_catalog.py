@@ -0,0 +1,256 @@
+"""
+执行日志目录模块
+用SQLite记录每次运行的执行日志，供历史记录、统计和最近一次运行的查询使用
+
+``save_execution_log`` 写出执行日志后向目录追加一条记录（日志路径、项目目录、统计字段和完整的JSON数据），
+查询只访问目录，不再遍历各 ``logs_<时间戳>`` 目录、逐个解析执行日志：
+
+- 按时间倒序分页、按项目筛选的历史记录走 ``(finished_at)`` / ``(project_dir, finished_at)`` 索引
+- 累计统计保存在由触发器维护的汇总行中，读取为O(1)
+
+目录第一次打开时导入已有的执行日志（由调用方提供扫描函数），之后不再扫描。
+查询运行记录时检查返回的每条记录的日志文件，已被删除的记录从目录中移除
+（汇总行由触发器同步扣减），历史记录与最近一次运行不会指向不存在的日志。
+"""
+
+import json
+import os
+import sqlite3
+import threading
+import time
+from typing import Any, Callable, Dict, Iterable, List, Optional
+
+try:
+    from .logger import get_logger, get_app_root
+except Exception:
+    from code.utils.logger import get_logger, get_app_root
+
+logger = get_logger(__name__)
+
+# 默认目录文件，与执行日志目录 execution_logs 放在一起
+DEFAULT_CATALOG_PATH = os.path.join(get_app_root(), "execution_logs", "catalog.db")
+
+_SCHEMA = """
+CREATE TABLE IF NOT EXISTS runs (
+    id INTEGER PRIMARY KEY AUTOINCREMENT,
+    log_path TEXT NOT NULL UNIQUE,
+    timestamp TEXT,
+    finished_at REAL NOT NULL,
+    project_dir TEXT,
+    scanned_files INTEGER NOT NULL DEFAULT 0,
+    updated_files INTEGER NOT NULL DEFAULT 0,
+    inserted_stubs INTEGER NOT NULL DEFAULT 0,
+    failed_files INTEGER NOT NULL DEFAULT 0,
+    missing_stubs INTEGER NOT NULL DEFAULT 0,
+    wall_seconds REAL,
+    info TEXT NOT NULL
+);
+CREATE INDEX IF NOT EXISTS runs_finished ON runs (finished_at);
+CREATE INDEX IF NOT EXISTS runs_project ON runs (project_dir, finished_at);
+CREATE TABLE IF NOT EXISTS totals (
+    id INTEGER PRIMARY KEY CHECK (id = 1),
+    runs INTEGER NOT NULL,
+    updated_files INTEGER NOT NULL,
+    inserted_stubs INTEGER NOT NULL
+);
+INSERT OR IGNORE INTO totals VALUES (1, 0, 0, 0);
+CREATE TRIGGER IF NOT EXISTS runs_added AFTER INSERT ON runs BEGIN
+    UPDATE totals SET runs = runs + 1, updated_files = updated_files + NEW.updated_files,
+                      inserted_stubs = inserted_stubs + NEW.inserted_stubs WHERE id = 1;
+END;
+CREATE TRIGGER IF NOT EXISTS runs_removed AFTER DELETE ON runs BEGIN
+    UPDATE totals SET runs = runs - 1, updated_files = updated_files - OLD.updated_files,
+                      inserted_stubs = inserted_stubs - OLD.inserted_stubs WHERE id = 1;
+END;
+CREATE TABLE IF NOT EXISTS meta (key TEXT PRIMARY KEY, value TEXT);
+"""
+
+_COLUMNS = "log_path, finished_at, info"
+
+# 已确认存在表结构的目录文件，同一进程内不再重复执行建表语句
+_initialized = set()
+_init_lock = threading.Lock()
+
+
+def _int(value) -> int:
+    """统计值可能来自旧版本或手工编辑的日志，非数字时按0计"""
+    try:
+        return int(value or 0)
+    except (TypeError, ValueError):
+        return 0
+
+
+class RunCatalog:
+    """
+    执行日志目录
+
+    每个方法使用独立的短连接，可在界面线程、处理线程和多个进程中同时使用；
+    数据库错误记录日志后返回空结果或False，调用方据此回退到扫描日志目录。
+    """
+
+    def __init__(self, path: Optional[str] = None):
+        self.path = path or DEFAULT_CATALOG_PATH
+
+    def _connect(self) -> sqlite3.Connection:
+        os.makedirs(os.path.dirname(os.path.abspath(self.path)), exist_ok=True)
+        conn = sqlite3.connect(self.path, timeout=10)
+        key = os.path.abspath(self.path)
+        if key not in _initialized:
+            with _init_lock:
+                with conn:
+                    conn.executescript(_SCHEMA)
+                _initialized.add(key)
+        return conn
+
+    def add(self, log_path: str, execution_info: Dict[str, Any], finished_at: Optional[float] = None) -> bool:
+        """记录一次运行；同一日志路径只记录一次"""
+        return self.add_many([(log_path, execution_info, finished_at or time.time())]) >= 0
+
+    def add_many(self, entries: Iterable) -> int:
+        """
+        批量记录运行，``entries`` 的每项为 ``(日志路径, 执行信息, 结束时间)``
+
+        Returns:
+            int: 新增的记录数，出错时返回-1
+        """
+        rows = []
+        for log_path, info, finished_at in entries:
+            info = info or {}
+            stats = info.get("stats") or {}
+            timings = info.get("timings") or {}
+            rows.append((os.path.abspath(log_path), info.get("timestamp"), finished_at,
+                         info.get("project_directory"),
+                         _int(stats.get("scanned_files")), _int(stats.get("updated_files")),
+                         _int(stats.get("inserted_stubs")), _int(stats.get("failed_files")),
+                         _int(stats.get("missing_stubs")), timings.get("wall_seconds"),
+                         json.dumps(info, ensure_ascii=False)))
+        try:
+            conn = self._connect()
+            try:
+                with conn:
+                    count = "SELECT runs FROM totals WHERE id = 1"
+                    before = conn.execute(count).fetchone()[0]
+                    conn.executemany(
+                        "INSERT OR IGNORE INTO runs (log_path, timestamp, finished_at, project_dir, scanned_files,"
+                        " updated_files, inserted_stubs, failed_files, missing_stubs, wall_seconds, info)"
+                        " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)", rows)
+                    return conn.execute(count).fetchone()[0] - before
+            finally:
+                conn.close()
+        except sqlite3.Error as e:
+            logger.warning(f"记录执行日志目录失败: {self.path}: {e}")
+            return -1
+
+    def ensure_imported(self, scan: Callable[[], List[Dict[str, Any]]]) -> bool:
+        """
+        目录第一次使用时导入已有的执行日志
+
+        Args:
+            scan: 扫描日志目录的函数，返回 :func:`logger.get_execution_logs` 格式的记录列表
+
+        Returns:
+            bool: 目录是否可用
+        """
+        try:
+            conn = self._connect()
+            try:
+                if conn.execute("SELECT 1 FROM meta WHERE key = 'imported'").fetchone():
+                    return True
+            finally:
+                conn.close()
+        except sqlite3.Error as e:
+            logger.warning(f"无法打开执行日志目录: {self.path}: {e}")
+            return False
+        records = scan()
+        added = self.add_many((record["file_path"], record.get("execution_info"), record["modified_time"])
+                              for record in records)
+        if added < 0:
+            return False
+        try:
+            conn = self._connect()
+            try:
+                with conn:
+                    conn.execute("INSERT OR REPLACE INTO meta VALUES ('imported', ?)", (str(time.time()),))
+            finally:
+                conn.close()
+        except sqlite3.Error as e:
+            logger.warning(f"记录执行日志目录导入状态失败: {e}")
+        logger.info(f"已将 {added} 个执行日志导入目录: {self.path}")
+        return True
+
+    @staticmethod
+    def _record(row) -> Dict[str, Any]:
+        """生成与扫描日志目录时相同格式的记录"""
+        log_path, finished_at, info = row
+        try:
+            execution_info = json.loads(info)
+        except ValueError:
+            execution_info = {}
+        return {
+            "file_path": log_path,
+            "file_name": os.path.basename(log_path),
+            "modified_time": finished_at,
+            "modified_time_str": time.strftime("%Y-%m-%d %H:%M:%S", time.localtime(finished_at)),
+            "execution_info": execution_info,
+        }
+
+    def runs(self, limit: Optional[int] = None, offset: int = 0,
+             project_dir: Optional[str] = None) -> Optional[List[Dict[str, Any]]]:
+        """
+        按时间倒序返回运行记录
+
+        日志文件已不存在的记录从目录中移除后重新查询，返回的记录数仍满足 ``limit``。
+
+        Returns:
+            Optional[List[Dict[str, Any]]]: 记录列表，出错时返回None
+        """
+        sql = f"SELECT {_COLUMNS} FROM runs"
+        params: List[Any] = []
+        if project_dir is not None:
+            sql += " WHERE project_dir = ?"
+            params.append(project_dir)
+        sql += " ORDER BY finished_at DESC, id DESC LIMIT ? OFFSET ?"
+        params.extend([-1 if limit is None else limit, offset])
+        try:
+            conn = self._connect()
+            try:
+                while True:
+                    rows = conn.execute(sql, params).fetchall()
+                    stale = [(row[0],) for row in rows if not os.path.exists(row[0])]
+                    if not stale:
+                        return [self._record(row) for row in rows]
+                    with conn:
+                        conn.executemany("DELETE FROM runs WHERE log_path = ?", stale)
+                    logger.info(f"已从执行日志目录移除 {len(stale)} 条日志文件不存在的记录")
+            finally:
+                conn.close()
+        except sqlite3.Error as e:
+            logger.warning(f"查询执行日志目录失败: {e}")
+            return None
+
+    def totals(self) -> Optional[Dict[str, int]]:
+        """累计运行次数、更新文件数与插入桩点数；出错时返回None"""
+        try:
+            conn = self._connect()
+            try:
+                runs, updated, inserted = conn.execute(
+                    "SELECT runs, updated_files, inserted_stubs FROM totals WHERE id = 1").fetchone()
+            finally:
+                conn.close()
+        except (sqlite3.Error, TypeError) as e:
+            logger.warning(f"查询执行日志统计失败: {e}")
+            return None
+        return {"runs": runs, "updated_files": updated, "inserted_stubs": inserted}
+
+    def projects(self) -> Optional[List[str]]:
+        """记录过的项目目录；出错时返回None"""
+        try:
+            conn = self._connect()
+            try:
+                return [row[0] for row in conn.execute(
+                    "SELECT DISTINCT project_dir FROM runs WHERE project_dir IS NOT NULL ORDER BY project_dir")]
+            finally:
+                conn.close()
+        except sqlite3.Error as e:
+            logger.warning(f"查询执行日志目录失败: {e}")
+            return None